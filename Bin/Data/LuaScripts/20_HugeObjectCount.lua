@@ -14,6 +14,7 @@ local yaw = 0.0
 local pitch = 0.0
 local animate = false
 local useGroups = false
+local packedCulling = false
 
 function Start()
     -- Execute the common startup for samples
@@ -42,7 +43,8 @@ function CreateScene()
 
     -- Create the Octree component to the scene so that drawable objects can be rendered. Use default volume
     -- (-1000, -1000, -1000) to (1000, 1000, 1000)
-    scene_:CreateComponent("Octree")
+    local octree = scene_:CreateComponent("Octree")
+    octree.packedCulling = packedCulling
 
     -- Create a Zone for ambient light & fog control
     local zoneNode = scene_:CreateChild("Zone")
@@ -114,7 +116,8 @@ function CreateInstructions()
     local instructionText = ui.root:CreateChild("Text")
     instructionText:SetText("Use WASD keys and mouse to move\n"..
         "Space to toggle animation\n"..
-        "G to toggle object group optimization")
+        "G to toggle object group optimization\n"..
+        "P to toggle packed octree culling")
     instructionText:SetFont(cache:GetResource("Font", "Fonts/Anonymous Pro.ttf"), 15)
     -- The text has multiple rows. Center them in relation to each other
     instructionText.textAlignment = HA_CENTER
@@ -195,6 +198,12 @@ function HandleUpdate(eventType, eventData)
         CreateScene()
     end
 
+    -- Toggle testing the objects' bounding boxes four at a time during octree culling
+    if input:GetKeyPress(KEY_P) then
+        packedCulling = not packedCulling
+        scene_:GetComponent("Octree").packedCulling = packedCulling
+    end
+
     -- Move the camera, scale movement with time step
     MoveCamera(timeStep)
     
@@ -14,6 +14,7 @@ float yaw = 0.0f;
 float pitch = 0.0f;
 bool animate = false;
 bool useGroups = false;
+bool packedCulling = false;
 
 void Start()
 {
@@ -45,7 +46,8 @@ void CreateScene()
 
     // Create the Octree component to the scene so that drawable objects can be rendered. Use default volume
     // (-1000, -1000, -1000) to (1000, 1000, 1000)
-    scene_.CreateComponent("Octree");
+    Octree@ octree = scene_.CreateComponent("Octree");
+    octree.packedCulling = packedCulling;
 
     // Create a Zone for ambient light & fog control
     Node@ zoneNode = scene_.CreateChild("Zone");
@@ -127,7 +129,8 @@ void CreateInstructions()
     instructionText.text =
         "Use WASD keys and mouse to move\n"
         "Space to toggle animation\n"
-        "G to toggle object group optimization";
+        "G to toggle object group optimization\n"
+        "P to toggle packed octree culling";
     instructionText.SetFont(cache.GetResource("Font", "Fonts/Anonymous Pro.ttf"), 15);
     // The text has multiple rows. Center them in relation to each other
     instructionText.textAlignment = HA_CENTER;
@@ -208,6 +211,13 @@ void HandleUpdate(StringHash eventType, VariantMap& eventData)
         CreateScene();
     }
     
+    // Toggle testing the objects' bounding boxes four at a time during octree culling
+    if (input.keyPress['P'])
+    {
+        packedCulling = !packedCulling;
+        scene_.octree.packedCulling = packedCulling;
+    }
+    
     // Move the camera, scale movement with time step
     MoveCamera(timeStep);
     
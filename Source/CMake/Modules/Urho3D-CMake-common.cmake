@@ -30,6 +30,7 @@ option (URHO3D_ANGELSCRIPT "Enable AngelScript scripting support" TRUE)
 option (URHO3D_LUA "Enable additional Lua scripting support")
 option (URHO3D_LUAJIT "Enable Lua scripting support using LuaJIT (check LuaJIT's CMakeLists.txt for more options)")
 option (URHO3D_SSE "Enable SSE instruction set" TRUE)
+cmake_dependent_option (URHO3D_SSE_MATH "Enable SSE code paths in the Math library (SSE only)" FALSE "URHO3D_SSE" FALSE)
 if (CMAKE_PROJECT_NAME STREQUAL Urho3D)
     cmake_dependent_option (URHO3D_LUAJIT_AMALG "Enable LuaJIT amalgamated build (LuaJIT only)" FALSE "URHO3D_LUAJIT" FALSE)
     cmake_dependent_option (URHO3D_SAFE_LUA "Enable Lua C++ wrapper safety checks (Lua scripting only)" FALSE "URHO3D_LUA OR URHO3D_LUAJIT" FALSE)
@@ -93,6 +94,11 @@ if (URHO3D_SSE)
     add_definitions (-DURHO3D_SSE)
 endif ()
 
+# Enable SSE code paths for matrix, quaternion and bounding box operations in the Math library, on x86 and x64 only.
+if (URHO3D_SSE_MATH)
+    add_definitions (-DURHO3D_SSE_MATH)
+endif ()
+
 # Enable structured exception handling and minidumps on MSVC only.
 if (MSVC AND URHO3D_MINIDUMPS)
     add_definitions (-DURHO3D_MINIDUMPS)
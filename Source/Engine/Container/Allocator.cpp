@@ -22,6 +22,7 @@
 
 #include "Precompiled.h"
 #include "Allocator.h"
+#include "Atomic.h"
 
 #include "stdio.h"
 
@@ -30,12 +31,16 @@
 namespace Urho3D
 {
 
+static volatile int numAllocations = 0;
+static volatile bool allocationCounting = false;
+
 AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSize, unsigned capacity)
 {
     if (!capacity)
         capacity = 1;
     
     unsigned char* blockPtr = new unsigned char[sizeof(AllocatorBlock) + capacity * (sizeof(AllocatorNode) + nodeSize)];
+    CountAllocation();
     AllocatorBlock* newBlock = reinterpret_cast<AllocatorBlock*>(blockPtr);
     newBlock->nodeSize_ = nodeSize;
     newBlock->capacity_ = capacity;
@@ -122,4 +127,22 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     allocator->free_ = node;
 }
 
+void CountAllocation()
+{
+    #ifdef URHO3D_PROFILING
+    if (allocationCounting)
+        AtomicIncrement(&numAllocations);
+    #endif
+}
+
+void SetAllocationCounting(bool enable)
+{
+    allocationCounting = enable;
+}
+
+unsigned GetNumAllocations()
+{
+    return (unsigned)numAllocations;
+}
+
 }
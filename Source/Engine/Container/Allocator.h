@@ -62,6 +62,12 @@ URHO3D_API void AllocatorUninitialize(AllocatorBlock* allocator);
 URHO3D_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 URHO3D_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
+/// Count a heap allocation made by the containers or reference counting. Only counted when profiling is enabled and counting has been enabled with SetAllocationCounting().
+URHO3D_API void CountAllocation();
+/// Enable or disable counting the heap allocations. Disabled by default, as counting from all threads contends on one counter. The profiler enables it during frame capture.
+URHO3D_API void SetAllocationCounting(bool enable);
+/// Return number of heap allocations counted so far. Always zero when profiling is disabled.
+URHO3D_API unsigned GetNumAllocations();
 
 /// %Allocator template class. Allocates objects of a specific class.
 template <class T> class Allocator
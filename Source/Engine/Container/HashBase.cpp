@@ -34,6 +34,7 @@ void HashBase::AllocateBuckets(unsigned size, unsigned numBuckets)
         delete[] ptrs_;
     
     HashNodeBase** ptrs = new HashNodeBase*[numBuckets + 2];
+    CountAllocation();
     unsigned* data = reinterpret_cast<unsigned*>(ptrs);
     data[0] = size;
     data[1] = numBuckets;
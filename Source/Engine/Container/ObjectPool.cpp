@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Allocator.h"
+#include "ObjectPool.h"
+
+#include <cassert>
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+ObjectPool::ObjectPool(unsigned objectSize, unsigned slabCapacity) :
+    free_(0),
+    objectSize_(objectSize),
+    stride_(HEADER_SIZE + ((objectSize + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1))),
+    slabCapacity_(slabCapacity ? slabCapacity : 1),
+    numObjects_(0)
+{
+}
+
+ObjectPool::~ObjectPool()
+{
+    for (unsigned i = 0; i < slabMemory_.Size(); ++i)
+        delete[] slabMemory_[i];
+}
+
+void* ObjectPool::Reserve()
+{
+    if (!free_)
+    {
+        // Chain the slots of a new slab in address order, so that objects created in sequence are also adjacent in memory. The
+        // allocation is only guaranteed to be aligned for the largest basic type, which can be less than 16 bytes, so align the slab
+        unsigned char* memory = new unsigned char[slabCapacity_ * stride_ + HEADER_SIZE - 1];
+        CountAllocation();
+        unsigned char* slab = reinterpret_cast<unsigned char*>((reinterpret_cast<size_t>(memory) + HEADER_SIZE - 1) &
+            ~(size_t)(HEADER_SIZE - 1));
+        slabMemory_.Push(memory);
+        slabs_.Push(slab);
+        
+        unsigned char* slot = slab + (slabCapacity_ - 1) * stride_;
+        for (unsigned i = 0; i < slabCapacity_; ++i)
+        {
+            *reinterpret_cast<unsigned*>(slot) = 0;
+            *reinterpret_cast<unsigned char**>(slot + HEADER_SIZE) = free_;
+            free_ = slot;
+            slot -= stride_;
+        }
+    }
+    
+    unsigned char* slot = free_;
+    free_ = *reinterpret_cast<unsigned char**>(slot + HEADER_SIZE);
+    *reinterpret_cast<unsigned*>(slot) = 1;
+    ++numObjects_;
+    
+    return slot + HEADER_SIZE;
+}
+
+void ObjectPool::Attach(RefCounted* object)
+{
+    // The object must start at the reserved memory, which holds when RefCounted is its first base class
+    assert(object && *reinterpret_cast<unsigned*>(reinterpret_cast<unsigned char*>(object) - HEADER_SIZE));
+    
+    object->RefCountPtr()->pool_ = this;
+    AddRef();
+}
+
+void ObjectPool::Free(void* ptr)
+{
+    if (!ptr)
+        return;
+    
+    unsigned char* slot = reinterpret_cast<unsigned char*>(ptr) - HEADER_SIZE;
+    *reinterpret_cast<unsigned*>(slot) = 0;
+    *reinterpret_cast<unsigned char**>(ptr) = free_;
+    free_ = slot;
+    --numObjects_;
+}
+
+}
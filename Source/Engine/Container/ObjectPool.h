@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "RefCounted.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+/// Default number of objects in an object pool slab.
+static const unsigned DEFAULT_POOL_SLAB_CAPACITY = 256;
+
+/// Slab allocator for reference-counted objects of one type. Keeps the objects contiguous in memory, so that they can also be iterated without walking the objects that refer to them. Not thread-safe.
+class URHO3D_API ObjectPool : public RefCounted
+{
+public:
+    /// Construct with object size and number of objects per slab.
+    ObjectPool(unsigned objectSize, unsigned slabCapacity = DEFAULT_POOL_SLAB_CAPACITY);
+    /// Destruct. Free the slabs.
+    ~ObjectPool();
+    
+    /// Reserve memory for an object. The object must be constructed into it and then passed to Attach().
+    void* Reserve();
+    /// Attach a constructed object, so that its memory is returned to the pool when its reference count reaches zero. The pool is kept alive until then.
+    void Attach(RefCounted* object);
+    /// Return an object's memory to the pool. Called by RefCounted after destroying the object.
+    void Free(void* ptr);
+    
+    /// Return object size.
+    unsigned GetObjectSize() const { return objectSize_; }
+    /// Return number of objects per slab.
+    unsigned GetSlabCapacity() const { return slabCapacity_; }
+    /// Return number of slabs.
+    unsigned GetNumSlabs() const { return slabs_.Size(); }
+    /// Return number of live objects.
+    unsigned GetNumObjects() const { return numObjects_; }
+    /// Return the object in a slab slot, or null if the slot is free.
+    void* GetObject(unsigned slab, unsigned index) const
+    {
+        unsigned char* slot = slabs_[slab] + index * stride_;
+        return *reinterpret_cast<unsigned*>(slot) ? slot + HEADER_SIZE : 0;
+    }
+    
+    /// Size of the slot header in front of each object, holding the used flag. Keeps the objects 16-byte aligned.
+    static const unsigned HEADER_SIZE = 16;
+    
+private:
+    /// Prevent copy construction.
+    ObjectPool(const ObjectPool& rhs);
+    /// Prevent assignment.
+    ObjectPool& operator = (const ObjectPool& rhs);
+    
+    /// Slabs, aligned to the header size.
+    PODVector<unsigned char*> slabs_;
+    /// Allocated slab memory, which may start before the aligned slab.
+    PODVector<unsigned char*> slabMemory_;
+    /// First free slot, chained through the object memory.
+    unsigned char* free_;
+    /// Object size.
+    unsigned objectSize_;
+    /// Slot size including the header.
+    unsigned stride_;
+    /// Number of objects per slab.
+    unsigned slabCapacity_;
+    /// Number of live objects.
+    unsigned numObjects_;
+};
+
+}
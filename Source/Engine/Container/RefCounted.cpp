@@ -21,6 +21,8 @@
 //
 
 #include "Precompiled.h"
+#include "Allocator.h"
+#include "ObjectPool.h"
 #include "RefCounted.h"
 
 #include <cassert>
@@ -33,6 +35,7 @@ namespace Urho3D
 RefCounted::RefCounted() :
     refCount_(new RefCount())
 {
+    CountAllocation();
     // Hold a weak ref to self to avoid possible double delete of the refcount
     (refCount_->weakRefs_)++;
 }
@@ -63,7 +66,18 @@ void RefCounted::ReleaseRef()
     assert(refCount_->refs_ > 0);
     (refCount_->refs_)--;
     if (!refCount_->refs_)
-        delete this;
+    {
+        ObjectPool* pool = refCount_->pool_;
+        if (!pool)
+            delete this;
+        else
+        {
+            // Destroy in place and return the memory to the pool. The pool may be released along with its last object
+            this->~RefCounted();
+            pool->Free(this);
+            pool->ReleaseRef();
+        }
+    }
 }
 
 int RefCounted::Refs() const
@@ -27,13 +27,16 @@
 namespace Urho3D
 {
 
+class ObjectPool;
+
 /// Reference count structure.
 struct RefCount
 {
     /// Construct.
     RefCount() :
         refs_(0),
-        weakRefs_(0)
+        weakRefs_(0),
+        pool_(0)
     {
     }
     
@@ -49,6 +52,8 @@ struct RefCount
     int refs_;
     /// Weak reference count.
     int weakRefs_;
+    /// Pool the object was allocated from, or null if allocated with new.
+    ObjectPool* pool_;
 };
 
 /// Base class for intrusively reference-counted objects. These are noncopyable and non-assignable.
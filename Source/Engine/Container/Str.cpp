@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Allocator.h"
 #include "Str.h"
 #include "Swap.h"
 
@@ -405,6 +406,7 @@ void String::Resize(unsigned newLength)
             capacity_ = MIN_CAPACITY;
         
         buffer_ = new char[capacity_];
+        CountAllocation();
     }
     else
     {
@@ -415,6 +417,7 @@ void String::Resize(unsigned newLength)
                 capacity_ += (capacity_ + 1) >> 1;
             
             char* newBuffer = new char[capacity_];
+            CountAllocation();
             // Move the existing data to the new buffer, then delete the old buffer
             if (length_)
                 CopyChars(newBuffer, buffer_, length_);
@@ -436,6 +439,7 @@ void String::Reserve(unsigned newCapacity)
         return;
     
     char* newBuffer = new char[newCapacity];
+    CountAllocation();
     // Move the existing data to the new buffer, then delete the old buffer
     CopyChars(newBuffer, buffer_, length_ + 1);
     if (capacity_)
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Allocator.h"
 #include "VectorBase.h"
 
 #include "DebugNew.h"
@@ -30,6 +31,7 @@ namespace Urho3D
 
 unsigned char* VectorBase::AllocateBuffer(unsigned size)
 {
+    CountAllocation();
     return new unsigned char[size];
 }
 
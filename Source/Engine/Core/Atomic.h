@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Urho3D.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Urho3D
+{
+
+/// Atomically increment an integer. Return the new value.
+inline int AtomicIncrement(volatile int* value)
+{
+    #ifdef _MSC_VER
+    return _InterlockedIncrement((volatile long*)value);
+    #else
+    return __sync_add_and_fetch(value, 1);
+    #endif
+}
+
+/// Atomically decrement an integer. Return the new value.
+inline int AtomicDecrement(volatile int* value)
+{
+    #ifdef _MSC_VER
+    return _InterlockedDecrement((volatile long*)value);
+    #else
+    return __sync_sub_and_fetch(value, 1);
+    #endif
+}
+
+/// Atomically add to an integer. Return the new value.
+inline int AtomicAdd(volatile int* value, int delta)
+{
+    #ifdef _MSC_VER
+    return _InterlockedExchangeAdd((volatile long*)value, delta) + delta;
+    #else
+    return __sync_add_and_fetch(value, delta);
+    #endif
+}
+
+/// Atomically replace an unsigned integer with a new value if it equals the comparand. Return true if replaced.
+inline bool AtomicCompareExchange(volatile unsigned* value, unsigned exchange, unsigned comparand)
+{
+    #ifdef _MSC_VER
+    return (unsigned)_InterlockedCompareExchange((volatile long*)value, (long)exchange, (long)comparand) == comparand;
+    #else
+    return __sync_bool_compare_and_swap(value, comparand, exchange);
+    #endif
+}
+
+/// Atomically replace an integer with a new value if it equals the comparand. Return true if replaced.
+inline bool AtomicCompareExchange(volatile int* value, int exchange, int comparand)
+{
+    return AtomicCompareExchange((volatile unsigned*)value, (unsigned)exchange, (unsigned)comparand);
+}
+
+/// Atomically replace a pointer with a new value if it equals the comparand. Return true if replaced.
+inline bool AtomicCompareExchangePointer(void* volatile* value, void* exchange, void* comparand)
+{
+    #if defined(_MSC_VER) && defined(_WIN64)
+    return (void*)_InterlockedCompareExchange64((volatile __int64*)value, (__int64)exchange, (__int64)comparand) == comparand;
+    #elif defined(_MSC_VER)
+    return (void*)_InterlockedCompareExchange((volatile long*)value, (long)exchange, (long)comparand) == comparand;
+    #else
+    return __sync_bool_compare_and_swap(value, comparand, exchange);
+    #endif
+}
+
+/// Issue a full memory barrier. Reads and writes are not reordered across it by the compiler or the CPU.
+inline void AtomicFence()
+{
+    #ifdef _MSC_VER
+    long barrier = 0;
+    _InterlockedExchange(&barrier, 0);
+    #else
+    __sync_synchronize();
+    #endif
+}
+
+/// Read a value with acquire ordering: reads and writes after it are not moved before it.
+template <class T> inline T AtomicLoadAcquire(const volatile T* value)
+{
+    #if defined(_MSC_VER)
+    T result = *value;
+    #if defined(_M_ARM) || defined(_M_ARM64)
+    AtomicFence();
+    #else
+    _ReadWriteBarrier();
+    #endif
+    return result;
+    #elif defined(__ATOMIC_ACQUIRE)
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+    #else
+    T result = *value;
+    __sync_synchronize();
+    return result;
+    #endif
+}
+
+/// Write a value with release ordering: reads and writes before it are not moved after it.
+template <class T> inline void AtomicStoreRelease(volatile T* value, T newValue)
+{
+    #if defined(_MSC_VER)
+    #if defined(_M_ARM) || defined(_M_ARM64)
+    AtomicFence();
+    #else
+    _ReadWriteBarrier();
+    #endif
+    *value = newValue;
+    #elif defined(__ATOMIC_RELEASE)
+    __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+    #else
+    __sync_synchronize();
+    *value = newValue;
+    #endif
+}
+
+}
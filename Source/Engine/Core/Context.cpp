@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "Context.h"
 
 #include "DebugNew.h"
@@ -50,8 +51,45 @@ void RemoveNamedAttribute(HashMap<ShortStringHash, Vector<AttributeInfo> >& attr
         attributes.Erase(i);
 }
 
+void EventReceiverGroup::EndSendEvent()
+{
+    assert(inSend_ > 0);
+    --inSend_;
+    
+    if (inSend_ == 0 && dirty_)
+    {
+        // Compact the remaining receivers in one pass, keeping their order
+        unsigned numReceivers = 0;
+        for (unsigned i = 0; i < receivers_.Size(); ++i)
+        {
+            if (receivers_[i])
+                receivers_[numReceivers++] = receivers_[i];
+        }
+        receivers_.Resize(numReceivers);
+        dirty_ = false;
+    }
+}
+
+void EventReceiverGroup::Remove(Object* object)
+{
+    if (inSend_ > 0)
+    {
+        PODVector<Object*>::Iterator i = receivers_.Find(object);
+        if (i != receivers_.End())
+        {
+            *i = 0;
+            dirty_ = true;
+        }
+    }
+    else
+        receivers_.Remove(object);
+}
+
 Context::Context() :
-    eventHandler_(0)
+    postedEvents_(0),
+    sendingPostedEvents_(0),
+    eventHandler_(0),
+    numSentEvents_(0)
 {
     #ifdef ANDROID
     // Always reset the random seed on Android, as the Urho3D library might not be unloaded between runs
@@ -72,6 +110,14 @@ Context::~Context()
     subsystems_.Clear();
     factories_.Clear();
     
+    // Delete events that were posted but not sent
+    while (postedEvents_)
+    {
+        TypedEvent* eventData = postedEvents_;
+        postedEvents_ = eventData->postNext_;
+        delete eventData;
+    }
+    
     // Delete allocated event data maps
     for (PODVector<VariantMap*>::Iterator i = eventDataMaps_.Begin(); i != eventDataMaps_.End(); ++i)
         delete *i;
@@ -105,6 +151,12 @@ void Context::RegisterFactory(ObjectFactory* factory, const char* category)
         objectCategories_[category].Push(factory->GetType());
 }
 
+bool Context::SetObjectPooling(ShortStringHash objectType, bool enable, unsigned slabCapacity)
+{
+    HashMap<ShortStringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
+    return i != factories_.End() ? i->second_->SetPooling(enable, slabCapacity) : false;
+}
+
 void Context::RegisterSubsystem(Object* object)
 {
     if (!object)
@@ -156,6 +208,74 @@ VariantMap& Context::GetEventDataMap()
     return ret;
 }
 
+VariantMap& Context::GetTypedEventDataMap()
+{
+    // Use the map the sender would have used, had it sent the event with a map. Handlers get the next nesting level
+    assert(!eventSenders_.Empty());
+    unsigned nestingLevel = eventSenders_.Size() - 1;
+    while (eventDataMaps_.Size() < nestingLevel + 1)
+        eventDataMaps_.Push(new VariantMap());
+    
+    VariantMap& ret = *eventDataMaps_[nestingLevel];
+    ret.Clear();
+    return ret;
+}
+
+
+void Context::PostEvent(Object* sender, TypedEvent* eventData)
+{
+    if (!sender || !eventData)
+    {
+        delete eventData;
+        return;
+    }
+    
+    eventData->postSender_ = sender;
+    
+    // Push to the front of the list. Only the main thread removes events, and it detaches the whole list at once
+    for (;;)
+    {
+        TypedEvent* next = postedEvents_;
+        eventData->postNext_ = next;
+        if (AtomicCompareExchangePointer((void* volatile*)&postedEvents_, eventData, next))
+            break;
+    }
+}
+
+void Context::SendPostedEvents()
+{
+    // If called from an event handler while posted events are being sent, let the outer call continue
+    if (sendingPostedEvents_ || !postedEvents_)
+        return;
+    
+    // Detach the posted events. Events posted from now on are sent on the next call
+    TypedEvent* events;
+    for (;;)
+    {
+        events = postedEvents_;
+        if (AtomicCompareExchangePointer((void* volatile*)&postedEvents_, 0, events))
+            break;
+    }
+    
+    // Reverse into posting order
+    while (events)
+    {
+        TypedEvent* next = events->postNext_;
+        events->postNext_ = sendingPostedEvents_;
+        sendingPostedEvents_ = events;
+        events = next;
+    }
+    
+    // Keep the remaining events reachable for RemoveEventSender while sending, in case senders are destroyed
+    while (sendingPostedEvents_)
+    {
+        TypedEvent* eventData = sendingPostedEvents_;
+        sendingPostedEvents_ = eventData->postNext_;
+        if (eventData->postSender_)
+            eventData->postSender_->SendEvent(*eventData);
+        delete eventData;
+    }
+}
 
 void Context::CopyBaseAttributes(ShortStringHash baseType, ShortStringHash derivedType)
 {
@@ -172,6 +292,12 @@ void Context::CopyBaseAttributes(ShortStringHash baseType, ShortStringHash deriv
     }
 }
 
+ObjectPool* Context::GetObjectPool(ShortStringHash objectType) const
+{
+    HashMap<ShortStringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
+    return i != factories_.End() ? i->second_->GetPool() : 0;
+}
+
 Object* Context::GetSubsystem(ShortStringHash type) const
 {
     HashMap<ShortStringHash, SharedPtr<Object> >::ConstIterator i = subsystems_.Find(type);
@@ -215,23 +341,47 @@ AttributeInfo* Context::GetAttribute(ShortStringHash objectType, const char* nam
 
 void Context::AddEventReceiver(Object* receiver, StringHash eventType)
 {
-    eventReceivers_[eventType].Insert(receiver);
+    SharedPtr<EventReceiverGroup>& group = eventReceivers_[eventType];
+    if (!group)
+        group = new EventReceiverGroup();
+    group->Add(receiver);
 }
 
 void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash eventType)
 {
-    specificEventReceivers_[sender][eventType].Insert(receiver);
+    SharedPtr<EventReceiverGroup>& group = specificEventReceivers_[sender][eventType];
+    if (!group)
+        group = new EventReceiverGroup();
+    group->Add(receiver);
 }
 
 void Context::RemoveEventSender(Object* sender)
 {
-    HashMap<Object*, HashMap<StringHash, HashSet<Object*> > >::Iterator i = specificEventReceivers_.Find(sender);
+    // Posted events can not be sent after the sender is destroyed. Events can be pushed meanwhile to the front of the posted list,
+    // but the links of the events already in it do not change. Load the head with acquire, so that the links and senders of the
+    // events pushed by other threads are visible
+    for (TypedEvent* i = AtomicLoadAcquire(&postedEvents_); i; i = i->postNext_)
+    {
+        if (i->postSender_ == sender)
+            i->postSender_ = 0;
+    }
+    for (TypedEvent* i = sendingPostedEvents_; i; i = i->postNext_)
+    {
+        if (i->postSender_ == sender)
+            i->postSender_ = 0;
+    }
+    
+    HashMap<Object*, HashMap<StringHash, SharedPtr<EventReceiverGroup> > >::Iterator i = specificEventReceivers_.Find(sender);
     if (i != specificEventReceivers_.End())
     {
-        for (HashMap<StringHash, HashSet<Object*> >::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+        for (HashMap<StringHash, SharedPtr<EventReceiverGroup> >::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
         {
-            for (HashSet<Object*>::Iterator k = j->second_.Begin(); k != j->second_.End(); ++k)
-                (*k)->RemoveEventSender(sender);
+            const PODVector<Object*>& receivers = j->second_->receivers_;
+            for (PODVector<Object*>::ConstIterator k = receivers.Begin(); k != receivers.End(); ++k)
+            {
+                if (*k)
+                    (*k)->RemoveEventSender(sender);
+            }
         }
         specificEventReceivers_.Erase(i);
     }
@@ -239,16 +389,16 @@ void Context::RemoveEventSender(Object* sender)
 
 void Context::RemoveEventReceiver(Object* receiver, StringHash eventType)
 {
-    HashSet<Object*>* group = GetEventReceivers(eventType);
+    EventReceiverGroup* group = GetEventReceivers(eventType);
     if (group)
-        group->Erase(receiver);
+        group->Remove(receiver);
 }
 
 void Context::RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType)
 {
-    HashSet<Object*>* group = GetEventReceivers(sender, eventType);
+    EventReceiverGroup* group = GetEventReceivers(sender, eventType);
     if (group)
-        group->Erase(receiver);
+        group->Remove(receiver);
 }
 
 }
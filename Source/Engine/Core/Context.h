@@ -29,6 +29,36 @@
 namespace Urho3D
 {
 
+/// Flat array of the receivers of an event type. Entries of receivers removed during event send are left null, and compacted when the outermost send ends.
+class URHO3D_API EventReceiverGroup : public RefCounted
+{
+public:
+    /// Construct.
+    EventReceiverGroup() :
+        inSend_(0),
+        dirty_(false)
+    {
+    }
+    
+    /// Begin event send. Removals are deferred until the send ends.
+    void BeginSendEvent() { ++inSend_; }
+    /// End event send. Remove the null entries left by receivers removed in the meanwhile.
+    void EndSendEvent();
+    /// Add a receiver. The same receiver must not be added twice.
+    void Add(Object* object) { receivers_.Push(object); }
+    /// Remove a receiver. During event send, leave a null entry in its place.
+    void Remove(Object* object);
+    
+    /// Receivers. May contain null entries during event send.
+    PODVector<Object*> receivers_;
+    
+private:
+    /// Nested event send count.
+    unsigned inSend_;
+    /// Null entries exist flag.
+    bool dirty_;
+};
+
 /// Urho3D execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class URHO3D_API Context : public RefCounted
 {
@@ -46,6 +76,8 @@ public:
     void RegisterFactory(ObjectFactory* factory);
     /// Register a factory for an object type and specify the object category.
     void RegisterFactory(ObjectFactory* factory, const char* category);
+    /// Set whether to allocate the objects of a registered type from a slab pool, which keeps them contiguous in memory. Must be enabled before any objects of the type are created through the factory. Return true if successful.
+    bool SetObjectPooling(ShortStringHash objectType, bool enable, unsigned slabCapacity = DEFAULT_POOL_SLAB_CAPACITY);
     /// Register a subsystem.
     void RegisterSubsystem(Object* subsystem);
     /// Remove a subsystem.
@@ -58,6 +90,10 @@ public:
     void UpdateAttributeDefaultValue(ShortStringHash objectType, const char* name, const Variant& defaultValue);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
+    /// Post an event with typed parameters to be sent later from the main thread. Takes ownership of the event. Safe to call from worker threads.
+    void PostEvent(Object* sender, TypedEvent* eventData);
+    /// Send the posted events in the order they were posted. Called by the Engine at frame points. Must be called from the main thread.
+    void SendPostedEvents();
     
     /// Copy base class attributes to derived class.
     void CopyBaseAttributes(ShortStringHash baseType, ShortStringHash derivedType);
@@ -65,6 +101,8 @@ public:
     template <class T> void RegisterFactory();
     /// Template version of registering an object factory with category.
     template <class T> void RegisterFactory(const char* category);
+    /// Template version of setting object pooling.
+    template <class T> bool SetObjectPooling(bool enable, unsigned slabCapacity = DEFAULT_POOL_SLAB_CAPACITY);
     /// Template version of removing a subsystem.
     template <class T> void RemoveSubsystem();
     /// Template version of registering an object attribute.
@@ -82,12 +120,18 @@ public:
     const HashMap<ShortStringHash, SharedPtr<Object> >& GetSubsystems() const { return subsystems_; }
     /// Return all object factories.
     const HashMap<ShortStringHash, SharedPtr<ObjectFactory> >& GetObjectFactories() const { return factories_; }
+    /// Return the object pool of a type, or null if not pooled.
+    ObjectPool* GetObjectPool(ShortStringHash objectType) const;
     /// Return all object categories.
     const HashMap<String, Vector<ShortStringHash> >& GetObjectCategories() const { return objectCategories_; }
     /// Return active event sender. Null outside event handling.
     Object* GetEventSender() const;
     /// Return active event handler. Set by Object. Null outside event handling.
     EventHandler* GetEventHandler() const { return eventHandler_; }
+    /// Return number of events sent so far.
+    unsigned GetNumSentEvents() const { return numSentEvents_; }
+    /// Return whether there are posted events waiting to be sent.
+    bool HasPostedEvents() const { return postedEvents_ != 0; }
     /// Return object type name from hash, or empty if unknown.
     const String& GetTypeName(ShortStringHash objectType) const;
     /// Return a specific attribute description for an object, or null if not found.
@@ -112,23 +156,23 @@ public:
     }
 
     /// Return event receivers for a sender and event type, or null if they do not exist.
-    HashSet<Object*>* GetEventReceivers(Object* sender, StringHash eventType)
+    EventReceiverGroup* GetEventReceivers(Object* sender, StringHash eventType)
     {
-        HashMap<Object*, HashMap<StringHash, HashSet<Object*> > >::Iterator i = specificEventReceivers_.Find(sender);
+        HashMap<Object*, HashMap<StringHash, SharedPtr<EventReceiverGroup> > >::Iterator i = specificEventReceivers_.Find(sender);
         if (i != specificEventReceivers_.End())
         {
-            HashMap<StringHash, HashSet<Object*> >::Iterator j = i->second_.Find(eventType);
-            return j != i->second_.End() ? &j->second_ : 0;
+            HashMap<StringHash, SharedPtr<EventReceiverGroup> >::Iterator j = i->second_.Find(eventType);
+            return j != i->second_.End() ? j->second_.Get() : 0;
         }
         else
             return 0;
     }
 
     /// Return event receivers for an event type, or null if they do not exist.
-    HashSet<Object*>* GetEventReceivers(StringHash eventType)
+    EventReceiverGroup* GetEventReceivers(StringHash eventType)
     {
-        HashMap<StringHash, HashSet<Object*> >::Iterator i = eventReceivers_.Find(eventType);
-        return i != eventReceivers_.End() ? &i->second_ : 0;
+        HashMap<StringHash, SharedPtr<EventReceiverGroup> >::Iterator i = eventReceivers_.Find(eventType);
+        return i != eventReceivers_.End() ? i->second_.Get() : 0;
     }
 
 private:
@@ -145,9 +189,11 @@ private:
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
     /// Begin event send.
-    void BeginSendEvent(Object* sender) { eventSenders_.Push(sender); }
+    void BeginSendEvent(Object* sender) { eventSenders_.Push(sender); ++numSentEvents_; }
     /// End event send. Clean up event receivers removed in the meanwhile.
     void EndSendEvent() { eventSenders_.Pop(); }
+    /// Return the preallocated map for the event data of the event being sent. Used to convert typed event parameters for handlers that take a map.
+    VariantMap& GetTypedEventDataMap();
 
     /// Object factories.
     HashMap<ShortStringHash, SharedPtr<ObjectFactory> > factories_;
@@ -158,21 +204,28 @@ private:
     /// Network replication attribute descriptions per object type.
     HashMap<ShortStringHash, Vector<AttributeInfo> > networkAttributes_;
     /// Event receivers for non-specific events.
-    HashMap<StringHash, HashSet<Object*> > eventReceivers_;
+    HashMap<StringHash, SharedPtr<EventReceiverGroup> > eventReceivers_;
     /// Event receivers for specific senders' events.
-    HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificEventReceivers_;
+    HashMap<Object*, HashMap<StringHash, SharedPtr<EventReceiverGroup> > > specificEventReceivers_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
     PODVector<VariantMap*> eventDataMaps_;
+    /// Posted events in reverse posting order. Pushed to by any thread.
+    TypedEvent* volatile postedEvents_;
+    /// Posted events being sent by the main thread.
+    TypedEvent* sendingPostedEvents_;
     /// Active event handler. Not stored in a stack for performance reasons; is needed only in esoteric cases.
     EventHandler* eventHandler_;
+    /// Number of events sent.
+    unsigned numSentEvents_;
     /// Object categories.
     HashMap<String, Vector<ShortStringHash> > objectCategories_;
 };
 
 template <class T> void Context::RegisterFactory() { RegisterFactory(new ObjectFactoryImpl<T>(this)); }
 template <class T> void Context::RegisterFactory(const char* category) { RegisterFactory(new ObjectFactoryImpl<T>(this), category); }
+template <class T> bool Context::SetObjectPooling(bool enable, unsigned slabCapacity) { return SetObjectPooling(T::GetTypeStatic(), enable, slabCapacity); }
 template <class T> void Context::RemoveSubsystem() { RemoveSubsystem(T::GetTypeStatic()); }
 template <class T> void Context::RegisterAttribute(const AttributeInfo& attr) { RegisterAttribute(T::GetTypeStatic(), attr); }
 template <class T> void Context::RemoveAttribute(const char* name) { RemoveAttribute(T::GetTypeStatic(), name); }
@@ -63,4 +63,67 @@ EVENT(E_ENDFRAME, EndFrame)
 {
 }
 
+/// Typed parameters of the frame begin event.
+class BeginFrameEvent : public TypedEvent
+{
+    TYPED_EVENT(BeginFrameEvent);
+
+public:
+    /// Construct.
+    BeginFrameEvent(StringHash eventType, unsigned frameNumber = 0, float timeStep = 0.0f) :
+        TypedEvent(eventType),
+        frameNumber_(frameNumber),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const
+    {
+        eventData[BeginFrame::P_FRAMENUMBER] = frameNumber_;
+        eventData[BeginFrame::P_TIMESTEP] = timeStep_;
+    }
+    
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData)
+    {
+        frameNumber_ = GetParameter(eventData, BeginFrame::P_FRAMENUMBER).GetUInt();
+        timeStep_ = GetParameter(eventData, BeginFrame::P_TIMESTEP).GetFloat();
+    }
+    
+    /// Frame number.
+    unsigned frameNumber_;
+    /// Timestep in seconds.
+    float timeStep_;
+};
+
+/// Typed parameters of the update, post-update, render update and post-render update events.
+class UpdateEvent : public TypedEvent
+{
+    TYPED_EVENT(UpdateEvent);
+
+public:
+    /// Construct.
+    UpdateEvent(StringHash eventType, float timeStep = 0.0f) :
+        TypedEvent(eventType),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const
+    {
+        eventData[Update::P_TIMESTEP] = timeStep_;
+    }
+    
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData)
+    {
+        timeStep_ = GetParameter(eventData, Update::P_TIMESTEP).GetFloat();
+    }
+    
+    /// Timestep in seconds.
+    float timeStep_;
+};
+
 }
@@ -28,6 +28,21 @@
 namespace Urho3D
 {
 
+bool ObjectFactory::SetPooling(bool enable, unsigned slabCapacity)
+{
+    if (!enable)
+        pool_.Reset();
+    else if (!pool_)
+    {
+        // Objects created before would be missing from the pool when iterating it
+        if (objectsCreated_)
+            return false;
+        pool_ = new ObjectPool(objectSize_, slabCapacity);
+    }
+    
+    return true;
+}
+
 Object::Object(Context* context) :
     context_(context)
 {
@@ -44,40 +59,47 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
 {
     // Make a copy of the context pointer in case the object is destroyed during event handler invocation
     Context* context = context_;
-    EventHandler* specific = 0;
-    EventHandler* nonSpecific = 0;
+    EventHandler* handler = SelectEventHandler(sender, eventType);
     
-    EventHandler* handler = eventHandlers_.First();
-    while (handler)
+    if (handler)
     {
-        if (handler->GetEventType() == eventType)
-        {
-            if (!handler->GetSender())
-                nonSpecific = handler;
-            else if (handler->GetSender() == sender)
-            {
-                specific = handler;
-                break;
-            }
-        }
-        handler = eventHandlers_.Next(handler);
+        context->SetEventHandler(handler);
+        handler->Invoke(eventData);
+        context->SetEventHandler(0);
     }
+}
+
+void Object::OnEvent(Object* sender, StringHash eventType, TypedEvent& eventData)
+{
+    Context* context = context_;
+    EventHandler* handler = SelectEventHandler(sender, eventType);
+    if (!handler)
+        return;
     
-    // Specific event handlers have priority, so if found, invoke first
-    if (specific)
+    context->SetEventHandler(handler);
+    
+    if (handler->Invoke(eventData))
     {
-        context->SetEventHandler(specific);
-        specific->Invoke(eventData);
-        context->SetEventHandler(0);
-        return;
+        // The handler may have modified the parameters
+        eventData.eventDataMapValid_ = false;
     }
-    
-    if (nonSpecific)
+    else
     {
-        context->SetEventHandler(nonSpecific);
-        nonSpecific->Invoke(eventData);
-        context->SetEventHandler(0);
+        // The handler takes an event data map: build it on first use during this send, or when a typed handler may have
+        // modified the parameters since
+        if (!eventData.eventDataMap_)
+            eventData.eventDataMap_ = &context->GetTypedEventDataMap();
+        if (!eventData.eventDataMapValid_)
+        {
+            eventData.ToVariantMap(*eventData.eventDataMap_);
+            eventData.eventDataMapValid_ = true;
+        }
+        
+        handler->Invoke(*eventData.eventDataMap_);
+        eventData.FromVariantMap(*eventData.eventDataMap_);
     }
+    
+    context->SetEventHandler(0);
 }
 
 void Object::SubscribeToEvent(StringHash eventType, EventHandler* handler)
@@ -94,7 +116,9 @@ void Object::SubscribeToEvent(StringHash eventType, EventHandler* handler)
     
     eventHandlers_.InsertFront(handler);
     
-    context_->AddEventReceiver(this, eventType);
+    // If replacing an old handler, already is an event receiver
+    if (!oldHandler)
+        context_->AddEventReceiver(this, eventType);
 }
 
 void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler* handler)
@@ -115,7 +139,8 @@ void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler
     
     eventHandlers_.InsertFront(handler);
     
-    context_->AddEventReceiver(this, sender, eventType);
+    if (!oldHandler)
+        context_->AddEventReceiver(this, sender, eventType);
 }
 
 void Object::UnsubscribeFromEvent(StringHash eventType)
@@ -220,105 +245,94 @@ void Object::SendEvent(StringHash eventType)
     SendEvent(eventType, noEventData);
 }
 
-void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+template <class T> void Object::DispatchEvent(StringHash eventType, T& eventData)
 {
     // Make a weak pointer to self to check for destruction during event handling
     WeakPtr<Object> self(this);
     Context* context = context_;
-    HashSet<Object*> processed;
+    bool specificReceivers = false;
     
     context->BeginSendEvent(this);
     
-    // Check first the specific event receivers
-    const HashSet<Object*>* group = context->GetEventReceivers(this, eventType);
+    // Check first the specific event receivers. Hold a reference to the group, as it is erased if self is destroyed
+    SharedPtr<EventReceiverGroup> group(context->GetEventReceivers(this, eventType));
     if (group)
     {
-        for (HashSet<Object*>::ConstIterator i = group->Begin(); i != group->End();)
+        group->BeginSendEvent();
+        
+        // Receivers subscribed during the send do not receive this event
+        unsigned numReceivers = group->receivers_.Size();
+        for (unsigned i = 0; i < numReceivers; ++i)
         {
-            HashSet<Object*>::ConstIterator current = i++;
-            Object* receiver = *current;
-            Object* next = 0;
-            if (i != group->End())
-                next = *i;
+            // The entry is null if the receiver was removed during the send
+            Object* receiver = group->receivers_[i];
+            if (!receiver)
+                continue;
             
-            unsigned oldSize = group->Size();
+            specificReceivers = true;
             receiver->OnEvent(this, eventType, eventData);
             
             // If self has been destroyed as a result of event handling, exit
             if (self.Expired())
             {
+                group->EndSendEvent();
                 context->EndSendEvent();
                 return;
             }
-            
-            // If group has changed size during iteration (removed/added subscribers) try to recover
-            /// \todo This is not entirely foolproof, as a subscriber could have been added to make up for the removed one
-            if (group->Size() != oldSize)
-                i = group->Find(next);
-            
-            processed.Insert(receiver);
         }
+        
+        group->EndSendEvent();
     }
     
     // Then the non-specific receivers
     group = context->GetEventReceivers(eventType);
     if (group)
     {
-        if (processed.Empty())
-        {
-            for (HashSet<Object*>::ConstIterator i = group->Begin(); i != group->End();)
-            {
-                HashSet<Object*>::ConstIterator current = i++;
-                Object* receiver = *current;
-                Object* next = 0;
-                if (i != group->End())
-                    next = *i;
-                
-                unsigned oldSize = group->Size();
-                receiver->OnEvent(this, eventType, eventData);
-                
-                if (self.Expired())
-                {
-                    context->EndSendEvent();
-                    return;
-                }
-                
-                if (group->Size() != oldSize)
-                    i = group->Find(next);
-            }
-        }
-        else
+        group->BeginSendEvent();
+        
+        unsigned numReceivers = group->receivers_.Size();
+        for (unsigned i = 0; i < numReceivers; ++i)
         {
+            Object* receiver = group->receivers_[i];
             // If there were specific receivers, check that the event is not sent doubly to them
-            for (HashSet<Object*>::ConstIterator i = group->Begin(); i != group->End();)
+            if (!receiver || (specificReceivers && receiver->FindSpecificEventHandler(this, eventType)))
+                continue;
+            
+            receiver->OnEvent(this, eventType, eventData);
+            
+            if (self.Expired())
             {
-                HashSet<Object*>::ConstIterator current = i++;
-                Object* receiver = *current;
-                Object* next = 0;
-                if (i != group->End())
-                    next = *i;
-                
-                if (!processed.Contains(receiver))
-                {
-                    unsigned oldSize = group->Size();
-                    receiver->OnEvent(this, eventType, eventData);
-                    
-                    if (self.Expired())
-                    {
-                        context->EndSendEvent();
-                        return;
-                    }
-                    
-                    if (group->Size() != oldSize)
-                        i = group->Find(next);
-                }
+                group->EndSendEvent();
+                context->EndSendEvent();
+                return;
             }
         }
+        
+        group->EndSendEvent();
     }
     
     context->EndSendEvent();
 }
 
+void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+{
+    DispatchEvent(eventType, eventData);
+}
+
+void Object::SendEvent(TypedEvent& eventData)
+{
+    // Reset the event data map state, in case the same parameters are sent again
+    eventData.eventDataMap_ = 0;
+    eventData.eventDataMapValid_ = false;
+    
+    DispatchEvent(eventData.GetEventType(), eventData);
+}
+
+void Object::PostEvent(TypedEvent* eventData)
+{
+    context_->PostEvent(this, eventData);
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
@@ -364,6 +378,26 @@ const String& Object::GetCategory() const
     return String::EMPTY;
 }
 
+EventHandler* Object::SelectEventHandler(Object* sender, StringHash eventType) const
+{
+    EventHandler* nonSpecific = 0;
+    
+    EventHandler* handler = eventHandlers_.First();
+    while (handler)
+    {
+        if (handler->GetEventType() == eventType)
+        {
+            if (!handler->GetSender())
+                nonSpecific = handler;
+            else if (handler->GetSender() == sender)
+                return handler;
+        }
+        handler = eventHandlers_.Next(handler);
+    }
+    
+    return nonSpecific;
+}
+
 EventHandler* Object::FindEventHandler(StringHash eventType, EventHandler** previous) const
 {
     EventHandler* handler = eventHandlers_.First();
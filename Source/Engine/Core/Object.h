@@ -23,6 +23,7 @@
 #pragma once
 
 #include "LinkedList.h"
+#include "ObjectPool.h"
 #include "Variant.h"
 
 namespace Urho3D
@@ -30,6 +31,66 @@ namespace Urho3D
 
 class Context;
 class EventHandler;
+class Object;
+
+/// Base class for typed event parameters with a fixed layout. Sending a typed event does not construct an event data map, unless some subscriber uses a handler function that takes one, such as a script event handler. An event type should always be sent and subscribed to with the same typed event class. Subclasses declare their identity with the TYPED_EVENT macro.
+class URHO3D_API TypedEvent
+{
+    friend class Context;
+    friend class Object;
+    
+public:
+    /// Construct with event type.
+    TypedEvent(StringHash eventType) :
+        eventType_(eventType),
+        eventDataMap_(0),
+        eventDataMapValid_(false),
+        postSender_(0),
+        postNext_(0)
+    {
+    }
+    
+    /// Destruct.
+    virtual ~TypedEvent() {}
+    
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const = 0;
+    /// Read the parameters from an event data map. Missing parameters are read as default values.
+    virtual void FromVariantMap(const VariantMap& eventData) = 0;
+    /// Return the typed event class identity. Defined by the TYPED_EVENT macro.
+    virtual StringHash GetTypedEventClass() const = 0;
+    
+    /// Set event type, to send the same parameters as another event.
+    void SetEventType(StringHash eventType) { eventType_ = eventType; }
+    
+    /// Return event type.
+    StringHash GetEventType() const { return eventType_; }
+    
+protected:
+    /// Return a parameter from an event data map, or an empty variant if missing.
+    static const Variant& GetParameter(const VariantMap& eventData, ShortStringHash param)
+    {
+        VariantMap::ConstIterator i = eventData.Find(param);
+        return i != eventData.End() ? i->second_ : Variant::EMPTY;
+    }
+    
+private:
+    /// Event type.
+    StringHash eventType_;
+    /// Event data map for handlers that take one. Null until needed during sending.
+    VariantMap* eventDataMap_;
+    /// Whether the event data map is up to date with the parameters.
+    bool eventDataMapValid_;
+    /// Sender when posted. Null if the sender was destroyed before the event was sent.
+    Object* postSender_;
+    /// Next posted event.
+    TypedEvent* postNext_;
+};
+
+#define TYPED_EVENT(typeName) \
+    public: \
+        virtual Urho3D::StringHash GetTypedEventClass() const { return GetTypedEventClassStatic(); } \
+        static Urho3D::StringHash GetTypedEventClassStatic() { static const Urho3D::StringHash classStatic(#typeName); return classStatic; } \
 
 #define OBJECT(typeName) \
     public: \
@@ -64,6 +125,8 @@ public:
     virtual const String& GetTypeName() const = 0;
     /// Handle event.
     virtual void OnEvent(Object* sender, StringHash eventType, VariantMap& eventData);
+    /// Handle event with typed parameters.
+    virtual void OnEvent(Object* sender, StringHash eventType, TypedEvent& eventData);
     
     /// Subscribe to an event that can be sent by any sender.
     void SubscribeToEvent(StringHash eventType, EventHandler* handler);
@@ -83,6 +146,10 @@ public:
     void SendEvent(StringHash eventType);
     /// Send event with parameters to all subscribers.
     void SendEvent(StringHash eventType, VariantMap& eventData);
+    /// Send event with typed parameters to all subscribers.
+    void SendEvent(TypedEvent& eventData);
+    /// Post an event with typed parameters to be sent from the main thread at the next frame point. Takes ownership of the event, which must have been allocated with new. Safe to call from worker threads.
+    void PostEvent(TypedEvent* eventData);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
     
@@ -110,6 +177,10 @@ protected:
     Context* context_;
     
 private:
+    /// Send event to the subscribers with either an event data map or typed parameters.
+    template <class T> void DispatchEvent(StringHash eventType, T& eventData);
+    /// Return the handler to invoke for an event from a sender. Specific event handlers have priority.
+    EventHandler* SelectEventHandler(Object* sender, StringHash eventType) const;
     /// Find the first event handler with no specific sender.
     EventHandler* FindEventHandler(StringHash eventType, EventHandler** previous = 0) const;
     /// Find the first event handler with specific sender.
@@ -131,13 +202,17 @@ class URHO3D_API ObjectFactory : public RefCounted
 public:
     /// Construct.
     ObjectFactory(Context* context) :
-        context_(context)
+        context_(context),
+        objectSize_(0),
+        objectsCreated_(false)
     {
         assert(context_);
     }
     
     /// Create an object. Implemented in templated subclasses.
     virtual SharedPtr<Object> CreateObject() = 0;
+    /// Set whether to allocate the objects from a slab pool. Enabling fails if the factory has already created objects. Return true if successful.
+    bool SetPooling(bool enable, unsigned slabCapacity = DEFAULT_POOL_SLAB_CAPACITY);
     
     /// Return execution context.
     Context* GetContext() const { return context_; }
@@ -147,6 +222,8 @@ public:
     ShortStringHash GetBaseType() const { return baseType_; }
     /// Return type name of objects created by this factory.
     const String& GetTypeName() const { return typeName_; }
+    /// Return the object pool, or null if not pooled.
+    ObjectPool* GetPool() const { return pool_; }
     
 protected:
     /// Execution context.
@@ -157,6 +234,12 @@ protected:
     ShortStringHash baseType_;
     /// Object type name.
     String typeName_;
+    /// Object pool.
+    SharedPtr<ObjectPool> pool_;
+    /// Object size for the pool.
+    unsigned objectSize_;
+    /// Objects created flag.
+    bool objectsCreated_;
 };
 
 /// Template implementation of the object factory.
@@ -170,10 +253,20 @@ public:
         type_ = T::GetTypeStatic();
         baseType_ = T::GetBaseTypeStatic();
         typeName_ = T::GetTypeNameStatic();
+        objectSize_ = sizeof(T);
     }
     
     /// Create an object of the specific type.
-    virtual SharedPtr<Object>(CreateObject()) { return SharedPtr<Object>(new T(context_)); }
+    virtual SharedPtr<Object>(CreateObject())
+    {
+        objectsCreated_ = true;
+        if (!pool_)
+            return SharedPtr<Object>(new T(context_));
+        
+        T* object = new(pool_->Reserve()) T(context_);
+        pool_->Attach(object);
+        return SharedPtr<Object>(object);
+    }
 };
 
 /// Internal helper class for invoking event handler functions.
@@ -210,6 +303,8 @@ public:
     
     /// Invoke event handler function.
     virtual void Invoke(VariantMap& eventData) = 0;
+    /// Invoke event handler function with typed parameters. Return false if the function takes an event data map instead.
+    virtual bool Invoke(TypedEvent& eventData) { return false; }
     
     /// Return event receiver.
     Object* GetReceiver() const { return receiver_; }
@@ -265,9 +360,57 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Template implementation of the typed event handler invoke helper (stores a function pointer of specific class, taking specific typed parameters.)
+template <class T, class U> class TypedEventHandlerImpl : public EventHandler
+{
+public:
+    typedef void (T::*HandlerFunctionPtr)(StringHash, U&);
+    
+    /// Construct with receiver and function pointers.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function) :
+        EventHandler(receiver),
+        function_(function)
+    {
+        assert(function_);
+    }
+    
+    /// Invoke event handler function with an event data map, for example when the event was sent from script.
+    virtual void Invoke(VariantMap& eventData)
+    {
+        T* receiver = static_cast<T*>(receiver_);
+        U typedEventData(eventType_);
+        typedEventData.FromVariantMap(eventData);
+        (receiver->*function_)(eventType_, typedEventData);
+        // Write back parameters the handler may have modified. The handler may have been destroyed at this point
+        typedEventData.ToVariantMap(eventData);
+    }
+    
+    /// Invoke event handler function with typed parameters. If the event was sent with another typed event class, return false so that the parameters are converted through an event data map instead.
+    virtual bool Invoke(TypedEvent& eventData)
+    {
+        if (eventData.GetTypedEventClass() != U::GetTypedEventClassStatic())
+            return false;
+        
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(eventType_, static_cast<U&>(eventData));
+        return true;
+    }
+    
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+/// Create a typed event handler. The typed event class is deduced from the handler function.
+template <class T, class U> EventHandler* CreateTypedEventHandler(T* receiver, void (T::*function)(StringHash, U&))
+{
+    return new TypedEventHandlerImpl<T, U>(receiver, function);
+}
+
 #define EVENT(eventID, eventName) static const Urho3D::StringHash eventID(#eventName); namespace eventName
 #define PARAM(paramID, paramName) static const Urho3D::ShortStringHash paramID(#paramName)
 #define HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 #define HANDLER_USERDATA(className, function, userData) (new Urho3D::EventHandlerImpl<className>(this, &className::function, userData))
+#define TYPED_HANDLER(className, function) (Urho3D::CreateTypedEventHandler<className>(this, &className::function))
 
 }
@@ -21,8 +21,13 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
+#include "Context.h"
 #include "CoreEvents.h"
+#include "File.h"
+#include "Log.h"
 #include "Profiler.h"
+#include "Serializer.h"
 
 #include <cstdio>
 #include <cstring>
@@ -34,13 +39,74 @@ namespace Urho3D
 
 static const int LINE_MAX_LENGTH = 256;
 static const int NAME_MAX_LENGTH = 30;
+static const unsigned MAX_TIMELINE_EVENTS = 1000000;
+static const unsigned FRAME_CAPTURE_VERSION = 1;
+static const unsigned THREAD_EVENT_CAPACITY = 16384;
+static const unsigned MAX_THREAD_BLOCK_DEPTH = 64;
+
+/// Profiling data of a worker thread.
+struct ProfilerThread
+{
+    /// Construct with thread index.
+    ProfilerThread(unsigned index) :
+        name_("WorkerThread" + String(index)),
+        root_(0, 0),
+        events_(new ProfilerEvent[THREAD_EVENT_CAPACITY]),
+        writeIndex_(0),
+        readIndex_(0),
+        numOpenBlocks_(0)
+    {
+        root_.name_ = name_.CString();
+    }
+    
+    /// Destruct.
+    ~ProfilerThread()
+    {
+        delete[] events_;
+    }
+    
+    /// Thread name.
+    String name_;
+    /// Root of the thread's profiling tree. Accessed only by the main thread.
+    ProfilerBlock root_;
+    /// Ring buffer of completed blocks waiting to be merged by the main thread. Preallocated, so that the worker thread neither locks nor allocates.
+    ProfilerEvent* events_;
+    /// Index of the next completed block. Written only by the worker thread.
+    volatile unsigned writeIndex_;
+    /// Index of the next block to merge. Written only by the main thread.
+    volatile unsigned readIndex_;
+    /// Blocks that have not ended yet. Accessed only by the worker thread.
+    ProfilerEvent openBlocks_[MAX_THREAD_BLOCK_DEPTH];
+    /// Nesting depth of the blocks that have not ended yet, including those too deep to record.
+    unsigned numOpenBlocks_;
+};
+
+/// Append a string with JSON escapes.
+static void AppendJSONString(String& dest, const char* str)
+{
+    dest += '"';
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+            dest += '\\';
+        dest += *str;
+    }
+    dest += '"';
+}
 
 Profiler::Profiler(Context* context) :
     Object(context),
     current_(0),
     root_(0),
     intervalFrames_(0),
-    totalFrames_(0)
+    totalFrames_(0),
+    frameIndex_(0),
+    numCapturedFrames_(0),
+    framesSinceSave_(0),
+    lastNumEvents_(0),
+    lastNumAllocations_(0),
+    frameBudget_(0.0f),
+    timelineCapture_(false)
 {
     root_ = new ProfilerBlock(0, "Root");
     current_ = root_;
@@ -48,8 +114,14 @@ Profiler::Profiler(Context* context) :
 
 Profiler::~Profiler()
 {
+    if (!frames_.Empty())
+        SetAllocationCounting(false);
+    
     delete root_;
     root_ = 0;
+    
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        delete threads_[i];
 }
 
 void Profiler::BeginFrame()
@@ -71,31 +143,362 @@ void Profiler::EndFrame()
             ++totalFrames_;
         root_->EndFrame();
         current_ = root_;
+        
+        for (unsigned i = 0; i < threads_.Size(); ++i)
+        {
+            CollectThreadEvents(threads_[i]);
+            threads_[i]->root_.EndFrame();
+        }
+        
+        if (!frames_.Empty())
+            CaptureFrame();
     }
 }
 
 void Profiler::BeginInterval()
 {
     root_->BeginInterval();
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->root_.BeginInterval();
     intervalFrames_ = 0;
 }
 
+void Profiler::BeginThreadBlock(unsigned threadIndex, const char* name)
+{
+    if (!threadIndex)
+    {
+        BeginBlock(name);
+        return;
+    }
+    if (threadIndex > threads_.Size())
+        return;
+    
+    ProfilerThread* thread = threads_[threadIndex - 1];
+    unsigned depth = thread->numOpenBlocks_++;
+    if (depth >= MAX_THREAD_BLOCK_DEPTH)
+        return;
+    
+    ProfilerEvent& event = thread->openBlocks_[depth];
+    event.name_ = name;
+    event.begin_ = timelineTimer_.GetUSec(false);
+    event.end_ = event.begin_;
+    event.threadIndex_ = threadIndex;
+    event.depth_ = depth;
+}
+
+void Profiler::EndThreadBlock(unsigned threadIndex)
+{
+    if (!threadIndex)
+    {
+        EndBlock();
+        return;
+    }
+    if (threadIndex > threads_.Size())
+        return;
+    
+    ProfilerThread* thread = threads_[threadIndex - 1];
+    if (!thread->numOpenBlocks_)
+        return;
+    unsigned depth = --thread->numOpenBlocks_;
+    if (depth >= MAX_THREAD_BLOCK_DEPTH)
+        return;
+    
+    // If the main thread has not merged the ring buffer in time, drop the block
+    unsigned writeIndex = thread->writeIndex_;
+    if (writeIndex - AtomicLoadAcquire(&thread->readIndex_) >= THREAD_EVENT_CAPACITY)
+        return;
+    
+    ProfilerEvent& event = thread->events_[writeIndex & (THREAD_EVENT_CAPACITY - 1)];
+    event = thread->openBlocks_[depth];
+    event.end_ = timelineTimer_.GetUSec(false);
+    AtomicStoreRelease(&thread->writeIndex_, writeIndex + 1);
+}
+
+void Profiler::SetNumThreads(unsigned numThreads)
+{
+    // The worker threads must not be running yet, as they access the thread data without locking
+    if (!threads_.Empty())
+        return;
+    
+    for (unsigned i = 0; i < numThreads; ++i)
+        threads_.Push(new ProfilerThread(i + 1));
+}
+
+void Profiler::SetTimelineCapture(bool enable)
+{
+    if (enable && !timelineCapture_)
+        timeline_.Clear();
+    
+    timelineCapture_ = enable;
+}
+
+bool Profiler::SaveChromeTrace(Serializer& dest) const
+{
+    String output("{\"traceEvents\":[\n");
+    char line[LINE_MAX_LENGTH];
+    bool success = true;
+    
+    // Name the threads first
+    for (unsigned i = 0; i <= threads_.Size(); ++i)
+    {
+        sprintf(line, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", i);
+        output += String(line);
+        AppendJSONString(output, i ? threads_[i - 1]->root_.name_ : "MainThread");
+        output += "}},\n";
+    }
+    
+    for (unsigned i = 0; i < timeline_.Size(); ++i)
+    {
+        const ProfilerEvent& event = timeline_[i];
+        output += "{\"name\":";
+        AppendJSONString(output, event.name_);
+        sprintf(line, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}%s\n", event.threadIndex_, event.begin_,
+            event.end_ - event.begin_, i < timeline_.Size() - 1 ? "," : "");
+        output += String(line);
+        
+        // Write in parts to avoid building the whole file in memory
+        if (output.Length() >= 65536)
+        {
+            success &= dest.Write(output.CString(), output.Length()) == output.Length();
+            output.Clear();
+        }
+    }
+    
+    // Terminate the metadata list also when there are no events
+    if (timeline_.Empty())
+        output += "{}\n";
+    output += "],\"displayTimeUnit\":\"ms\"}\n";
+    success &= dest.Write(output.CString(), output.Length()) == output.Length();
+    
+    return success;
+}
+
+void Profiler::SetFrameCapture(unsigned numFrames)
+{
+    frames_.Clear();
+    frames_.Resize(numFrames);
+    frameIndex_ = 0;
+    numCapturedFrames_ = 0;
+    framesSinceSave_ = 0;
+    lastNumEvents_ = context_->GetNumSentEvents();
+    
+    // Count the allocations only while capturing, as the counter is shared by all threads
+    SetAllocationCounting(numFrames > 0);
+    lastNumAllocations_ = GetNumAllocations();
+}
+
+void Profiler::SetFrameBudget(float budget, const String& dumpPrefix)
+{
+    frameBudget_ = Max(budget, 0.0f);
+    dumpPrefix_ = dumpPrefix;
+}
+
+bool Profiler::SaveFrameCapture(Serializer& dest) const
+{
+    // Collect the block names to a table, so that each frame only refers to them by index
+    Vector<String> names;
+    HashMap<String, unsigned> nameIndices;
+    for (unsigned i = numCapturedFrames_ - 1; i < numCapturedFrames_; --i)
+    {
+        const PODVector<ProfilerFrameBlock>& blocks = GetCapturedFrame(i)->blocks_;
+        for (unsigned j = 0; j < blocks.Size(); ++j)
+        {
+            String name(blocks[j].name_);
+            if (!nameIndices.Contains(name))
+            {
+                nameIndices[name] = names.Size();
+                names.Push(name);
+            }
+        }
+    }
+    
+    bool success = true;
+    success &= dest.WriteFileID("UFRC");
+    success &= dest.WriteUInt(FRAME_CAPTURE_VERSION);
+    success &= dest.WriteVLE(names.Size());
+    for (unsigned i = 0; i < names.Size(); ++i)
+        success &= dest.WriteString(names[i]);
+    
+    success &= dest.WriteVLE(numCapturedFrames_);
+    for (unsigned i = numCapturedFrames_ - 1; i < numCapturedFrames_; --i)
+    {
+        const ProfilerFrame& frame = *GetCapturedFrame(i);
+        success &= dest.WriteUInt(frame.frameNumber_);
+        success &= dest.WriteUInt((unsigned)frame.frameTime_);
+        success &= dest.WriteUInt(frame.numEvents_);
+        success &= dest.WriteUInt(frame.numAllocations_);
+        success &= dest.WriteVLE(frame.blocks_.Size());
+        
+        // Parent indices are stored plus one so that root level blocks have zero
+        for (unsigned j = 0; j < frame.blocks_.Size(); ++j)
+        {
+            const ProfilerFrameBlock& block = frame.blocks_[j];
+            success &= dest.WriteVLE(nameIndices[String(block.name_)]);
+            success &= dest.WriteVLE(block.parent_ + 1);
+            success &= dest.WriteVLE((unsigned)block.time_);
+            success &= dest.WriteVLE(block.count_);
+        }
+    }
+    
+    return success;
+}
+
+const ProfilerFrame* Profiler::GetCapturedFrame(unsigned index) const
+{
+    if (index >= numCapturedFrames_)
+        return 0;
+    
+    return &frames_[(frameIndex_ + frames_.Size() - 1 - index) % frames_.Size()];
+}
+
+const ProfilerBlock* Profiler::GetThreadRootBlock(unsigned threadIndex) const
+{
+    return threadIndex && threadIndex <= threads_.Size() ? &threads_[threadIndex - 1]->root_ : 0;
+}
+
+void Profiler::CaptureFrame()
+{
+    ProfilerFrame& frame = frames_[frameIndex_];
+    frameIndex_ = (frameIndex_ + 1) % frames_.Size();
+    if (numCapturedFrames_ < frames_.Size())
+        ++numCapturedFrames_;
+    
+    unsigned numEvents = context_->GetNumSentEvents();
+    unsigned numAllocations = GetNumAllocations();
+    frame.frameNumber_ = totalFrames_;
+    frame.numEvents_ = numEvents - lastNumEvents_;
+    frame.numAllocations_ = numAllocations - lastNumAllocations_;
+    lastNumEvents_ = numEvents;
+    lastNumAllocations_ = numAllocations;
+    
+    // The frame time is the time of the main thread's root level blocks, which normally is just the RunFrame block
+    frame.frameTime_ = 0;
+    for (PODVector<ProfilerBlock*>::ConstIterator i = root_->children_.Begin(); i != root_->children_.End(); ++i)
+        frame.frameTime_ += (*i)->frameTime_;
+    
+    // Clearing keeps the capacity, so that a full ring buffer does not allocate
+    frame.blocks_.Clear();
+    CaptureBlocks(root_, M_MAX_UNSIGNED, frame);
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        ProfilerBlock* threadRoot = &threads_[i]->root_;
+        if (!threadRoot->frameCount_)
+            continue;
+        
+        ProfilerFrameBlock block;
+        block.name_ = threadRoot->name_;
+        block.parent_ = M_MAX_UNSIGNED;
+        block.time_ = threadRoot->frameTime_;
+        block.count_ = threadRoot->frameCount_;
+        frame.blocks_.Push(block);
+        CaptureBlocks(threadRoot, frame.blocks_.Size() - 1, frame);
+    }
+    
+    ++framesSinceSave_;
+    if (frameBudget_ > 0.0f && frame.frameTime_ > (long long)(frameBudget_ * 1000.0f) && framesSinceSave_ >= frames_.Size())
+    {
+        framesSinceSave_ = 0;
+        String fileName = dumpPrefix_ + String(frame.frameNumber_) + ".ufc";
+        File file(context_, fileName, FILE_WRITE);
+        if (file.IsOpen() && SaveFrameCapture(file))
+        {
+            LOGWARNING("Frame " + String(frame.frameNumber_) + " took " + String(frame.frameTime_ / 1000.0f) +
+                " ms, saved frame capture to " + fileName);
+        }
+        else
+            LOGERROR("Failed to save frame capture to " + fileName);
+    }
+}
+
+void Profiler::CaptureBlocks(ProfilerBlock* block, unsigned parent, ProfilerFrame& frame)
+{
+    for (PODVector<ProfilerBlock*>::ConstIterator i = block->children_.Begin(); i != block->children_.End(); ++i)
+    {
+        ProfilerBlock* child = *i;
+        if (!child->frameCount_)
+            continue;
+        
+        ProfilerFrameBlock frameBlock;
+        frameBlock.name_ = child->name_;
+        frameBlock.parent_ = parent;
+        frameBlock.time_ = child->frameTime_;
+        frameBlock.count_ = child->frameCount_;
+        frame.blocks_.Push(frameBlock);
+        CaptureBlocks(child, frame.blocks_.Size() - 1, frame);
+    }
+}
+
+void Profiler::AddMainThreadEvent()
+{
+    if (timeline_.Size() >= MAX_TIMELINE_EVENTS)
+        return;
+    
+    ProfilerEvent event;
+    event.name_ = current_->name_;
+    event.end_ = timelineTimer_.GetUSec(false);
+    event.begin_ = event.end_ - current_->timer_.GetUSec(false);
+    event.threadIndex_ = 0;
+    event.depth_ = 0;
+    for (ProfilerBlock* block = current_->parent_; block && block != root_; block = block->parent_)
+        ++event.depth_;
+    timeline_.Push(event);
+}
+
+void Profiler::CollectThreadEvents(ProfilerThread* thread)
+{
+    unsigned readIndex = thread->readIndex_;
+    unsigned writeIndex = AtomicLoadAcquire(&thread->writeIndex_);
+    collectedEvents_.Resize(writeIndex - readIndex);
+    for (unsigned i = 0; i < collectedEvents_.Size(); ++i)
+        collectedEvents_[i] = thread->events_[(readIndex + i) & (THREAD_EVENT_CAPACITY - 1)];
+    AtomicStoreRelease(&thread->readIndex_, writeIndex);
+    
+    // The events are in the order they ended, so children come before their parent. Go through them in reverse order to
+    // visit parents first. A block whose parent has not ended yet is attributed to the closest ended ancestor
+    blockStack_.Clear();
+    for (unsigned i = collectedEvents_.Size() - 1; i < collectedEvents_.Size(); --i)
+    {
+        const ProfilerEvent& event = collectedEvents_[i];
+        long long time = event.end_ - event.begin_;
+        
+        if (blockStack_.Size() > event.depth_)
+            blockStack_.Resize(event.depth_);
+        ProfilerBlock* parent = blockStack_.Empty() ? &thread->root_ : blockStack_.Back();
+        if (!event.depth_)
+            thread->root_.Accumulate(time);
+        
+        ProfilerBlock* block = parent->GetChild(event.name_);
+        block->Accumulate(time);
+        blockStack_.Push(block);
+    }
+    
+    if (timelineCapture_)
+    {
+        unsigned numEvents = Min((int)collectedEvents_.Size(), (int)(MAX_TIMELINE_EVENTS - Min((int)timeline_.Size(),
+            (int)MAX_TIMELINE_EVENTS)));
+        if (numEvents)
+            timeline_.Insert(timeline_.End(), collectedEvents_.Begin(), collectedEvents_.Begin() + numEvents);
+    }
+}
+
 String Profiler::GetData(bool showUnused, bool showTotal, unsigned maxDepth) const
 {
     String output;
     
     if (!showTotal)
-        output += String("Block                            Cnt     Avg      Max     Frame     Total\n\n");
+        output += String("Block                            Cnt     Avg      Max     Frame     Total  Imbal\n\n");
     else
     {
         output += String("Block                                       Last frame                       Whole execution time\n\n");
-        output += String("                                 Cnt     Avg      Max      Total      Cnt      Avg       Max        Total\n\n");
+        output += String("                                 Cnt     Avg      Max      Total      Cnt      Avg       Max        Total  Imbal\n\n");
     }
     
     if (!maxDepth)
         maxDepth = 1;
     
     GetData(root_, output, 0, maxDepth, showUnused, showTotal);
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        GetData(&threads_[i]->root_, output, 0, maxDepth, showUnused, showTotal);
     
     return output;
 }
@@ -121,6 +524,8 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
             indentedName[strlen(indentedName)] = ' ';
             indentedName[NAME_MAX_LENGTH] = 0;
             
+            float imbalance;
+            
             if (!showTotal)
             {
                 float avg = (block->intervalCount_ ? block->intervalTime_ / block->intervalCount_ : 0.0f) / 1000.0f;
@@ -128,8 +533,9 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
                 float frame = block->intervalTime_ / intervalFrames / 1000.0f;
                 float all = block->intervalTime_ / 1000.0f;
         
-                sprintf(line, "%s %5u %8.3f %8.3f %8.3f %9.3f\n", indentedName, Min(block->intervalCount_, 99999),
+                sprintf(line, "%s %5u %8.3f %8.3f %8.3f %9.3f", indentedName, Min(block->intervalCount_, 99999),
                     avg, max, frame, all);
+                imbalance = block->intervalImbalance_;
             }
             else
             {
@@ -141,11 +547,20 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
                 float totalMax = block->totalMaxTime_ / 1000.0f;
                 float totalAll = block->totalTime_ / 1000.0f;
                 
-                sprintf(line, "%s %5u %8.3f %8.3f %9.3f  %7u %9.3f %9.3f %11.3f\n", indentedName, Min(block->frameCount_, 99999),
+                sprintf(line, "%s %5u %8.3f %8.3f %9.3f  %7u %9.3f %9.3f %11.3f", indentedName, Min(block->frameCount_, 99999),
                     avg, max, all, Min(block->totalCount_, 99999), totalAvg, totalMax, totalAll);
+                imbalance = block->totalImbalance_;
             }
             
             output += String(line);
+            
+            // Load imbalance is only recorded for blocks that ran parallel loops
+            if (imbalance > 0.0f)
+            {
+                sprintf(line, " %6.2f", imbalance);
+                output += String(line);
+            }
+            output += "\n";
         }
         
         ++depth;
@@ -28,6 +28,52 @@
 namespace Urho3D
 {
 
+class Serializer;
+struct ProfilerThread;
+
+/// Timed profiling block instance in the timeline.
+struct ProfilerEvent
+{
+    /// Block name.
+    const char* name_;
+    /// Begin time in microseconds since the profiler was created.
+    long long begin_;
+    /// End time in microseconds since the profiler was created.
+    long long end_;
+    /// Thread index. 0 is the main thread.
+    unsigned threadIndex_;
+    /// Nesting depth within the thread.
+    unsigned depth_;
+};
+
+/// Profiling block of a captured frame.
+struct ProfilerFrameBlock
+{
+    /// Block name.
+    const char* name_;
+    /// Index of the parent block within the frame, or M_MAX_UNSIGNED for a root level block.
+    unsigned parent_;
+    /// Time during the frame in microseconds.
+    long long time_;
+    /// Calls during the frame.
+    unsigned count_;
+};
+
+/// Profiling data of a captured frame.
+struct ProfilerFrame
+{
+    /// Frame number.
+    unsigned frameNumber_;
+    /// Frame time in microseconds.
+    long long frameTime_;
+    /// Number of events sent during the frame.
+    unsigned numEvents_;
+    /// Number of heap allocations made by the containers during the frame.
+    unsigned numAllocations_;
+    /// Blocks that were called during the frame. Parents precede their children. Worker thread roots are root level blocks.
+    PODVector<ProfilerFrameBlock> blocks_;
+};
+
 /// Profiling data for one block in the profiling tree.
 class URHO3D_API ProfilerBlock
 {
@@ -38,16 +84,20 @@ public:
         time_(0),
         maxTime_(0),
         count_(0),
+        imbalance_(0.0f),
         parent_(parent),
         frameTime_(0),
         frameMaxTime_(0),
         frameCount_(0),
+        frameImbalance_(0.0f),
         intervalTime_(0),
         intervalMaxTime_(0),
         intervalCount_(0),
+        intervalImbalance_(0.0f),
         totalTime_(0),
         totalMaxTime_(0),
-        totalCount_(0)
+        totalCount_(0),
+        totalImbalance_(0.0f)
     {
     }
     
@@ -77,6 +127,22 @@ public:
         time_ += time;
     }
     
+    /// Add a call with a time measured elsewhere, for example in a worker thread.
+    void Accumulate(long long time)
+    {
+        ++count_;
+        if (time > maxTime_)
+            maxTime_ = time;
+        time_ += time;
+    }
+    
+    /// Record the load imbalance of a parallel loop, as the ratio of the busiest thread's time to the mean. The maximum is kept.
+    void RecordImbalance(float imbalance)
+    {
+        if (imbalance > imbalance_)
+            imbalance_ = imbalance;
+    }
+    
     /// End profiling frame and update interval and total values.
     void EndFrame()
     {
@@ -91,9 +157,15 @@ public:
         if (maxTime_ > totalMaxTime_)
             totalMaxTime_ = maxTime_;
         totalCount_ += count_;
+        frameImbalance_ = imbalance_;
+        if (imbalance_ > intervalImbalance_)
+            intervalImbalance_ = imbalance_;
+        if (imbalance_ > totalImbalance_)
+            totalImbalance_ = imbalance_;
         time_ = 0;
         maxTime_ = 0;
         count_ = 0;
+        imbalance_ = 0.0f;
         
         for (PODVector<ProfilerBlock*>::Iterator i = children_.Begin(); i != children_.End(); ++i)
             (*i)->EndFrame();
@@ -105,6 +177,7 @@ public:
         intervalTime_ = 0;
         intervalMaxTime_ = 0;
         intervalCount_ = 0;
+        intervalImbalance_ = 0.0f;
         
         for (PODVector<ProfilerBlock*>::Iterator i = children_.Begin(); i != children_.End(); ++i)
             (*i)->BeginInterval();
@@ -142,6 +215,8 @@ public:
     long long maxTime_;
     /// Calls on current frame.
     unsigned count_;
+    /// Maximum parallel load imbalance on current frame.
+    float imbalance_;
     /// Parent block.
     ProfilerBlock* parent_;
     /// Child blocks.
@@ -152,18 +227,24 @@ public:
     long long frameMaxTime_;
     /// Calls on the previous frame.
     unsigned frameCount_;
+    /// Maximum parallel load imbalance on the previous frame.
+    float frameImbalance_;
     /// Time during current profiler interval.
     long long intervalTime_;
     /// Maximum time during current profiler interval.
     long long intervalMaxTime_;
     /// Calls during current profiler interval.
     unsigned intervalCount_;
+    /// Maximum parallel load imbalance during current profiler interval.
+    float intervalImbalance_;
     /// Total accumulated time.
     long long totalTime_;
     /// All-time maximum time.
     long long totalMaxTime_;
     /// Total accumulated calls.
     unsigned totalCount_;
+    /// All-time maximum parallel load imbalance.
+    float totalImbalance_;
 };
 
 /// Hierarchical performance profiler subsystem.
@@ -189,11 +270,36 @@ public:
     {
         if (current_ != root_)
         {
+            if (timelineCapture_)
+                AddMainThreadEvent();
             current_->End();
             current_ = current_->parent_;
         }
     }
     
+    /// Begin timing a profiling block in a worker thread. Thread index 0 is the main thread. The data is merged into the thread's own profiling tree at the end of the frame.
+    void BeginThreadBlock(unsigned threadIndex, const char* name);
+    /// End timing the current profiling block in a worker thread.
+    void EndThreadBlock(unsigned threadIndex);
+    /// Set number of worker threads to collect profiling data from. Called by the work queue when it creates the threads.
+    void SetNumThreads(unsigned numThreads);
+    /// Enable or disable capturing the profiling blocks of all threads to the timeline. Enabling clears the previous timeline.
+    void SetTimelineCapture(bool enable);
+    /// Save the captured timeline in the Chrome trace event JSON format. Return true if successful.
+    bool SaveChromeTrace(Serializer& dest) const;
+    /// Set number of most recent frames to keep in the frame capture ring buffer. Zero disables frame capture.
+    void SetFrameCapture(unsigned numFrames);
+    /// Set frame time budget in milliseconds. When a frame exceeds it, the frame capture is saved to a file named with the prefix and frame number, at most once per ring buffer length. Zero disables.
+    void SetFrameBudget(float budget, const String& dumpPrefix = "FrameCapture");
+    /// Save the captured frames in binary format, oldest first. Return true if successful.
+    bool SaveFrameCapture(Serializer& dest) const;
+    
+    /// Record the load imbalance of a parallel loop to the current profiling block.
+    void RecordImbalance(float imbalance)
+    {
+        current_->RecordImbalance(imbalance);
+    }
+    
     /// Begin the profiling frame. Called by HandleBeginFrame().
     void BeginFrame();
     /// End the profiling frame. Called by HandleEndFrame().
@@ -207,10 +313,34 @@ public:
     const ProfilerBlock* GetCurrentBlock() { return current_; }
     /// Return the root profiling block.
     const ProfilerBlock* GetRootBlock() { return root_; }
+    /// Return number of worker threads.
+    unsigned GetNumThreads() const { return threads_.Size(); }
+    /// Return the root profiling block of a worker thread. Thread index 1 is the first worker thread.
+    const ProfilerBlock* GetThreadRootBlock(unsigned threadIndex) const;
+    /// Return whether the timeline is being captured.
+    bool GetTimelineCapture() const { return timelineCapture_; }
+    /// Return the captured timeline events.
+    const PODVector<ProfilerEvent>& GetTimeline() const { return timeline_; }
+    /// Return length of the frame capture ring buffer.
+    unsigned GetFrameCapture() const { return frames_.Size(); }
+    /// Return number of frames captured to the ring buffer.
+    unsigned GetNumCapturedFrames() const { return numCapturedFrames_; }
+    /// Return a captured frame by age. Index 0 is the newest frame. Return null if out of range.
+    const ProfilerFrame* GetCapturedFrame(unsigned index) const;
+    /// Return frame time budget in milliseconds.
+    float GetFrameBudget() const { return frameBudget_; }
     
 private:
     /// Return profiling data as text output for a specified profiling block.
     void GetData(ProfilerBlock* block, String& output, unsigned depth, unsigned maxDepth, bool showUnused, bool showTotal) const;
+    /// Add the ending main thread profiling block to the timeline.
+    void AddMainThreadEvent();
+    /// Merge the completed profiling blocks of a worker thread into its profiling tree and the timeline.
+    void CollectThreadEvents(ProfilerThread* thread);
+    /// Record the ended frame to the frame capture ring buffer, and save the capture if the frame exceeded the budget.
+    void CaptureFrame();
+    /// Record the blocks called during the ended frame to a captured frame.
+    void CaptureBlocks(ProfilerBlock* block, unsigned parent, ProfilerFrame& frame);
     
     /// Current profiling block.
     ProfilerBlock* current_;
@@ -220,6 +350,34 @@ private:
     unsigned intervalFrames_;
     /// Total frames.
     unsigned totalFrames_;
+    /// Worker thread profiling data.
+    PODVector<ProfilerThread*> threads_;
+    /// Timer for timeline timestamps.
+    HiresTimer timelineTimer_;
+    /// Captured timeline events.
+    PODVector<ProfilerEvent> timeline_;
+    /// Worker thread events being merged.
+    PODVector<ProfilerEvent> collectedEvents_;
+    /// Block stack used when merging worker thread events.
+    PODVector<ProfilerBlock*> blockStack_;
+    /// Frame capture ring buffer.
+    Vector<ProfilerFrame> frames_;
+    /// Ring buffer index for the next captured frame.
+    unsigned frameIndex_;
+    /// Number of captured frames in the ring buffer.
+    unsigned numCapturedFrames_;
+    /// Frames captured since the last automatic save.
+    unsigned framesSinceSave_;
+    /// Event count at the end of the previous frame.
+    unsigned lastNumEvents_;
+    /// Allocation count at the end of the previous frame.
+    unsigned lastNumAllocations_;
+    /// Frame time budget in milliseconds.
+    float frameBudget_;
+    /// File name prefix for automatically saved frame captures.
+    String dumpPrefix_;
+    /// Timeline capture flag.
+    bool timelineCapture_;
 };
 
 /// Helper class for automatically beginning and ending a profiling block
@@ -228,28 +386,47 @@ class URHO3D_API AutoProfileBlock
 public:
     /// Construct. Begin a profiling block with the specified name and optional call count.
     AutoProfileBlock(Profiler* profiler, const char* name) :
-        profiler_(profiler)
+        profiler_(profiler),
+        threadIndex_(0)
     {
         if (profiler_)
             profiler_->BeginBlock(name);
     }
     
+    /// Construct. Begin a profiling block with the specified name in a worker thread.
+    AutoProfileBlock(Profiler* profiler, const char* name, unsigned threadIndex) :
+        profiler_(profiler),
+        threadIndex_(threadIndex)
+    {
+        if (profiler_)
+            profiler_->BeginThreadBlock(threadIndex_, name);
+    }
+    
     /// Destruct. End the profiling block.
     ~AutoProfileBlock()
     {
-        if (profiler_)
+        if (!profiler_)
+            return;
+        
+        if (!threadIndex_)
             profiler_->EndBlock();
+        else
+            profiler_->EndThreadBlock(threadIndex_);
     }
     
 private:
     /// Profiler.
     Profiler* profiler_;
+    /// Thread index.
+    unsigned threadIndex_;
 };
 
 #ifdef URHO3D_PROFILING
 #define PROFILE(name) AutoProfileBlock profile_ ## name (GetSubsystem<Profiler>(), #name)
+#define PROFILE_THREAD(name, threadIndex) AutoProfileBlock profile_ ## name (GetSubsystem<Profiler>(), #name, threadIndex)
 #else
 #define PROFILE(name)
+#define PROFILE_THREAD(name, threadIndex)
 #endif
 
 }
@@ -83,12 +83,8 @@ void Time::BeginFrame(float timeStep)
         PROFILE(BeginFrame);
         
         // Frame begin event
-        using namespace BeginFrame;
-        
-        VariantMap& eventData = GetEventDataMap();
-        eventData[P_FRAMENUMBER] = frameNumber_;
-        eventData[P_TIMESTEP] = timeStep_;
-        SendEvent(E_BEGINFRAME, eventData);
+        BeginFrameEvent eventData(E_BEGINFRAME, frameNumber_, timeStep_);
+        SendEvent(eventData);
     }
 }
 
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "CoreEvents.h"
 #include "Log.h"
 #include "ProcessUtils.h"
@@ -29,10 +30,15 @@
 #include "Timer.h"
 #include "WorkQueue.h"
 
+#include "DebugNew.h"
+
 namespace Urho3D
 {
 
 const unsigned MAX_NONTHREADED_WORK_USEC = 1000;
+const unsigned INITIAL_QUEUE_CAPACITY = 256;
+const unsigned PARALLEL_CHUNKS_PER_THREAD = 8;
+const unsigned PARALLEL_MAX_CHUNKS = 0xffff;
 
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
@@ -63,14 +69,353 @@ private:
     unsigned index_;
 };
 
+/// Lock-free work-stealing deque (Chase-Lev.) The owning thread pushes and pops at the bottom, other threads steal from the top.
+class WorkStealingQueue
+{
+public:
+    /// Construct.
+    WorkStealingQueue() :
+        buffer_(new RingBuffer(INITIAL_QUEUE_CAPACITY)),
+        top_(0),
+        bottom_(0)
+    {
+    }
+    
+    /// Destruct.
+    ~WorkStealingQueue()
+    {
+        delete buffer_;
+        for (unsigned i = 0; i < retiredBuffers_.Size(); ++i)
+            delete retiredBuffers_[i];
+    }
+    
+    /// Push an item to the bottom. Only called by the owning thread.
+    void Push(WorkItem* item)
+    {
+        unsigned bottom = bottom_;
+        unsigned top = AtomicLoadAcquire(&top_);
+        RingBuffer* buffer = buffer_;
+        if (bottom - top > buffer->mask_)
+            buffer = Grow(top, bottom);
+        
+        // Publish the item before the new bottom, so that a thief which sees the bottom also sees the item
+        buffer->items_[bottom & buffer->mask_] = item;
+        AtomicStoreRelease(&bottom_, bottom + 1);
+    }
+    
+    /// Pop an item from the bottom. Only called by the owning thread. Return null if empty.
+    WorkItem* Pop()
+    {
+        unsigned bottom = bottom_ - 1;
+        bottom_ = bottom;
+        AtomicFence();
+        unsigned top = top_;
+        
+        if ((int)(bottom - top) < 0)
+        {
+            bottom_ = top;
+            return 0;
+        }
+        
+        RingBuffer* buffer = buffer_;
+        WorkItem* item = buffer->items_[bottom & buffer->mask_];
+        if (bottom != top)
+            return item;
+        
+        // Last item: race against thieves
+        if (!AtomicCompareExchange(&top_, top + 1, top))
+            item = 0;
+        bottom_ = top + 1;
+        return item;
+    }
+    
+    /// Steal an item from the top. Can be called by any thread. Return null if empty or if lost a race to another thread.
+    WorkItem* Steal()
+    {
+        unsigned top = AtomicLoadAcquire(&top_);
+        AtomicFence();
+        unsigned bottom = AtomicLoadAcquire(&bottom_);
+        
+        if ((int)(bottom - top) <= 0)
+            return 0;
+        
+        RingBuffer* buffer = AtomicLoadAcquire(&buffer_);
+        WorkItem* item = buffer->items_[top & buffer->mask_];
+        if (!AtomicCompareExchange(&top_, top + 1, top))
+            return 0;
+        
+        return item;
+    }
+    
+private:
+    /// Power of two sized item ring buffer.
+    struct RingBuffer
+    {
+        /// Construct with capacity.
+        RingBuffer(unsigned capacity) :
+            items_(new WorkItem*[capacity]),
+            mask_(capacity - 1)
+        {
+        }
+        
+        /// Destruct.
+        ~RingBuffer()
+        {
+            delete[] items_;
+        }
+        
+        /// Items.
+        WorkItem** items_;
+        /// Index mask.
+        unsigned mask_;
+    };
+    
+    /// Double the ring buffer size and return it. Stealing threads may still be reading the old buffer, so it is retained until destruction.
+    RingBuffer* Grow(unsigned top, unsigned bottom)
+    {
+        RingBuffer* oldBuffer = buffer_;
+        RingBuffer* newBuffer = new RingBuffer((oldBuffer->mask_ + 1) * 2);
+        for (unsigned i = top; i != bottom; ++i)
+            newBuffer->items_[i & newBuffer->mask_] = oldBuffer->items_[i & oldBuffer->mask_];
+        
+        retiredBuffers_.Push(oldBuffer);
+        AtomicStoreRelease(&buffer_, newBuffer);
+        return newBuffer;
+    }
+    
+    /// Current ring buffer.
+    RingBuffer* volatile buffer_;
+    /// Index of the next item to steal.
+    volatile unsigned top_;
+    /// Index of the next item to push.
+    volatile unsigned bottom_;
+    /// Previous ring buffers.
+    PODVector<RingBuffer*> retiredBuffers_;
+};
+
+/// Per-thread state of a work batch.
+struct BatchSlot
+{
+    /// Construct.
+    BatchSlot() :
+        participant_(new WorkItem()),
+        range_(0),
+        busyTime_(0)
+    {
+    }
+    
+    /// Work item describing the chunk being processed.
+    WorkItem chunkItem_;
+    /// Work item passed to the work functions of descriptors.
+    WorkItem descriptorItem_;
+    /// Work item submitted to run the slot in a worker thread.
+    SharedPtr<WorkItem> participant_;
+    /// Remaining chunk range, packed as begin in the high and end in the low 16 bits.
+    volatile unsigned range_;
+    /// Time spent in the work functions.
+    long long busyTime_;
+};
+
+/// Parallel loop or work descriptor batch. Each thread processes the chunks of its own slot, then steals half of the remaining chunks
+/// from another slot. Batches are pooled in an intrusive free list.
+struct WorkBatch
+{
+    /// Construct.
+    WorkBatch() :
+        workFunction_(0),
+        start_(0),
+        elementSize_(0),
+        numElements_(0),
+        grainSize_(1),
+        activeSlots_(0),
+        firstSlot_(0),
+        aux_(0),
+        nextFree_(0)
+    {
+    }
+    
+    /// Destruct.
+    ~WorkBatch()
+    {
+        for (unsigned i = 0; i < slots_.Size(); ++i)
+            delete slots_[i];
+    }
+    
+    /// Choose the grain size, set up the chunks and distribute them evenly to the slots.
+    void Setup(unsigned numThreads, unsigned grainSize)
+    {
+        unsigned numSlots = numThreads + 1;
+        
+        // Choose the grain size so that each thread gets several chunks to allow balancing, and the chunk indices fit in 16 bits
+        if (!grainSize)
+            grainSize = Max((int)(numElements_ / (numSlots * PARALLEL_CHUNKS_PER_THREAD)), 1);
+        grainSize_ = Max((int)grainSize, (int)((numElements_ + PARALLEL_MAX_CHUNKS - 1) / PARALLEL_MAX_CHUNKS));
+        unsigned numChunks = (numElements_ + grainSize_ - 1) / grainSize_;
+        if (numChunks < numSlots)
+            numSlots = numChunks;
+        activeSlots_ = numSlots;
+        
+        while (slots_.Size() < numSlots)
+            slots_.Push(new BatchSlot());
+        threadUsed_.Resize(numThreads + 1);
+        for (unsigned i = 0; i < threadUsed_.Size(); ++i)
+            threadUsed_[i] = 0;
+        
+        for (unsigned i = 0; i < numSlots; ++i)
+        {
+            BatchSlot* slot = slots_[i];
+            slot->chunkItem_.aux_ = aux_;
+            slot->busyTime_ = 0;
+            slot->range_ = (i * numChunks / numSlots) << 16 | ((i + 1) * numChunks / numSlots);
+        }
+    }
+    
+    /// Process chunks in a slot until no work remains to steal.
+    void Run(unsigned slotIndex, unsigned threadIndex)
+    {
+        BatchSlot* slot = slots_[slotIndex];
+        WorkItem& item = slot->chunkItem_;
+        unsigned chunk;
+        
+        for (;;)
+        {
+            while (TakeChunk(slot, chunk))
+            {
+                #ifdef URHO3D_PROFILING
+                HiresTimer timer;
+                #endif
+                
+                unsigned begin = chunk * grainSize_;
+                unsigned end = begin + grainSize_ < numElements_ ? begin + grainSize_ : numElements_;
+                item.start_ = start_ + begin * elementSize_;
+                item.end_ = start_ + end * elementSize_;
+                if (workFunction_)
+                    workFunction_(&item, threadIndex);
+                else
+                    ExecuteDescriptors(slot, threadIndex);
+                threadUsed_[threadIndex] = 1;
+                
+                #ifdef URHO3D_PROFILING
+                slot->busyTime_ += timer.GetUSec(false);
+                #endif
+            }
+            
+            if (!StealChunks(slotIndex))
+                break;
+        }
+    }
+    
+    /// Execute the work descriptors of the current chunk in a slot.
+    void ExecuteDescriptors(BatchSlot* slot, unsigned threadIndex)
+    {
+        const WorkDescriptor* start = reinterpret_cast<const WorkDescriptor*>(slot->chunkItem_.start_);
+        const WorkDescriptor* end = reinterpret_cast<const WorkDescriptor*>(slot->chunkItem_.end_);
+        WorkItem& item = slot->descriptorItem_;
+        
+        while (start != end)
+        {
+            item.workFunction_ = start->workFunction_;
+            item.start_ = start->start_;
+            item.end_ = start->end_;
+            item.aux_ = start->aux_;
+            if (item.workFunction_)
+                item.workFunction_(&item, threadIndex);
+            ++start;
+        }
+    }
+    
+    /// Take the next chunk from a slot. Return false if the slot is empty.
+    bool TakeChunk(BatchSlot* slot, unsigned& chunk)
+    {
+        for (;;)
+        {
+            unsigned range = slot->range_;
+            unsigned begin = range >> 16;
+            unsigned end = range & 0xffff;
+            if (begin >= end)
+                return false;
+            if (AtomicCompareExchange(&slot->range_, (begin + 1) << 16 | end, range))
+            {
+                chunk = begin;
+                return true;
+            }
+        }
+    }
+    
+    /// Move the upper half of another slot's remaining chunks to an empty slot. Return false if no work remains.
+    bool StealChunks(unsigned slotIndex)
+    {
+        unsigned numSlots = activeSlots_;
+        
+        for (unsigned i = 1; i < numSlots; ++i)
+        {
+            BatchSlot* victim = slots_[(slotIndex + i) % numSlots];
+            for (;;)
+            {
+                unsigned range = victim->range_;
+                unsigned begin = range >> 16;
+                unsigned end = range & 0xffff;
+                if (begin >= end)
+                    break;
+                
+                unsigned split = end - (end - begin + 1) / 2;
+                if (AtomicCompareExchange(&victim->range_, begin << 16 | split, range))
+                {
+                    // Thieves leave an empty slot alone, so the owner can write it directly
+                    slots_[slotIndex]->range_ = split << 16 | end;
+                    return true;
+                }
+            }
+        }
+        
+        return false;
+    }
+    
+    /// Work function, or null to execute work descriptors.
+    void (*workFunction_)(const WorkItem*, unsigned);
+    /// Data start pointer.
+    unsigned char* start_;
+    /// Element size in bytes.
+    unsigned elementSize_;
+    /// Number of elements.
+    unsigned numElements_;
+    /// Elements per chunk.
+    unsigned grainSize_;
+    /// Number of slots in use.
+    unsigned activeSlots_;
+    /// First slot submitted to the work queue. The slots before it are run by the main thread directly.
+    unsigned firstSlot_;
+    /// Auxiliary data pointer.
+    void* aux_;
+    /// Slots.
+    PODVector<BatchSlot*> slots_;
+    /// Flags for the thread indices that processed elements.
+    PODVector<unsigned char> threadUsed_;
+    /// Next batch in the free list.
+    WorkBatch* nextFree_;
+};
+
+/// Run a work batch slot in a worker thread.
+static void BatchWork(const WorkItem* item, unsigned threadIndex)
+{
+    WorkBatch* batch = reinterpret_cast<WorkBatch*>(item->aux_);
+    batch->Run((unsigned)(size_t)item->start_, threadIndex);
+}
+
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    freeBatches_(0),
     shutDown_(false),
-    pausing_(false),
     paused_(false),
     tolerance_(10),
     lastSize_(0)
 {
+    for (unsigned i = 0; i < NUM_PRIORITY_LANES; ++i)
+    {
+        queues_.Push(new WorkStealingQueue());
+        pendingItems_[i] = 0;
+    }
+    
     SubscribeToEvent(E_BEGINFRAME, HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -82,6 +427,11 @@ WorkQueue::~WorkQueue()
     
     for (unsigned i = 0; i < threads_.Size(); ++i)
         threads_[i]->Stop();
+    
+    for (unsigned i = 0; i < queues_.Size(); ++i)
+        delete queues_[i];
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+        delete batches_[i];
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -94,6 +444,17 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
     
+    #ifdef URHO3D_PROFILING
+    // Let the profiler collect the work items executed by the worker threads
+    profiler_ = GetSubsystem<Profiler>();
+    if (profiler_)
+        profiler_->SetNumThreads(numThreads);
+    #endif
+    
+    // Create all queues before any thread starts stealing from them
+    for (unsigned i = 0; i < numThreads * NUM_PRIORITY_LANES; ++i)
+        queues_.Push(new WorkStealingQueue());
+    
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -131,46 +492,31 @@ void WorkQueue::AddWorkItem(SharedPtr<WorkItem> item)
     assert(!workItems_.Contains(item));
     
     // Push to the main thread list to keep item alive
-    // Clear completed flag in case item is reused
     workItems_.Push(item);
-    item->completed_ = false;
-
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.Acquire();
-    
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
-    {
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
-        {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.Insert(i, item);
-                break;
-            }
-        }
-    }
+    QueueItem(item);
     
     if (threads_.Size())
+        Resume();
+}
+
+void WorkQueue::AddDependency(WorkItem* item, WorkItem* dependency)
+{
+    if (!item || !dependency || item == dependency)
     {
-        queueMutex_.Release();
-        paused_ = false;
+        LOGERROR("Null or self work item dependency");
+        return;
     }
+    
+    AtomicIncrement(&item->dependencies_);
+    dependency->dependents_.Push(item);
 }
 
 void WorkQueue::Pause()
 {
     if (!paused_)
     {
-        pausing_ = true;
-        
         queueMutex_.Acquire();
         paused_ = true;
-        
-        pausing_ = false;
     }
 }
 
@@ -178,8 +524,8 @@ void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
         paused_ = false;
+        queueMutex_.Release();
     }
 }
 
@@ -187,96 +533,347 @@ void WorkQueue::Resume()
 void WorkQueue::Complete(unsigned priority)
 {
     if (threads_.Size())
-    {
         Resume();
+    
+    // Take work items also in the main thread until no high-priority items remain, then wait for threaded work to complete
+    while (!IsCompleted(priority))
+    {
+        if (ExecuteMainThreadItem(priority) || threads_.Size())
+            continue;
         
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.Empty())
+        // No worker threads: the remaining items wait for dependencies of lower priority, so execute those regardless of lane
+        WorkItem* item;
+        if (deferredItems_.Size())
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
-                break;
-            }
+            item = deferredItems_.Back();
+            deferredItems_.Pop();
         }
+        else
+            item = GetNextItem(0, NUM_PRIORITY_LANES - 1);
+        if (!item)
+            break;
+        ExecuteItem(item, 0);
+    }
+    
+    for (unsigned i = 0; i < deferredItems_.Size(); ++i)
+        queues_[GetPriorityLane(deferredItems_[i]->priority_)]->Push(deferredItems_[i]);
+    deferredItems_.Clear();
+    
+    // If no work at all remaining, pause worker threads by leaving the mutex locked
+    if (threads_.Size() && !HasPendingWork())
+        Pause();
+    
+    PurgeCompleted(priority);
+}
+
+void WorkQueue::CompleteItem(WorkItem* item)
+{
+    if (!item)
+        return;
+    
+    if (threads_.Size())
+    {
+        Resume();
         
-        // Wait for threaded work to complete
-        while (!IsCompleted(priority))
+        while (!AtomicLoadAcquire(&item->completed_))
+            ExecuteMainThreadItem(item->priority_);
+    }
+    else
+    {
+        // No worker threads: the item's dependencies may have any priority, so execute everything until done
+        while (!item->completed_)
         {
+            WorkItem* next = GetNextItem(0, NUM_PRIORITY_LANES - 1);
+            if (!next)
+                break;
+            ExecuteItem(next, 0);
         }
-        
-        // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
-            Pause();
     }
-    else
+}
+
+void WorkQueue::ParallelFor(void (*workFunction)(const WorkItem*, unsigned), void* start, void* end, unsigned elementSize, void* aux,
+    unsigned grainSize)
+{
+    ParallelReduce(workFunction, 0, start, end, elementSize, aux, grainSize);
+}
+
+void WorkQueue::ParallelReduce(void (*workFunction)(const WorkItem*, unsigned), void (*reduceFunction)(void*, unsigned), void* start,
+    void* end, unsigned elementSize, void* aux, unsigned grainSize)
+{
+    if (!workFunction || !elementSize || end <= start)
+        return;
+    
+    // A parallel loop may be started from the main thread while processing an outer loop, so each loop takes its own batch
+    WorkBatch* batch = AcquireBatch();
+    batch->workFunction_ = workFunction;
+    batch->start_ = (unsigned char*)start;
+    batch->elementSize_ = elementSize;
+    batch->numElements_ = (unsigned)((unsigned char*)end - (unsigned char*)start) / elementSize;
+    batch->aux_ = aux;
+    batch->Setup(threads_.Size(), grainSize);
+    
+    // Submit the other slots for the worker threads, then process the first slot in the main thread
+    StartBatch(batch, 1);
+    batch->Run(0, 0);
+    FinishBatch(batch);
+    
+    if (reduceFunction)
     {
-        // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+        for (unsigned i = 0; i < batch->threadUsed_.Size(); ++i)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            if (batch->threadUsed_[i])
+                reduceFunction(aux, i);
         }
     }
     
-    PurgeCompleted(priority);
+    ReleaseBatch(batch);
+}
+
+WorkBatch* WorkQueue::AddWorkBatch(const WorkDescriptor* descriptors, unsigned count, unsigned grainSize)
+{
+    if (!descriptors || !count)
+        return 0;
+    
+    WorkBatch* batch = AcquireBatch();
+    batch->workFunction_ = 0;
+    batch->start_ = (unsigned char*)descriptors;
+    batch->elementSize_ = sizeof(WorkDescriptor);
+    batch->numElements_ = count;
+    batch->aux_ = 0;
+    batch->Setup(threads_.Size(), grainSize);
+    StartBatch(batch, 0);
+    
+    return batch;
+}
+
+void WorkQueue::CompleteBatch(WorkBatch* batch)
+{
+    if (!batch)
+        return;
+    
+    FinishBatch(batch);
+    ReleaseBatch(batch);
 }
 
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
+    // The lane counters are exact for the highest and lowest priority. Otherwise check the items individually
+    if (priority == M_MAX_UNSIGNED)
+        return AtomicLoadAcquire(&pendingItems_[0]) == 0;
+    if (priority == 0)
+        return !HasPendingWork();
+    
     for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
     {
-        if ((*i)->priority_ >= priority && !(*i)->completed_)
+        if ((*i)->priority_ >= priority && !AtomicLoadAcquire(&(*i)->completed_))
             return false;
     }
     
     return true;
 }
 
+unsigned WorkQueue::GetPriorityLane(unsigned priority)
+{
+    if (priority == M_MAX_UNSIGNED)
+        return 0;
+    else if (priority > 0)
+        return 1;
+    else
+        return NUM_PRIORITY_LANES - 1;
+}
+
 void WorkQueue::ProcessItems(unsigned threadIndex)
 {
-    bool wasActive = false;
-    
     for (;;)
     {
         if (shutDown_)
             return;
         
-        if (pausing_ && !wasActive)
-            Time::Sleep(0);
-        else
+        WorkItem* item = GetNextItem(threadIndex, NUM_PRIORITY_LANES - 1);
+        if (item)
+            ExecuteItem(item, threadIndex);
+        else if (paused_)
         {
+            // Block on the mutex held by the main thread until resumed
             queueMutex_.Acquire();
-            if (!queue_.Empty())
-            {
-                wasActive = true;
-                
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
-            }
-            else
+            queueMutex_.Release();
+        }
+        else
+            Time::Sleep(0);
+    }
+}
+
+void WorkQueue::QueueItem(WorkItem* item)
+{
+    // Clear completed flag in case item is reused. Count the item as pending already if it still waits for dependencies,
+    // so that completion waits for it
+    item->completed_ = false;
+    unsigned lane = GetPriorityLane(item->priority_);
+    AtomicIncrement(&pendingItems_[lane]);
+    
+    // Release the submission reference to the dependency count. If no unfinished dependencies, queue to the main thread's own
+    // queue, from where idle worker threads will steal it. Otherwise the last dependency to complete will queue it
+    if (AtomicDecrement(&item->dependencies_) == 0)
+        queues_[lane]->Push(item);
+}
+
+WorkBatch* WorkQueue::AcquireBatch()
+{
+    WorkBatch* batch = freeBatches_;
+    if (batch)
+        freeBatches_ = batch->nextFree_;
+    else
+    {
+        batch = new WorkBatch();
+        batches_.Push(batch);
+    }
+    
+    batch->nextFree_ = 0;
+    return batch;
+}
+
+void WorkQueue::ReleaseBatch(WorkBatch* batch)
+{
+    batch->nextFree_ = freeBatches_;
+    freeBatches_ = batch;
+}
+
+void WorkQueue::StartBatch(WorkBatch* batch, unsigned firstSlot)
+{
+    // Reuse the slots' own work items so that no allocation or reference counting is needed per submission
+    batch->firstSlot_ = firstSlot;
+    for (unsigned i = firstSlot; i < batch->activeSlots_; ++i)
+    {
+        WorkItem* participant = batch->slots_[i]->participant_;
+        participant->workFunction_ = BatchWork;
+        participant->start_ = (void*)(size_t)i;
+        participant->aux_ = batch;
+        participant->priority_ = M_MAX_UNSIGNED;
+        QueueItem(participant);
+    }
+    
+    if (threads_.Size() && batch->activeSlots_ > firstSlot)
+        Resume();
+}
+
+void WorkQueue::FinishBatch(WorkBatch* batch)
+{
+    unsigned numSlots = batch->activeSlots_;
+    for (unsigned i = batch->firstSlot_; i < numSlots; ++i)
+        CompleteItem(batch->slots_[i]->participant_);
+    
+    if (threads_.Size() && !HasPendingWork())
+        Pause();
+    
+    #ifdef URHO3D_PROFILING
+    // Report the load imbalance as the ratio of the longest busy time to the mean
+    if (numSlots > 1)
+    {
+        Profiler* profiler = GetSubsystem<Profiler>();
+        if (profiler)
+        {
+            long long maxTime = 0;
+            long long totalTime = 0;
+            for (unsigned i = 0; i < numSlots; ++i)
             {
-                wasActive = false;
-                
-                queueMutex_.Release();
-                Time::Sleep(0);
+                long long time = batch->slots_[i]->busyTime_;
+                if (time > maxTime)
+                    maxTime = time;
+                totalTime += time;
             }
+            if (totalTime > 0)
+                profiler->RecordImbalance((float)maxTime * numSlots / (float)totalTime);
         }
     }
+    #endif
+}
+
+WorkItem* WorkQueue::GetNextItem(unsigned threadIndex, unsigned maxLane)
+{
+    unsigned numQueues = threads_.Size() + 1;
+    
+    // Exhaust higher priority lanes first. Take from own queue, then steal starting from the next thread
+    for (unsigned lane = 0; lane <= maxLane; ++lane)
+    {
+        WorkItem* item = queues_[threadIndex * NUM_PRIORITY_LANES + lane]->Pop();
+        if (item)
+            return item;
+        
+        for (unsigned i = 1; i < numQueues; ++i)
+        {
+            unsigned victim = (threadIndex + i) % numQueues;
+            item = queues_[victim * NUM_PRIORITY_LANES + lane]->Steal();
+            if (item)
+                return item;
+        }
+    }
+    
+    return 0;
+}
+
+void WorkQueue::ExecuteItem(WorkItem* item, unsigned threadIndex)
+{
+    unsigned lane = GetPriorityLane(item->priority_);
+    if (item->workFunction_)
+    {
+        #ifdef URHO3D_PROFILING
+        if (profiler_)
+            profiler_->BeginThreadBlock(threadIndex, "WorkItem");
+        #endif
+        
+        item->workFunction_(item, threadIndex);
+        
+        #ifdef URHO3D_PROFILING
+        if (profiler_)
+            profiler_->EndThreadBlock(threadIndex);
+        #endif
+    }
+    
+    // Queue the dependents which have no more unfinished dependencies to this thread's own queues
+    for (unsigned i = 0; i < item->dependents_.Size(); ++i)
+    {
+        WorkItem* dependent = item->dependents_[i];
+        if (AtomicDecrement(&dependent->dependencies_) == 0)
+            queues_[threadIndex * NUM_PRIORITY_LANES + GetPriorityLane(dependent->priority_)]->Push(dependent);
+    }
+    
+    // Reset the dependency state so that the item can be reused. Release the completed flag so that a thread which sees it set
+    // also sees the results of the work function
+    item->dependents_.Clear();
+    item->dependencies_ = 1;
+    AtomicStoreRelease(&item->completed_, true);
+    AtomicDecrement(&pendingItems_[lane]);
+}
+
+bool WorkQueue::ExecuteMainThreadItem(unsigned priority)
+{
+    // With worker threads, only take items from the lanes where every item has at least the specified priority, and leave the
+    // rest to the workers. Otherwise take also from the lane of the priority, and set aside lower priority items
+    unsigned maxLane = GetPriorityLane(priority);
+    if (threads_.Size() && maxLane == 1 && priority > 1)
+        maxLane = 0;
+    
+    WorkItem* item = GetNextItem(0, maxLane);
+    if (!item)
+        return false;
+    
+    if (item->priority_ >= priority)
+        ExecuteItem(item, 0);
+    else
+        deferredItems_.Push(item);
+    
+    return true;
+}
+
+bool WorkQueue::HasPendingWork() const
+{
+    for (unsigned i = 0; i < NUM_PRIORITY_LANES; ++i)
+    {
+        if (pendingItems_[i])
+            return true;
+    }
+    
+    return false;
 }
 
 void WorkQueue::PurgeCompleted(unsigned priority)
@@ -286,7 +883,7 @@ void WorkQueue::PurgeCompleted(unsigned priority)
     // render update, which is not allowed
     for (List<SharedPtr<WorkItem> >::Iterator i = workItems_.Begin(); i != workItems_.End();)
     {
-        if ((*i)->completed_ && (*i)->priority_ >= priority)
+        if (AtomicLoadAcquire(&(*i)->completed_) && (*i)->priority_ >= priority)
         {
             if ((*i)->sendEvent_)
             {
@@ -297,8 +894,8 @@ void WorkQueue::PurgeCompleted(unsigned priority)
                 SendEvent(E_WORKITEMCOMPLETED, eventData);
             }
 
-            // Check if this was a pooled item and set it to usable
-            if ((*i)->pooled_)
+            // Check if this was a pooled item and set it to usable. If it is still referenced from outside, leave it be
+            if ((*i)->pooled_ && (*i)->Refs() == 1)
             {
                 // Reset the values to their defaults. This should 
                 // be safe to do here as the completed event has 
@@ -337,18 +934,18 @@ void WorkQueue::PurgePool()
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    if (threads_.Empty() && HasPendingWork())
     {
         PROFILE(CompleteWorkNonthreaded);
         
         HiresTimer timer;
         
-        while (!queue_.Empty() && timer.GetUSec(false) < MAX_NONTHREADED_WORK_USEC)
+        while (timer.GetUSec(false) < MAX_NONTHREADED_WORK_USEC)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = GetNextItem(0, NUM_PRIORITY_LANES - 1);
+            if (!item)
+                break;
+            ExecuteItem(item, 0);
         }
     }
     
@@ -35,7 +35,13 @@ EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
     PARAM(P_ITEM, Item);                        // WorkItem ptr
 }
 
+class Profiler;
 class WorkerThread;
+class WorkStealingQueue;
+struct WorkBatch;
+
+/// Number of priority lanes. Items with M_MAX_UNSIGNED priority use the first lane, other nonzero priorities the second and zero priority the last.
+static const unsigned NUM_PRIORITY_LANES = 3;
 
 /// Work queue item.
 struct WorkItem : public RefCounted
@@ -45,14 +51,19 @@ struct WorkItem : public RefCounted
 public:
     // Construct
     WorkItem() :
+        workFunction_(0),
+        start_(0),
+        end_(0),
+        aux_(0),
         priority_(0),
         sendEvent_(false),
         completed_(false),
+        dependencies_(1),
         pooled_(false)
     {
     }
     
-    /// Work function. Called with the work item and thread index (0 = main thread) as parameters.
+    /// Work function. Called with the work item and thread index (0 = main thread) as parameters. May be null for an item that only joins its dependencies.
     void (*workFunction_)(const WorkItem*, unsigned);
     /// Data start pointer.
     void* start_;
@@ -68,9 +79,27 @@ public:
     volatile bool completed_;
 
 private:
+    /// Items that wait for this item to complete.
+    PODVector<WorkItem*> dependents_;
+    /// Number of unfinished dependencies, plus one until the item is submitted.
+    volatile int dependencies_;
+    /// Pooled flag.
     bool pooled_;
 };
 
+/// Plain work descriptor for allocation-free batch submission. The work function is called with a work item that has the same data pointers.
+struct WorkDescriptor
+{
+    /// Work function. Called with a work item and thread index (0 = main thread) as parameters.
+    void (*workFunction_)(const WorkItem*, unsigned);
+    /// Data start pointer.
+    void* start_;
+    /// Data end pointer.
+    void* end_;
+    /// Auxiliary data pointer.
+    void* aux_;
+};
+
 /// Work queue subsystem for multithreading.
 class URHO3D_API WorkQueue : public Object
 {
@@ -88,14 +117,36 @@ public:
     void CreateThreads(unsigned numThreads);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
-    /// Add a work item and resume worker threads.
+    /// Add a work item and resume worker threads. If the item has dependencies, it will be queued once they have completed.
     void AddWorkItem(SharedPtr<WorkItem> item);
+    /// Make a work item wait for another item to complete before it is executed. Must be called before either item is submitted.
+    void AddDependency(WorkItem* item, WorkItem* dependency);
     /// Pause worker threads.
     void Pause();
     /// Resume worker threads.
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    /// Finish a submitted work item along with its dependencies. Main thread will also execute work with at least the item's priority. Other work is left running and completed items are not purged.
+    void CompleteItem(WorkItem* item);
+    /// Run a work function over a range of elements in parallel and wait for it to finish. The range is split into chunks of grainSize elements (automatic if zero) which idle threads steal from each other, and the work function is called with a work item describing each chunk. Only call from the main thread.
+    void ParallelFor(void (*workFunction)(const WorkItem*, unsigned), void* start, void* end, unsigned elementSize, void* aux, unsigned grainSize = 0);
+    /// Run a work function over a range of elements in parallel like ParallelFor, then call the reduce function in the main thread for each thread index that processed elements, in ascending order.
+    void ParallelReduce(void (*workFunction)(const WorkItem*, unsigned), void (*reduceFunction)(void*, unsigned), void* start, void* end, unsigned elementSize, void* aux, unsigned grainSize = 0);
+    /// Submit an array of work descriptors with the highest priority, without allocating or reference counting per descriptor. The descriptors are processed in chunks of grainSize (automatic if zero) and must stay valid until the batch is completed with CompleteBatch(), which also returns it to the pool. Only call from the main thread.
+    WorkBatch* AddWorkBatch(const WorkDescriptor* descriptors, unsigned count, unsigned grainSize = 0);
+    /// Finish a submitted work batch and return it to the pool. Main thread will also execute high priority work.
+    void CompleteBatch(WorkBatch* batch);
+    /// Run a work function over an array in parallel and wait for it to finish.
+    template <class T> void ParallelFor(void (*workFunction)(const WorkItem*, unsigned), T* start, T* end, void* aux, unsigned grainSize = 0)
+    {
+        ParallelFor(workFunction, static_cast<void*>(start), static_cast<void*>(end), sizeof(T), aux, grainSize);
+    }
+    /// Run a work function over an array in parallel, then call the reduce function for each thread index that processed elements.
+    template <class T> void ParallelReduce(void (*workFunction)(const WorkItem*, unsigned), void (*reduceFunction)(void*, unsigned), T* start, T* end, void* aux, unsigned grainSize = 0)
+    {
+        ParallelReduce(workFunction, reduceFunction, static_cast<void*>(start), static_cast<void*>(end), sizeof(T), aux, grainSize);
+    }
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
     
@@ -106,9 +157,30 @@ public:
     /// Return the pool tolerance.
     int GetTolerance() const { return tolerance_; }
     
+    /// Return the priority lane used for a work item priority.
+    static unsigned GetPriorityLane(unsigned priority);
+    
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Take a work batch from the pool.
+    WorkBatch* AcquireBatch();
+    /// Return a work batch to the pool.
+    void ReleaseBatch(WorkBatch* batch);
+    /// Queue the work items of a work batch's slots, starting from the specified slot.
+    void StartBatch(WorkBatch* batch, unsigned firstSlot);
+    /// Wait for the queued slots of a work batch to finish and record its load imbalance.
+    void FinishBatch(WorkBatch* batch);
+    /// Count a work item as pending and queue it to the main thread's queue if it has no unfinished dependencies.
+    void QueueItem(WorkItem* item);
+    /// Take a work item from the thread's own queues, or steal one from the other threads. Only lanes up to and including maxLane are considered. Return null if no work found.
+    WorkItem* GetNextItem(unsigned threadIndex, unsigned maxLane);
+    /// Execute a work item, mark it completed and queue the dependent items that became ready.
+    void ExecuteItem(WorkItem* item, unsigned threadIndex);
+    /// Execute one item with at least the specified priority in the main thread while completing work. Return false if none available.
+    bool ExecuteMainThreadItem(unsigned priority);
+    /// Return whether any queued or executing work remains.
+    bool HasPendingWork() const;
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
@@ -122,16 +194,24 @@ private:
     List<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
     List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
-    List<WorkItem*> queue_;
-    /// Worker queue mutex.
+    /// Work-stealing queues, NUM_PRIORITY_LANES per thread with the main thread first. Pointers are guaranteed to be valid (point to workItems.)
+    PODVector<WorkStealingQueue*> queues_;
+    /// Items taken by the main thread that were below the priority it was completing when there are no worker threads. Requeued after completion.
+    PODVector<WorkItem*> deferredItems_;
+    /// All work batches.
+    PODVector<WorkBatch*> batches_;
+    /// First work batch in the free list.
+    WorkBatch* freeBatches_;
+    /// Profiler for worker thread profiling data. Kept alive until the worker threads have stopped.
+    SharedPtr<Profiler> profiler_;
+    /// Number of queued or executing items per priority lane.
+    volatile int pendingItems_[NUM_PRIORITY_LANES];
+    /// Worker pause mutex. Held by the main thread while paused.
     Mutex queueMutex_;
     /// Shutting down flag.
     volatile bool shutDown_;
-    /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
-    volatile bool pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
-    bool paused_;
+    /// Paused flag. Indicates the pause mutex being locked to prevent worker threads using up CPU time.
+    volatile bool paused_;
     /// Tolerance for the shared pool before it begins to deallocate.
     int tolerance_;
     /// Last size of the shared pool.
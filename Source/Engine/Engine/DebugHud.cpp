@@ -112,13 +112,14 @@ void DebugHud::Update()
         }
 
         String stats;
-        stats.AppendWithFormat("Triangles %u\nBatches %u\nViews %u\nLights %u\nShadowmaps %u\nOccluders %u",
+        stats.AppendWithFormat("Triangles %u\nBatches %u\nViews %u\nLights %u\nShadowmaps %u\nOccluders %u\nCulling skipped %u",
             primitives,
             batches,
             renderer->GetNumViews(),
             renderer->GetNumLights(true),
             renderer->GetNumShadowMaps(true),
-            renderer->GetNumOccluders(true));
+            renderer->GetNumOccluders(true),
+            renderer->GetNumSkippedDrawables(true));
 
         if (!appStats_.Empty())
         {
@@ -514,21 +514,27 @@ void Engine::Update()
 {
     PROFILE(Update);
 
-    // Logic update event
-    using namespace Update;
+    // Send events posted from worker threads before each update event, so that they are handled during the same frame
+    context_->SendPostedEvents();
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    // Logic update event
+    UpdateEvent eventData(E_UPDATE, timeStep_);
+    SendEvent(eventData);
+    context_->SendPostedEvents();
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    eventData.SetEventType(E_POSTUPDATE);
+    SendEvent(eventData);
+    context_->SendPostedEvents();
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    eventData.SetEventType(E_RENDERUPDATE);
+    SendEvent(eventData);
+    context_->SendPostedEvents();
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    eventData.SetEventType(E_POSTRENDERUPDATE);
+    SendEvent(eventData);
 }
 
 void Engine::Render()
@@ -35,10 +35,12 @@
 #include "Log.h"
 #include "Material.h"
 #include "Octree.h"
+#include "PoseCache.h"
 #include "Profiler.h"
 #include "ResourceCache.h"
 #include "ResourceEvents.h"
 #include "Scene.h"
+#include "Skinning.h"
 #include "Sort.h"
 #include "VertexBuffer.h"
 
@@ -56,6 +58,30 @@ static bool CompareAnimationOrder(const SharedPtr<AnimationState>& lhs, const Sh
 
 static const unsigned MAX_ANIMATION_STATES = 256;
 
+static float QuantizeTime(float time, float step)
+{
+    return floorf(time / step) * step;
+}
+
+static void AddPoseKey(PODVector<unsigned>& key, const void* ptr)
+{
+    unsigned long long value = (unsigned long long)(size_t)ptr;
+    key.Push((unsigned)value);
+    key.Push((unsigned)(value >> 32));
+}
+
+static void AddPoseKey(PODVector<unsigned>& key, float value)
+{
+    union
+    {
+        float f_;
+        unsigned u_;
+    } bits;
+    
+    bits.f_ = value;
+    key.Push(bits.u_);
+}
+
 AnimatedModel::AnimatedModel(Context* context) :
     StaticModel(context),
     animationLodFrameNumber_(0),
@@ -63,12 +89,17 @@ AnimatedModel::AnimatedModel(Context* context) :
     animationLodBias_(1.0f),
     animationLodTimer_(-1.0f),
     animationLodDistance_(0.0f),
+    poseVersion_(0),
     updateInvisible_(false),
     animationDirty_(false),
     animationOrderDirty_(false),
     morphsDirty_(false),
     skinningDirty_(true),
     boneBoundingBoxDirty_(true),
+    usePoseBuffer_(false),
+    poseDirty_(false),
+    cpuSkinning_(false),
+    skinnedPositionsDirty_(true),
     isMaster_(true),
     loading_(false),
     assignBonesPending_(false)
@@ -84,6 +115,7 @@ void AnimatedModel::RegisterObject(Context* context)
     context->RegisterFactory<AnimatedModel>(GEOMETRY_CATEGORY);
 
     ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_BOOL, "Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_BOOL, "Use Pose Buffer", GetUsePoseBuffer, SetUsePoseBuffer, bool, false, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_RESOURCEREF, "Model", GetModelAttr, SetModelAttr, ResourceRef, ResourceRef(Model::GetTypeStatic()), AM_DEFAULT);
     REF_ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_RESOURCEREFLIST, "Material", GetMaterialsAttr, SetMaterialsAttr, ResourceRefList, ResourceRefList(Material::GetTypeStatic()), AM_DEFAULT);
     ATTRIBUTE(AnimatedModel, VAR_BOOL, "Is Occluder", occluder_, false, AM_DEFAULT);
@@ -124,11 +156,81 @@ void AnimatedModel::ApplyAttributes()
         AssignBoneNodes();
 }
 
+void AnimatedModel::PrepareRayQuery(const RayOctreeQuery& query)
+{
+    if (query.level_ != RAY_TRIANGLE || !cpuSkinning_ || !skinMatrices_.Size() || !node_)
+        return;
+    
+    // The skinning reads the model's and the bone nodes' world transforms, which would otherwise be updated on demand in
+    // the worker threads. The bone nodes may be shared with skinned attachments on the same node
+    node_->GetWorldTransform();
+    if (skinningDirty_ && !GetPoseModel())
+    {
+        const Vector<Bone>& bones = skeleton_.GetBones();
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
+            if (bones[i].node_)
+                bones[i].node_->GetWorldTransform();
+        }
+    }
+}
+
 void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
 {
-    // If no bones or no bone-level testing, use the Drawable test
     RayQueryLevel level = query.level_;
-    if (level < RAY_AABB || !skeleton_.GetRootBone() || !skeleton_.GetRootBone()->node_)
+    
+    // With CPU skinning, test the skinned triangles
+    if (level == RAY_TRIANGLE && cpuSkinning_ && skinMatrices_.Size())
+    {
+        if (query.ray_.HitDistance(GetWorldBoundingBox()) >= query.maxDistance_)
+            return;
+        
+        UpdateSkinnedPositions();
+        
+        float distance = M_INFINITY;
+        Vector3 normal = -query.ray_.direction_;
+        for (unsigned i = 0; i < geometries_.Size() && i < skinnedPositions_.Size(); ++i)
+        {
+            Geometry* geometry = geometries_[i].Size() ? geometries_[i][0] : (Geometry*)0;
+            const PODVector<Vector3>& positions = skinnedPositions_[i];
+            if (!geometry || positions.Empty())
+                continue;
+            
+            const unsigned char* vertexData;
+            const unsigned char* indexData;
+            unsigned vertexSize;
+            unsigned indexSize;
+            unsigned elementMask;
+            geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+            
+            Vector3 geometryNormal;
+            float geometryDistance = indexData ? query.ray_.HitDistance(&positions[0], sizeof(Vector3), indexData, indexSize,
+                geometry->GetIndexStart(), geometry->GetIndexCount(), &geometryNormal) : query.ray_.HitDistance(&positions[0],
+                sizeof(Vector3), geometry->GetVertexStart(), geometry->GetVertexCount(), &geometryNormal);
+            if (geometryDistance < distance)
+            {
+                distance = geometryDistance;
+                normal = geometryNormal;
+            }
+        }
+        
+        if (distance < query.maxDistance_)
+        {
+            RayQueryResult result;
+            result.position_ = query.ray_.origin_ + distance * query.ray_.direction_;
+            result.normal_ = normal.Normalized();
+            result.distance_ = distance;
+            result.drawable_ = this;
+            result.node_ = node_;
+            result.subObject_ = M_MAX_UNSIGNED;
+            results.Push(result);
+        }
+        return;
+    }
+    
+    // If no bones or no bone-level testing, use the Drawable test
+    bool usePose = GetPoseModel() == this;
+    if (level < RAY_AABB || !skeleton_.GetRootBone() || (!skeleton_.GetRootBone()->node_ && !usePose))
     {
         Drawable::ProcessRayQuery(query, results);
         return;
@@ -139,12 +241,19 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         return;
 
     const Vector<Bone>& bones = skeleton_.GetBones();
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
     Sphere boneSphere;
 
     for (unsigned i = 0; i < bones.Size(); ++i)
     {
         const Bone& bone = bones[i];
-        if (!bone.node_)
+        Matrix3x4 transform;
+        // In pose buffer mode the bone transforms are in model space
+        if (usePose)
+            transform = worldTransform * boneTransforms_[i];
+        else if (bone.node_)
+            transform = bone.node_->GetWorldTransform();
+        else
             continue;
 
         float distance;
@@ -154,7 +263,6 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -170,7 +278,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = transform.Translation();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -195,7 +303,8 @@ void AnimatedModel::Update(const FrameInfo& frame)
 {
     // If node was invisible last frame, need to decide animation LOD distance here
     // If headless, retain the current animation distance (should be 0)
-    if (frame.camera_ && abs((int)frame.frameNumber_ - (int)viewFrameNumber_) > 1)
+    bool inView = frame.camera_ && abs((int)frame.frameNumber_ - (int)viewFrameNumber_) <= 1;
+    if (frame.camera_ && !inView)
     {
         // First check for no update at all when invisible
         if (!updateInvisible_)
@@ -211,7 +320,17 @@ void AnimatedModel::Update(const FrameInfo& frame)
     if (animationDirty_ || animationOrderDirty_)
         UpdateAnimation(frame);
     else if (boneBoundingBoxDirty_)
+    {
+        // In pose buffer mode the bone nodes may have been moved, for example by physics
+        if (poseDirty_)
+            UpdatePose();
         UpdateBoneBoundingBox();
+    }
+    
+    // In pose buffer mode the skin matrices depend only on the model's own data, so if the model is likely to be rendered,
+    // calculate them already in this threaded update instead of the later geometry update
+    if (skinningDirty_ && inView && usePoseBuffer_ && isMaster_)
+        UpdateSkinning();
 }
 
 void AnimatedModel::UpdateBatches(const FrameInfo& frame)
@@ -263,6 +382,15 @@ void AnimatedModel::UpdateGeometry(const FrameInfo& frame)
 
 UpdateGeometryType AnimatedModel::GetUpdateGeometryType()
 {
+    // Skinned attachments follow the master model's pose buffer. Check here in the main thread whether it has changed, so
+    // that the master does not need to touch the attachments during the threaded update
+    if (!isMaster_ && !skinningDirty_)
+    {
+        AnimatedModel* poseModel = GetPoseModel();
+        if (poseModel && poseModel->poseVersion_ != poseVersion_)
+            skinningDirty_ = true;
+    }
+    
     if (morphsDirty_)
         return UPDATE_MAIN_THREAD;
     else if (skinningDirty_)
@@ -276,7 +404,31 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
-        debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+        if (GetPoseModel() != this)
+        {
+            debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+            return;
+        }
+
+        // In pose buffer mode most bones have no nodes, so draw the skeleton from the pose in the same way
+        const Vector<Bone>& bones = skeleton_.GetBones();
+        const Matrix3x4& worldTransform = node_->GetWorldTransform();
+        unsigned uintColor = Color(0.75f, 0.75f, 0.75f).ToUInt();
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
+            // Skip if bone contains no skinned geometry
+            if (bones[i].radius_ < M_EPSILON && bones[i].boundingBox_.Size().LengthSquared() < M_EPSILON)
+                continue;
+
+            Vector3 start = worldTransform * boneTransforms_[i].Translation();
+            Vector3 end = start;
+            unsigned j = bones[i].parentIndex_;
+            if (j != i && j < bones.Size() && (bones[j].radius_ >= M_EPSILON || bones[j].boundingBox_.Size().LengthSquared() >=
+                M_EPSILON))
+                end = worldTransform * boneTransforms_[j].Translation();
+
+            debug->AddLine(start, end, uintColor, depthTest);
+        }
     }
 }
 
@@ -479,12 +631,90 @@ void AnimatedModel::SetAnimationLodBias(float bias)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetCPUSkinning(bool enable)
+{
+    cpuSkinning_ = enable;
+    skinnedPositionsDirty_ = true;
+    if (!enable)
+        skinnedPositions_.Clear();
+}
+
+void AnimatedModel::SetPoseCache(PoseCache* cache)
+{
+    poseCache_ = cache;
+    MarkAnimationDirty();
+}
+
 void AnimatedModel::SetUpdateInvisible(bool enable)
 {
     updateInvisible_ = enable;
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetUsePoseBuffer(bool enable)
+{
+    if (enable == usePoseBuffer_)
+        return;
+
+    MarkNetworkUpdate();
+
+    if (!isMaster_ || !skeleton_.GetNumBones())
+    {
+        usePoseBuffer_ = enable;
+        return;
+    }
+
+    // Recreate the skeleton in the new mode, retaining the animation states and bones' animation enabled status
+    VariantVector bonesEnabled = GetBonesEnabledAttr();
+    VariantVector animationStates = GetAnimationStatesAttr();
+    RemoveRootBone();
+    usePoseBuffer_ = enable;
+    skeleton_.ClearBones();
+    if (model_)
+    {
+        SetSkeleton(model_->GetSkeleton(), node_ != 0);
+        SetBonesEnabledAttr(bonesEnabled);
+        SetAnimationStatesAttr(animationStates);
+    }
+}
+
+Node* AnimatedModel::CreateBoneNode(const String& name)
+{
+    Bone* bone = skeleton_.GetBone(name);
+    if (!bone)
+        return 0;
+    if (bone->node_ || !usePoseBuffer_ || !isMaster_ || !node_)
+        return bone->node_;
+
+    // Create as a direct child of the model's node, so that the node transform is the bone's model space transform. Create
+    // as local and temporary, as the bone nodes are not serialized in pose buffer mode
+    Node* boneNode = node_->CreateChild(bone->name_, LOCAL);
+    boneNode->SetTemporary(true);
+    unsigned index = bone - &skeleton_.GetBones()[0];
+    if (index < boneTransforms_.Size())
+    {
+        Vector3 position;
+        Quaternion rotation;
+        Vector3 scale;
+        boneTransforms_[index].Decompose(position, rotation, scale);
+        boneNode->SetTransform(position, rotation, scale);
+    }
+    boneNode->AddListener(this);
+    bone->node_ = boneNode;
+    return boneNode;
+}
+
+void AnimatedModel::RemoveBoneNode(const String& name)
+{
+    Bone* bone = skeleton_.GetBone(name);
+    if (!bone || !bone->node_ || !usePoseBuffer_)
+        return;
+
+    bone->node_->Remove();
+    bone->node_.Reset();
+    MarkAnimationDirty();
+}
+
 
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
@@ -649,8 +879,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
 
             for (unsigned i = 0; i < destBones.Size(); ++i)
             {
-                if (destBones[i].node_ && destBones[i].name_ == srcBones[i].name_ && destBones[i].parentIndex_ ==
-                    srcBones[i].parentIndex_)
+                if ((destBones[i].node_ || usePoseBuffer_) && destBones[i].name_ == srcBones[i].name_ &&
+                    destBones[i].parentIndex_ == srcBones[i].parentIndex_)
                 {
                     // If compatible, just copy the values and retain the old node and animated status
                     Node* boneNode = destBones[i].node_;
@@ -688,8 +918,10 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
                 i->collisionMask_ &= ~BONECOLLISION_SPHERE;
         }
 
-        // Create scene nodes for the bones
-        if (createBones)
+        // Create scene nodes for the bones. In pose buffer mode they are created only on request
+        if (usePoseBuffer_)
+            InitializePose();
+        else if (createBones)
         {
             for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
             {
@@ -736,6 +968,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
 
     // Reserve space for skinning matrices
     skinMatrices_.Resize(skeleton_.GetNumBones());
+    skinnedPositionsDirty_ = true;
+    poseBoneIndices_.Clear();
     SetGeometryBoneMappings();
 
     assignBonesPending_ = !createBones;
@@ -868,6 +1102,9 @@ void AnimatedModel::OnMarkedDirty(Node* node)
     // If the scene node or any of the bone nodes move, mark skinning and the bone bounding box dirty
     skinningDirty_ = true;
     boneBoundingBoxDirty_ = true;
+    // In pose buffer mode a bone node moving may also change the pose
+    if (usePoseBuffer_ && node != node_)
+        poseDirty_ = true;
 }
 
 void AnimatedModel::OnWorldBoundingBoxUpdate()
@@ -909,8 +1146,8 @@ void AnimatedModel::AssignBoneNodes()
     }
 
     // If no bones found, this may be a prefab where the bone information was left out.
-    // In that case reassign the skeleton now if possible
-    if (!boneFound && model_)
+    // In that case reassign the skeleton now if possible. In pose buffer mode no bone nodes are needed
+    if (!boneFound && model_ && !usePoseBuffer_)
         SetSkeleton(model_->GetSkeleton(), true);
 
     // Re-assign the same start bone to animations to get the proper bone node this time
@@ -925,6 +1162,21 @@ void AnimatedModel::AssignBoneNodes()
 
 void AnimatedModel::RemoveRootBone()
 {
+    // In pose buffer mode the bone nodes are not in a hierarchy, so remove each of them
+    if (usePoseBuffer_ && isMaster_)
+    {
+        Vector<Bone>& bones = skeleton_.GetModifiableBones();
+        for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
+        {
+            if (i->node_)
+            {
+                i->node_->Remove();
+                i->node_.Reset();
+            }
+        }
+        return;
+    }
+
     Bone* rootBone = skeleton_.GetRootBone();
     if (rootBone && rootBone->node_)
         rootBone->node_->Remove();
@@ -1027,6 +1279,7 @@ void AnimatedModel::CloneGeometries()
     // Make sure the rendering batches use the new cloned geometries
     ResetLodLevels();
     MarkMorphsDirty();
+    skinnedPositionsDirty_ = true;
 }
 
 void AnimatedModel::CopyMorphVertices(void* destVertexData, void* srcVertexData, unsigned vertexCount, VertexBuffer* destBuffer, VertexBuffer* srcBuffer)
@@ -1038,6 +1291,13 @@ void AnimatedModel::CopyMorphVertices(void* destVertexData, void* srcVertexData,
     float* dest = (float*)destVertexData;
     unsigned char* src = (unsigned char*)srcVertexData;
 
+    // If the clone has the same vertex layout as the original, copy the whole range at once
+    if (mask == srcBuffer->GetElementMask() && destBuffer->GetVertexSize() == vertexSize)
+    {
+        memcpy(destVertexData, srcVertexData, vertexCount * vertexSize);
+        return;
+    }
+
     while (vertexCount--)
     {
         if (mask & MASK_POSITION)
@@ -1131,9 +1391,23 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
     // (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.Reset();
-        for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
-            (*i)->Apply();
+        // In pose buffer mode the animations are applied to the pose, which is then calculated to model space in one pass
+        if (usePoseBuffer_)
+        {
+            if (!poseCache_ || !UpdateCachedPose(frame))
+            {
+                ResetPose();
+                for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                    (*i)->Apply();
+                UpdatePose();
+            }
+        }
+        else
+        {
+            skeleton_.Reset();
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
+        }
         
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
@@ -1146,23 +1420,38 @@ void AnimatedModel::UpdateBoneBoundingBox()
 {
     if (skeleton_.GetNumBones())
     {
-        // The bone bounding box is in local space, so need the node's inverse transform
         boneBoundingBox_.defined_ = false;
-        Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
-        
         const Vector<Bone>& bones = skeleton_.GetBones();
-        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+        
+        // The bone bounding box is in local space. In pose buffer mode the bone transforms are already in it, otherwise
+        // need the node's inverse transform
+        if (usePoseBuffer_ && isMaster_)
         {
-            Node* boneNode = i->node_;
-            if (!boneNode)
-                continue;
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                const Bone& bone = bones[i];
+                if (bone.collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneTransforms_[i]));
+                else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(boneTransforms_[i].Translation(), bone.radius_ * 0.5f));
+            }
+        }
+        else
+        {
+            Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
+            for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+            {
+                Node* boneNode = i->node_;
+                if (!boneNode)
+                    continue;
 
-            // Use hitbox if available. If not, use only half of the sphere radius
-            /// \todo The sphere radius should be multiplied with bone scale
-            if (i->collisionMask_ & BONECOLLISION_BOX)
-                boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
-            else if (i->collisionMask_ & BONECOLLISION_SPHERE)
-                boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+                // Use hitbox if available. If not, use only half of the sphere radius
+                /// \todo The sphere radius should be multiplied with bone scale
+                if (i->collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
+                else if (i->collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            }
         }
     }
     
@@ -1176,9 +1465,44 @@ void AnimatedModel::UpdateSkinning()
     const Vector<Bone>& bones = skeleton_.GetBones();
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    AnimatedModel* poseModel = GetPoseModel();
 
+    // Skinning from a pose buffer. The bone transforms are in model space, so only the world transform needs to be applied
+    if (poseModel)
+    {
+        const PODVector<Matrix3x4>& boneTransforms = poseModel->boneTransforms_;
+        poseVersion_ = poseModel->poseVersion_;
+        
+        // Skinned attachments map their bones to the master model's pose by name
+        if (poseModel != this && poseBoneIndices_.Size() != bones.Size())
+        {
+            const Vector<Bone>& poseBones = poseModel->skeleton_.GetBones();
+            poseBoneIndices_.Resize(bones.Size());
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                const Bone* poseBone = poseModel->skeleton_.GetBone(bones[i].nameHash_);
+                poseBoneIndices_[i] = poseBone ? poseBone - &poseBones[0] : M_MAX_UNSIGNED;
+            }
+        }
+        
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
+            unsigned index = poseModel == this ? i : poseBoneIndices_[i];
+            if (index < boneTransforms.Size())
+                skinMatrices_[i] = worldTransform * boneTransforms[index] * bones[i].offsetMatrix_;
+            else
+                skinMatrices_[i] = worldTransform;
+            
+            // Copy the skin matrix to per-geometry matrices as needed
+            if (i < geometrySkinMatrixPtrs_.Size())
+            {
+                for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].Size(); ++j)
+                    *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+            }
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.Size())
+    else if (!geometrySkinMatrices_.Size())
     {
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
@@ -1207,6 +1531,257 @@ void AnimatedModel::UpdateSkinning()
     }
 
     skinningDirty_ = false;
+    skinnedPositionsDirty_ = true;
+}
+
+void AnimatedModel::UpdateSkinnedPositions()
+{
+    // Without views the skinning is not updated by the renderer, so update it here if needed. Skinned attachments compare
+    // the pose version like in GetUpdateGeometryType()
+    AnimatedModel* poseModel = GetPoseModel();
+    if (poseModel && poseModel != this && poseModel->poseVersion_ != poseVersion_)
+        skinningDirty_ = true;
+    if (skinningDirty_ && skinMatrices_.Size())
+        UpdateSkinning();
+    
+    // This may run in the worker threads during a threaded raycast. The world transforms read by the skinning have been
+    // updated in PrepareRayQuery() on the main thread, so only the model's own data is written
+    if (!skinnedPositionsDirty_)
+        return;
+    
+    skinnedPositions_.Resize(geometries_.Size());
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        PODVector<Vector3>& positions = skinnedPositions_[i];
+        Geometry* geometry = geometries_[i].Size() ? geometries_[i][0] : (Geometry*)0;
+        if (!geometry)
+        {
+            positions.Clear();
+            continue;
+        }
+        
+        // The positions come from the morphed vertex buffer if there is one, the blend weights and indices from the original
+        const unsigned char* vertexData;
+        const unsigned char* indexData;
+        unsigned vertexSize;
+        unsigned indexSize;
+        unsigned elementMask;
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+        
+        VertexBuffer* blendBuffer = 0;
+        const Vector<SharedPtr<VertexBuffer> >& vertexBuffers = geometry->GetVertexBuffers();
+        for (unsigned j = 0; j < vertexBuffers.Size(); ++j)
+        {
+            VertexBuffer* buffer = vertexBuffers[j];
+            if (buffer && buffer->GetShadowData() && (buffer->GetElementMask() & (MASK_BLENDWEIGHTS | MASK_BLENDINDICES)) ==
+                (MASK_BLENDWEIGHTS | MASK_BLENDINDICES))
+            {
+                blendBuffer = buffer;
+                break;
+            }
+        }
+        
+        if (!vertexData || !(elementMask & MASK_POSITION) || !blendBuffer)
+        {
+            positions.Clear();
+            continue;
+        }
+        
+        unsigned vertexStart = geometry->GetVertexStart();
+        unsigned vertexCount = geometry->GetVertexCount();
+        if (!vertexCount)
+        {
+            vertexStart = 0;
+            vertexCount = blendBuffer->GetVertexCount();
+        }
+        
+        // Geometries with their own bone mappings use their own skin matrices
+        const PODVector<Matrix3x4>& matrices = i < geometrySkinMatrices_.Size() && geometrySkinMatrices_[i].Size() ?
+            geometrySkinMatrices_[i] : skinMatrices_;
+        positions.Resize(vertexStart + vertexCount);
+        SkinPositions(&positions[0], vertexData, vertexSize, blendBuffer->GetShadowData(), blendBuffer->GetVertexSize(),
+            blendBuffer->GetElementOffset(ELEMENT_BLENDWEIGHTS), blendBuffer->GetElementOffset(ELEMENT_BLENDINDICES), vertexStart,
+            vertexCount, matrices.Empty() ? 0 : &matrices[0], matrices.Size());
+    }
+    
+    skinnedPositionsDirty_ = false;
+}
+
+const Vector<PODVector<Vector3> >& AnimatedModel::GetSkinnedPositions()
+{
+    if (cpuSkinning_)
+        UpdateSkinnedPositions();
+    
+    return skinnedPositions_;
+}
+
+void AnimatedModel::InitializePose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = bones.Size();
+    
+    bonePositions_.Resize(numBones);
+    boneRotations_.Resize(numBones);
+    boneScales_.Resize(numBones);
+    boneTransforms_.Resize(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        bonePositions_[i] = bones[i].initialPosition_;
+        boneRotations_[i] = bones[i].initialRotation_;
+        boneScales_[i] = bones[i].initialScale_;
+        boneTransforms_[i] = Matrix3x4::IDENTITY;
+    }
+    
+    // Order the bones by their depth in the hierarchy, so that the parents are evaluated before their children
+    PODVector<unsigned> depths(numBones);
+    unsigned maxDepth = 0;
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        unsigned depth = 0;
+        unsigned j = i;
+        // Limit the walk to the number of bones in case of a malformed hierarchy
+        while (bones[j].parentIndex_ != j && bones[j].parentIndex_ < numBones && depth < numBones)
+        {
+            j = bones[j].parentIndex_;
+            ++depth;
+        }
+        depths[i] = depth;
+        maxDepth = Max((int)maxDepth, (int)depth);
+    }
+    
+    boneOrder_.Clear();
+    boneOrder_.Reserve(numBones);
+    for (unsigned depth = 0; depth <= maxDepth && numBones; ++depth)
+    {
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            if (depths[i] == depth)
+                boneOrder_.Push(i);
+        }
+    }
+    
+    poseDirty_ = true;
+}
+
+void AnimatedModel::ResetPose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_)
+        {
+            bonePositions_[i] = bone.initialPosition_;
+            boneRotations_[i] = bone.initialRotation_;
+            boneScales_[i] = bone.initialScale_;
+        }
+    }
+}
+
+void AnimatedModel::UpdatePose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = bones.Size();
+    
+    for (PODVector<unsigned>::ConstIterator i = boneOrder_.Begin(); i != boneOrder_.End(); ++i)
+    {
+        unsigned index = *i;
+        const Bone& bone = bones[index];
+        Node* boneNode = bone.node_;
+        
+        // If the bone has animation disabled, its node (if any) controls it
+        if (boneNode && !bone.animated_)
+        {
+            boneTransforms_[index] = boneNode->GetTransform();
+            continue;
+        }
+        
+        unsigned parentIndex = bone.parentIndex_;
+        if (parentIndex != index && parentIndex < numBones)
+            boneTransforms_[index] = boneTransforms_[parentIndex] * Matrix3x4(bonePositions_[index], boneRotations_[index],
+                boneScales_[index]);
+        else
+            boneTransforms_[index] = Matrix3x4(bonePositions_[index], boneRotations_[index], boneScales_[index]);
+        
+        if (boneNode)
+        {
+            Vector3 position;
+            Quaternion rotation;
+            Vector3 scale;
+            boneTransforms_[index].Decompose(position, rotation, scale);
+            boneNode->SetTransform(position, rotation, scale);
+        }
+    }
+    
+    // Skinned attachments on the same node use this pose, they compare the version to see if their skinning needs updating
+    ++poseVersion_;
+    skinningDirty_ = true;
+    poseDirty_ = false;
+}
+
+bool AnimatedModel::UpdateCachedPose(const FrameInfo& frame)
+{
+    // The pose can only be shared if it depends on nothing but the model and the animation states
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+    {
+        if (i->node_ || !i->animated_)
+            return false;
+    }
+    
+    // With animation LOD the model updates less often, so quantize its time more coarsely to share more poses. Use power of
+    // two multiples of the step so that models at similar distances arrive at the same step
+    float timeStep = poseCache_->GetTimeStep();
+    if (animationLodBias_ > 0.0f && animationLodDistance_ > 0.0f)
+    {
+        float lodInterval = animationLodDistance_ / (animationLodBias_ * ANIMATION_LOD_BASESCALE);
+        while (timeStep * 2.0f <= lodInterval)
+            timeStep *= 2.0f;
+    }
+    
+    // The key is the model followed by the enabled animation states in blending order
+    poseKey_.Clear();
+    AddPoseKey(poseKey_, model_.Get());
+    for (Vector<SharedPtr<AnimationState> >::ConstIterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+    {
+        AnimationState* state = *i;
+        if (!state->GetAnimation() || !state->IsEnabled())
+            continue;
+        if (state->HasCustomBoneWeights())
+            return false;
+        
+        Bone* startBone = state->GetStartBone();
+        AddPoseKey(poseKey_, state->GetAnimation());
+        AddPoseKey(poseKey_, QuantizeTime(state->GetTime(), timeStep));
+        AddPoseKey(poseKey_, state->GetWeight());
+        poseKey_.Push(startBone ? startBone->nameHash_.Value() : 0);
+        poseKey_.Push(state->IsLooped() ? 1 : 0);
+    }
+    
+    if (poseCache_->GetPose(poseKey_, frame.frameNumber_, boneTransforms_))
+    {
+        ++poseVersion_;
+        skinningDirty_ = true;
+        poseDirty_ = false;
+        return true;
+    }
+    
+    ResetPose();
+    for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+        (*i)->ApplyToPose(QuantizeTime((*i)->GetTime(), timeStep));
+    UpdatePose();
+    
+    poseCache_->StorePose(poseKey_, frame.frameNumber_, boneTransforms_);
+    return true;
+}
+
+AnimatedModel* AnimatedModel::GetPoseModel() const
+{
+    if (isMaster_)
+        return usePoseBuffer_ ? const_cast<AnimatedModel*>(this) : 0;
+    
+    AnimatedModel* master = node_ ? node_->GetComponent<AnimatedModel>() : 0;
+    return master && master->usePoseBuffer_ ? master : 0;
 }
 
 void AnimatedModel::UpdateMorphs()
@@ -1240,7 +1815,11 @@ void AnimatedModel::UpdateMorphs()
                         {
                             HashMap<unsigned, VertexBufferMorph>::Iterator k = morphs_[j].buffers_.Find(i);
                             if (k != morphs_[j].buffers_.End())
-                                ApplyMorph(buffer, dest, morphStart, k->second_, morphs_[j].weight_);
+                            {
+                                ApplyVertexMorph(dest, buffer->GetVertexSize(), buffer->GetElementOffset(ELEMENT_NORMAL),
+                                    buffer->GetElementOffset(ELEMENT_TANGENT), buffer->GetElementMask(), morphStart, k->second_,
+                                    morphs_[j].weight_);
+                            }
                         }
                     }
 
@@ -1251,52 +1830,7 @@ void AnimatedModel::UpdateMorphs()
     }
 
     morphsDirty_ = false;
-}
-
-void AnimatedModel::ApplyMorph(VertexBuffer* buffer, void* destVertexData, unsigned morphRangeStart, const VertexBufferMorph& morph, float weight)
-{
-    unsigned elementMask = morph.elementMask_ & buffer->GetElementMask();
-    unsigned vertexCount = morph.vertexCount_;
-    unsigned normalOffset = buffer->GetElementOffset(ELEMENT_NORMAL);
-    unsigned tangentOffset = buffer->GetElementOffset(ELEMENT_TANGENT);
-    unsigned vertexSize = buffer->GetVertexSize();
-
-    unsigned char* srcData = morph.morphData_;
-    unsigned char* destData = (unsigned char*)destVertexData;
-
-    while (vertexCount--)
-    {
-        unsigned vertexIndex = *((unsigned*)srcData) - morphRangeStart;
-        srcData += sizeof(unsigned);
-
-        if (elementMask & MASK_POSITION)
-        {
-            float* dest = (float*)(destData + vertexIndex * vertexSize);
-            float* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-        if (elementMask & MASK_NORMAL)
-        {
-            float* dest = (float*)(destData + vertexIndex * vertexSize + normalOffset);
-            float* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-        if (elementMask & MASK_TANGENT)
-        {
-            float* dest = (float*)(destData + vertexIndex * vertexSize + tangentOffset);
-            float* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-    }
+    skinnedPositionsDirty_ = true;
 }
 
 void AnimatedModel::HandleModelReloadFinished(StringHash eventType, VariantMap& eventData)
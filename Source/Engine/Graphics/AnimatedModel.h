@@ -31,6 +31,7 @@ namespace Urho3D
 
 class Animation;
 class AnimationState;
+class PoseCache;
 
 /// Animated model component.
 class URHO3D_API AnimatedModel : public StaticModel
@@ -53,6 +54,8 @@ public:
     virtual bool LoadXML(const XMLElement& source, bool setInstanceDefault = false);
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     virtual void ApplyAttributes();
+    /// Prepare for a threaded octree raycast. Updates the world transforms that the CPU skinning reads.
+    virtual void PrepareRayQuery(const RayOctreeQuery& query);
     /// Process octree raycast. May be called from a worker thread.
     virtual void ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results);
     /// Update before octree reinsertion. Is called from a worker thread.
@@ -94,6 +97,16 @@ public:
     void SetMorphWeight(StringHash nameHash, float weight);
     /// Reset all vertex morphs to zero.
     void ResetMorphWeights();
+    /// Set whether to evaluate the skeleton in a pose buffer instead of bone scene nodes. Only bones that are requested with CreateBoneNode() get a scene node. Should be set before the model, otherwise the bone nodes are recreated. Only has effect on the master model; skinned attachments on the same node follow it.
+    void SetUsePoseBuffer(bool enable);
+    /// Create a scene node for a bone in pose buffer mode, or return the existing bone node. The node is a temporary child of the model's node and its transform is the bone's transform in model space. If the bone has animation disabled, the node controls the bone instead, for example for ragdolls.
+    Node* CreateBoneNode(const String& name);
+    /// Remove a bone's scene node in pose buffer mode.
+    void RemoveBoneNode(const String& name);
+    /// Set whether to also calculate the skinned vertex positions on the CPU. They are calculated on demand and used for triangle-level raycasts, and are also available in headless mode, where there is no GPU skinning. Not serialized.
+    void SetCPUSkinning(bool enable);
+    /// Set a shared pose cache for pose buffer mode. The pose is copied from the cache when another model has calculated it for the same animations, with the time positions quantized to the cache's time step, and coarser when animation LOD reduces the update rate. Not used if the model has bone nodes, bones with animation disabled or per-bone blending weights.
+    void SetPoseCache(PoseCache* cache);
 
     /// Return skeleton.
     Skeleton& GetSkeleton() { return skeleton_; }
@@ -113,6 +126,16 @@ public:
     float GetAnimationLodBias() const { return animationLodBias_; }
     /// Return whether to update animation when not visible.
     bool GetUpdateInvisible() const { return updateInvisible_; }
+    /// Return whether evaluates the skeleton in a pose buffer.
+    bool GetUsePoseBuffer() const { return usePoseBuffer_; }
+    /// Return bone transforms in model space in pose buffer mode.
+    const PODVector<Matrix3x4>& GetBoneTransforms() const { return boneTransforms_; }
+    /// Return the shared pose cache.
+    PoseCache* GetPoseCache() const { return poseCache_; }
+    /// Return whether calculates the skinned vertex positions on the CPU.
+    bool GetCPUSkinning() const { return cpuSkinning_; }
+    /// Return the CPU skinned world space vertex positions of each geometry's first LOD level, indexed with the geometry's vertex indices. Updated first if necessary. Empty if CPU skinning is disabled.
+    const Vector<PODVector<Vector3> >& GetSkinnedPositions();
     /// Return all vertex morphs.
     const Vector<ModelMorph>& GetMorphs() const { return morphs_; }
     /// Return all morph vertex buffers.
@@ -180,12 +203,22 @@ private:
     void UpdateAnimation(const FrameInfo& frame);
     /// Recalculate the bone bounding box.
     void UpdateBoneBoundingBox();
+    /// Initialize the pose buffer from the skeleton.
+    void InitializePose();
+    /// Reset the animated bones of the pose buffer to the initial pose.
+    void ResetPose();
+    /// Calculate the model space bone transforms of the pose buffer and synchronize the bone nodes.
+    void UpdatePose();
+    /// Copy the pose from the shared pose cache, or calculate it at the quantized time positions and store it. Return false if the pose can not be shared.
+    bool UpdateCachedPose(const FrameInfo& frame);
+    /// Return the model whose pose buffer is used for skinning, or null if bone nodes are used.
+    AnimatedModel* GetPoseModel() const;
     /// Recalculate skinning.
     void UpdateSkinning();
+    /// Recalculate the CPU skinned vertex positions if necessary.
+    void UpdateSkinnedPositions();
     /// Reapply all vertex morphs.
     void UpdateMorphs();
-    /// Apply a vertex morph.
-    void ApplyMorph(VertexBuffer* buffer, void* destVertexData, unsigned morphRangeStart, const VertexBufferMorph& morph, float weight);
     /// Handle model reload finished.
     void HandleModelReloadFinished(StringHash eventType, VariantMap& eventData);
 
@@ -205,6 +238,24 @@ private:
     Vector<PODVector<Matrix3x4> > geometrySkinMatrices_;
     /// Subgeometry skinning matrix pointers, if more bones than skinning shader can manage.
     Vector<PODVector<Matrix3x4*> > geometrySkinMatrixPtrs_;
+    /// Bone positions in pose buffer mode.
+    PODVector<Vector3> bonePositions_;
+    /// Bone rotations in pose buffer mode.
+    PODVector<Quaternion> boneRotations_;
+    /// Bone scales in pose buffer mode.
+    PODVector<Vector3> boneScales_;
+    /// Bone transforms in model space in pose buffer mode.
+    PODVector<Matrix3x4> boneTransforms_;
+    /// Bone evaluation order in pose buffer mode, parents before their children.
+    PODVector<unsigned> boneOrder_;
+    /// Mapping of bone indices to the master model's pose buffer, used by skinned attachments.
+    PODVector<unsigned> poseBoneIndices_;
+    /// Shared pose cache.
+    SharedPtr<PoseCache> poseCache_;
+    /// Pose cache key of the current animation states.
+    PODVector<unsigned> poseKey_;
+    /// CPU skinned vertex positions per geometry.
+    Vector<PODVector<Vector3> > skinnedPositions_;
     /// Bounding box calculated from bones.
     BoundingBox boneBoundingBox_;
     /// Attribute buffer.
@@ -219,6 +270,8 @@ private:
     float animationLodTimer_;
     /// Animation LOD distance, the minimum of all LOD view distances last frame.
     float animationLodDistance_;
+    /// Pose buffer version. Incremented by the master model when the pose is calculated, and copied by skinned attachments when they skin from it.
+    unsigned poseVersion_;
     /// Update animation when invisible flag.
     bool updateInvisible_;
     /// Animation dirty flag.
@@ -231,6 +284,14 @@ private:
     bool skinningDirty_;
     /// Bone bounding box dirty flag.
     bool boneBoundingBoxDirty_;
+    /// Pose buffer mode flag.
+    bool usePoseBuffer_;
+    /// Pose buffer dirty flag, set when bone nodes have been moved.
+    bool poseDirty_;
+    /// CPU skinning flag.
+    bool cpuSkinning_;
+    /// CPU skinned vertex positions dirty flag.
+    bool skinnedPositionsDirty_;
     /// Master model flag.
     bool isMaster_;
     /// Loading flag. During loading bone nodes are not created, as they will be serialized as child nodes.
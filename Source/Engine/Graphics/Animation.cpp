@@ -36,28 +36,323 @@
 namespace Urho3D
 {
 
+/// Range of the three smallest components of a unit quaternion.
+static const float ROTATION_RANGE = 0.707107f;
+/// Largest value of a 15-bit quantized rotation component.
+static const float ROTATION_QUANTIZE_MAX = 32767.0f;
+/// Largest value of a 16-bit quantized position or scale component.
+static const float VECTOR_QUANTIZE_MAX = 65535.0f;
+
 inline bool CompareTriggers(AnimationTriggerPoint& lhs, AnimationTriggerPoint& rhs)
 {
     return lhs.time_ < rhs.time_;
 }
 
+static unsigned short QuantizeComponent(float value, float min, float step)
+{
+    return step > 0.0f ? (unsigned short)Clamp((value - min) / step + 0.5f, 0.0f, VECTOR_QUANTIZE_MAX) : 0;
+}
+
+static void QuantizeVector(const Vector3& value, const Vector3& min, const Vector3& step, unsigned short* dest)
+{
+    dest[0] = QuantizeComponent(value.x_, min.x_, step.x_);
+    dest[1] = QuantizeComponent(value.y_, min.y_, step.y_);
+    dest[2] = QuantizeComponent(value.z_, min.z_, step.z_);
+}
+
+static Vector3 DequantizeVector(const unsigned short* src, const Vector3& min, const Vector3& step)
+{
+    return Vector3(min.x_ + src[0] * step.x_, min.y_ + src[1] * step.y_, min.z_ + src[2] * step.z_);
+}
+
+static void QuantizeRotation(const Quaternion& value, unsigned short* dest)
+{
+    // Store the three smallest components, the largest is reconstructed from unit length. Negate the quaternion if
+    // necessary so that the largest component is positive, and store its index in the high bits of the first two values
+    float components[4] = { value.w_, value.x_, value.y_, value.z_ };
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+    
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float normalized = (Clamp(components[i] * sign, -ROTATION_RANGE, ROTATION_RANGE) + ROTATION_RANGE) / (2.0f *
+            ROTATION_RANGE);
+        dest[j++] = (unsigned short)(normalized * ROTATION_QUANTIZE_MAX + 0.5f);
+    }
+    
+    dest[0] |= (largest & 2) << 14;
+    dest[1] |= (largest & 1) << 15;
+}
+
+static Quaternion DequantizeRotation(const unsigned short* src)
+{
+    unsigned largest = ((src[0] >> 14) & 2) | (src[1] >> 15);
+    float components[4];
+    float sumSquares = 0.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float value = (src[j++] & 0x7fff) * (2.0f * ROTATION_RANGE / ROTATION_QUANTIZE_MAX) - ROTATION_RANGE;
+        components[i] = value;
+        sumSquares += value * value;
+    }
+    
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+    return Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+static bool CanInterpolate(const Vector<AnimationKeyFrame>& keyFrames, unsigned first, unsigned last, unsigned char channelMask,
+    float positionError, float minRotationDot, float scaleError)
+{
+    const AnimationKeyFrame& firstKeyFrame = keyFrames[first];
+    const AnimationKeyFrame& lastKeyFrame = keyFrames[last];
+    float timeInterval = lastKeyFrame.time_ - firstKeyFrame.time_;
+    
+    for (unsigned i = first + 1; i < last; ++i)
+    {
+        const AnimationKeyFrame& keyFrame = keyFrames[i];
+        float t = timeInterval > 0.0f ? (keyFrame.time_ - firstKeyFrame.time_) / timeInterval : 1.0f;
+        
+        if ((channelMask & CHANNEL_POSITION) && (firstKeyFrame.position_.Lerp(lastKeyFrame.position_, t) -
+            keyFrame.position_).Length() > positionError)
+            return false;
+        if ((channelMask & CHANNEL_ROTATION) && Abs(firstKeyFrame.rotation_.Slerp(lastKeyFrame.rotation_, t).DotProduct(
+            keyFrame.rotation_)) < minRotationDot)
+            return false;
+        if ((channelMask & CHANNEL_SCALE) && (firstKeyFrame.scale_.Lerp(lastKeyFrame.scale_, t) - keyFrame.scale_).Length() >
+            scaleError)
+            return false;
+    }
+    
+    return true;
+}
+
+AnimationTrack::AnimationTrack() :
+    channelMask_(0),
+    constantMask_(0),
+    rotationOffset_(0),
+    scaleOffset_(0),
+    compressed_(false)
+{
+}
+
 void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
 {
+    unsigned numKeyFrames = GetNumKeyFrames();
+    
     if (time < 0.0f)
         time = 0.0f;
     
-    if (index >= keyFrames_.Size())
-        index = keyFrames_.Size() - 1;
+    if (index >= numKeyFrames)
+        index = numKeyFrames - 1;
     
     // Check for being too far ahead
-    while (index && time < keyFrames_[index].time_)
+    while (index && time < GetKeyFrameTime(index))
         --index;
     
     // Check for being too far behind
-    while (index < keyFrames_.Size() - 1 && time >= keyFrames_[index + 1].time_)
+    while (index < numKeyFrames - 1 && time >= GetKeyFrameTime(index + 1))
         ++index;
 }
 
+void AnimationTrack::Sample(float time, float length, bool looped, unsigned& index, Vector3& position, Quaternion& rotation,
+    Vector3& scale) const
+{
+    GetKeyFrameIndex(time, index);
+    
+    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+    unsigned nextIndex = index + 1;
+    bool interpolate = true;
+    if (nextIndex >= GetNumKeyFrames())
+    {
+        if (!looped)
+        {
+            nextIndex = index;
+            interpolate = false;
+        }
+        else
+            nextIndex = 0;
+    }
+    
+    // Compressed keyframes are decoded on the fly, only the two being interpolated
+    AnimationKeyFrame decoded[2];
+    const AnimationKeyFrame* keyFrame;
+    const AnimationKeyFrame* nextKeyFrame;
+    if (!compressed_)
+    {
+        keyFrame = &keyFrames_[index];
+        nextKeyFrame = &keyFrames_[nextIndex];
+    }
+    else
+    {
+        GetKeyFrame(index, decoded[0]);
+        keyFrame = &decoded[0];
+        if (interpolate)
+            GetKeyFrame(nextIndex, decoded[1]);
+        nextKeyFrame = &decoded[1];
+    }
+    
+    if (!interpolate)
+    {
+        if (channelMask_ & CHANNEL_POSITION)
+            position = keyFrame->position_;
+        if (channelMask_ & CHANNEL_ROTATION)
+            rotation = keyFrame->rotation_;
+        if (channelMask_ & CHANNEL_SCALE)
+            scale = keyFrame->scale_;
+    }
+    else
+    {
+        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+        if (timeInterval < 0.0f)
+            timeInterval += length;
+        float t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
+        
+        if (channelMask_ & CHANNEL_POSITION)
+            position = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+        if (channelMask_ & CHANNEL_ROTATION)
+            rotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+        if (channelMask_ & CHANNEL_SCALE)
+            scale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+    }
+}
+
+void AnimationTrack::GetKeyFrame(unsigned index, AnimationKeyFrame& dest) const
+{
+    if (!compressed_)
+    {
+        dest = keyFrames_[index];
+        return;
+    }
+    
+    dest.time_ = keyTimes_[index];
+    if (channelMask_ & CHANNEL_POSITION)
+        dest.position_ = DequantizeVector(&keyData_[constantMask_ & CHANNEL_POSITION ? 0 : index * 3], positionMin_, positionStep_);
+    if (channelMask_ & CHANNEL_ROTATION)
+        dest.rotation_ = DequantizeRotation(&keyData_[rotationOffset_ + (constantMask_ & CHANNEL_ROTATION ? 0 : index * 3)]);
+    if (channelMask_ & CHANNEL_SCALE)
+        dest.scale_ = DequantizeVector(&keyData_[scaleOffset_ + (constantMask_ & CHANNEL_SCALE ? 0 : index * 3)], scaleMin_,
+            scaleStep_);
+}
+
+void AnimationTrack::Compress(float positionError, float rotationError, float scaleError)
+{
+    if (compressed_ || keyFrames_.Empty())
+        return;
+    
+    // Rotation error is compared as the dot product of unit quaternions, which is the cosine of half the angle
+    float minRotationDot = cosf(Max(rotationError, 0.0f) * 0.5f);
+    unsigned numKeyFrames = keyFrames_.Size();
+    const AnimationKeyFrame& firstKeyFrame = keyFrames_[0];
+    
+    // Find the channels that stay constant within the tolerances
+    constantMask_ = channelMask_;
+    for (unsigned i = 1; i < numKeyFrames; ++i)
+    {
+        const AnimationKeyFrame& keyFrame = keyFrames_[i];
+        if ((keyFrame.position_ - firstKeyFrame.position_).Length() > positionError)
+            constantMask_ &= ~CHANNEL_POSITION;
+        if (Abs(keyFrame.rotation_.DotProduct(firstKeyFrame.rotation_)) < minRotationDot)
+            constantMask_ &= ~CHANNEL_ROTATION;
+        if ((keyFrame.scale_ - firstKeyFrame.scale_).Length() > scaleError)
+            constantMask_ &= ~CHANNEL_SCALE;
+    }
+    
+    // Remove keyframes that can be interpolated from the previous kept keyframe and a later one. The first and last
+    // keyframes are always kept so that looping wraps the same way, unless all channels are constant
+    PODVector<unsigned> keep;
+    keep.Push(0);
+    if (constantMask_ != channelMask_ && numKeyFrames > 1)
+    {
+        unsigned char varyingMask = channelMask_ & ~constantMask_;
+        unsigned anchor = 0;
+        for (unsigned i = 2; i < numKeyFrames; ++i)
+        {
+            if (!CanInterpolate(keyFrames_, anchor, i, varyingMask, positionError, minRotationDot, scaleError))
+            {
+                anchor = i - 1;
+                keep.Push(anchor);
+            }
+        }
+        keep.Push(numKeyFrames - 1);
+    }
+    
+    unsigned numKept = keep.Size();
+    keyTimes_.Resize(numKept);
+    for (unsigned i = 0; i < numKept; ++i)
+        keyTimes_[i] = keyFrames_[keep[i]].time_;
+    
+    // Quantize positions and scales over their range in the track
+    positionMin_ = positionStep_ = scaleMin_ = scaleStep_ = Vector3::ZERO;
+    if (channelMask_ & CHANNEL_POSITION)
+    {
+        positionMin_ = firstKeyFrame.position_;
+        Vector3 positionMax = firstKeyFrame.position_;
+        if (!(constantMask_ & CHANNEL_POSITION))
+        {
+            for (unsigned i = 1; i < numKept; ++i)
+            {
+                const Vector3& position = keyFrames_[keep[i]].position_;
+                positionMin_ = Vector3(Min(positionMin_.x_, position.x_), Min(positionMin_.y_, position.y_), Min(positionMin_.z_,
+                    position.z_));
+                positionMax = Vector3(Max(positionMax.x_, position.x_), Max(positionMax.y_, position.y_), Max(positionMax.z_,
+                    position.z_));
+            }
+        }
+        positionStep_ = (positionMax - positionMin_) / VECTOR_QUANTIZE_MAX;
+    }
+    if (channelMask_ & CHANNEL_SCALE)
+    {
+        scaleMin_ = firstKeyFrame.scale_;
+        Vector3 scaleMax = firstKeyFrame.scale_;
+        if (!(constantMask_ & CHANNEL_SCALE))
+        {
+            for (unsigned i = 1; i < numKept; ++i)
+            {
+                const Vector3& scale = keyFrames_[keep[i]].scale_;
+                scaleMin_ = Vector3(Min(scaleMin_.x_, scale.x_), Min(scaleMin_.y_, scale.y_), Min(scaleMin_.z_, scale.z_));
+                scaleMax = Vector3(Max(scaleMax.x_, scale.x_), Max(scaleMax.y_, scale.y_), Max(scaleMax.z_, scale.z_));
+            }
+        }
+        scaleStep_ = (scaleMax - scaleMin_) / VECTOR_QUANTIZE_MAX;
+    }
+    
+    // Lay out the channels one after another, a constant channel taking only one set of values
+    unsigned numPositions = channelMask_ & CHANNEL_POSITION ? (constantMask_ & CHANNEL_POSITION ? 1 : numKept) : 0;
+    unsigned numRotations = channelMask_ & CHANNEL_ROTATION ? (constantMask_ & CHANNEL_ROTATION ? 1 : numKept) : 0;
+    unsigned numScales = channelMask_ & CHANNEL_SCALE ? (constantMask_ & CHANNEL_SCALE ? 1 : numKept) : 0;
+    rotationOffset_ = numPositions * 3;
+    scaleOffset_ = rotationOffset_ + numRotations * 3;
+    keyData_.Resize(scaleOffset_ + numScales * 3);
+    
+    for (unsigned i = 0; i < numPositions; ++i)
+        QuantizeVector(keyFrames_[keep[i]].position_, positionMin_, positionStep_, &keyData_[i * 3]);
+    for (unsigned i = 0; i < numRotations; ++i)
+        QuantizeRotation(keyFrames_[keep[i]].rotation_, &keyData_[rotationOffset_ + i * 3]);
+    for (unsigned i = 0; i < numScales; ++i)
+        QuantizeVector(keyFrames_[keep[i]].scale_, scaleMin_, scaleStep_, &keyData_[scaleOffset_ + i * 3]);
+    
+    keyFrames_.Clear();
+    keyFrames_.Compact();
+    compressed_ = true;
+}
+
+unsigned AnimationTrack::GetDataSize() const
+{
+    return keyFrames_.Size() * sizeof(AnimationKeyFrame) + keyTimes_.Size() * sizeof(float) + keyData_.Size() *
+        sizeof(unsigned short);
+}
+
 Animation::Animation(Context* context) :
     Resource(context),
     length_(0.f)
@@ -77,14 +372,14 @@ bool Animation::Load(Deserializer& source)
 {
     PROFILE(LoadAnimation);
     
-    unsigned memoryUse = sizeof(Animation);
-    
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UANC")
     {
         LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
     }
+    bool compressed = fileID == "UANC";
     
     // Read name and length
     animationName_ = source.ReadString();
@@ -94,7 +389,6 @@ bool Animation::Load(Deserializer& source)
     
     unsigned tracks = source.ReadUInt();
     tracks_.Resize(tracks);
-    memoryUse += tracks * sizeof(AnimationTrack);
     
     // Read tracks
     for (unsigned i = 0; i < tracks; ++i)
@@ -104,9 +398,50 @@ bool Animation::Load(Deserializer& source)
         newTrack.nameHash_ = newTrack.name_;
         newTrack.channelMask_ = source.ReadUByte();
         
+        if (compressed)
+        {
+            // Read the key times and the quantized channel data as is, they are decoded when sampling
+            newTrack.constantMask_ = source.ReadUByte();
+            unsigned keyFrames = source.ReadUInt();
+            newTrack.keyTimes_.Resize(keyFrames);
+            if (keyFrames)
+                source.Read(&newTrack.keyTimes_[0], keyFrames * sizeof(float));
+            if (newTrack.channelMask_ & CHANNEL_POSITION)
+            {
+                newTrack.positionMin_ = source.ReadVector3();
+                newTrack.positionStep_ = source.ReadVector3();
+            }
+            if (newTrack.channelMask_ & CHANNEL_SCALE)
+            {
+                newTrack.scaleMin_ = source.ReadVector3();
+                newTrack.scaleStep_ = source.ReadVector3();
+            }
+            
+            unsigned numPositions = newTrack.channelMask_ & CHANNEL_POSITION ? (newTrack.constantMask_ & CHANNEL_POSITION ? 1 :
+                keyFrames) : 0;
+            unsigned numRotations = newTrack.channelMask_ & CHANNEL_ROTATION ? (newTrack.constantMask_ & CHANNEL_ROTATION ? 1 :
+                keyFrames) : 0;
+            unsigned numScales = newTrack.channelMask_ & CHANNEL_SCALE ? (newTrack.constantMask_ & CHANNEL_SCALE ? 1 :
+                keyFrames) : 0;
+            newTrack.rotationOffset_ = numPositions * 3;
+            newTrack.scaleOffset_ = newTrack.rotationOffset_ + numRotations * 3;
+            
+            unsigned dataSize = source.ReadUInt();
+            if (dataSize != newTrack.scaleOffset_ + numScales * 3)
+            {
+                LOGERROR("Mismatching compressed data size in animation track " + newTrack.name_);
+                tracks_.Clear();
+                return false;
+            }
+            newTrack.keyData_.Resize(dataSize);
+            if (dataSize)
+                source.Read(&newTrack.keyData_[0], dataSize * sizeof(unsigned short));
+            newTrack.compressed_ = true;
+            continue;
+        }
+        
         unsigned keyFrames = source.ReadUInt();
         newTrack.keyFrames_.Resize(keyFrames);
-        memoryUse += keyFrames * sizeof(AnimationKeyFrame);
         
         // Read keyframes of the track
         for (unsigned j = 0; j < keyFrames; ++j)
@@ -140,18 +475,17 @@ bool Animation::Load(Deserializer& source)
             
             triggerElem = triggerElem.GetNext("trigger");
         }
-
-        memoryUse += triggers_.Size() * sizeof(AnimationTriggerPoint);
     }
     
-    SetMemoryUse(memoryUse);
+    UpdateMemoryUse();
     return true;
 }
 
 bool Animation::Save(Serializer& dest) const
 {
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    bool compressed = IsCompressed();
+    dest.WriteFileID(compressed ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
     
@@ -159,6 +493,40 @@ bool Animation::Save(Serializer& dest) const
     dest.WriteUInt(tracks_.Size());
     for (unsigned i = 0; i < tracks_.Size(); ++i)
     {
+        if (compressed)
+        {
+            // Tracks that were left uncompressed are compressed losslessly, apart from the quantization
+            const AnimationTrack* track = &tracks_[i];
+            AnimationTrack compressedTrack;
+            if (!track->compressed_)
+            {
+                compressedTrack = *track;
+                compressedTrack.Compress(0.0f, 0.0f, 0.0f);
+                track = &compressedTrack;
+            }
+            
+            dest.WriteString(track->name_);
+            dest.WriteUByte(track->channelMask_);
+            dest.WriteUByte(track->constantMask_);
+            dest.WriteUInt(track->keyTimes_.Size());
+            if (track->keyTimes_.Size())
+                dest.Write(&track->keyTimes_[0], track->keyTimes_.Size() * sizeof(float));
+            if (track->channelMask_ & CHANNEL_POSITION)
+            {
+                dest.WriteVector3(track->positionMin_);
+                dest.WriteVector3(track->positionStep_);
+            }
+            if (track->channelMask_ & CHANNEL_SCALE)
+            {
+                dest.WriteVector3(track->scaleMin_);
+                dest.WriteVector3(track->scaleStep_);
+            }
+            dest.WriteUInt(track->keyData_.Size());
+            if (track->keyData_.Size())
+                dest.Write(&track->keyData_[0], track->keyData_.Size() * sizeof(unsigned short));
+            continue;
+        }
+        
         const AnimationTrack& track = tracks_[i];
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
@@ -222,6 +590,16 @@ void Animation::SetTracks(const Vector<AnimationTrack>& tracks)
     tracks_ = tracks;
 }
 
+void Animation::Compress(float positionError, float rotationError, float scaleError)
+{
+    PROFILE(CompressAnimation);
+    
+    for (Vector<AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->Compress(positionError, rotationError, scaleError);
+    
+    UpdateMemoryUse();
+}
+
 void Animation::AddTrigger(float time, bool timeIsNormalized, const Variant& data)
 {
     AnimationTriggerPoint newTrigger;
@@ -275,4 +653,25 @@ const AnimationTrack* Animation::GetTrack(StringHash nameHash) const
     return 0;
 }
 
+bool Animation::IsCompressed() const
+{
+    for (Vector<AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        if (i->compressed_)
+            return true;
+    }
+    
+    return false;
+}
+
+void Animation::UpdateMemoryUse()
+{
+    unsigned memoryUse = sizeof(Animation) + tracks_.Size() * sizeof(AnimationTrack) + triggers_.Size() *
+        sizeof(AnimationTriggerPoint);
+    for (Vector<AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        memoryUse += i->GetDataSize();
+    
+    SetMemoryUse(memoryUse);
+}
+
 }
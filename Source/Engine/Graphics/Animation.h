@@ -43,11 +43,28 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
-/// Skeletal animation track, stores keyframes of a single bone.
-struct AnimationTrack
+/// Skeletal animation track, stores keyframes of a single bone. The keyframes are either stored as full keyframe structures, or after compression as a shared key time array and quantized channel data laid out one channel after another.
+struct URHO3D_API AnimationTrack
 {
+    /// Construct.
+    AnimationTrack();
+    
     /// Return keyframe index based on time and previous index.
     void GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Sample the channels at time position, using and updating the previous keyframe index. Only the channels in the channel mask are written.
+    void Sample(float time, float length, bool looped, unsigned& index, Vector3& position, Quaternion& rotation, Vector3& scale) const;
+    /// Return a keyframe, decoding it if compressed.
+    void GetKeyFrame(unsigned index, AnimationKeyFrame& dest) const;
+    /// Remove keyframes that can be interpolated from their neighbours within the error tolerances, quantize the channels and release the keyframe structures. Rotation error is an angle in radians.
+    void Compress(float positionError, float rotationError, float scaleError);
+    /// Return number of keyframes.
+    unsigned GetNumKeyFrames() const { return compressed_ ? keyTimes_.Size() : keyFrames_.Size(); }
+    /// Return keyframe time.
+    float GetKeyFrameTime(unsigned index) const { return compressed_ ? keyTimes_[index] : keyFrames_[index].time_; }
+    /// Return whether is compressed.
+    bool IsCompressed() const { return compressed_; }
+    /// Return memory use of the keyframe data in bytes.
+    unsigned GetDataSize() const;
     
     /// Bone name.
     String name_;
@@ -55,8 +72,28 @@ struct AnimationTrack
     StringHash nameHash_;
     /// Bitmask of included data (position, rotation, scale.)
     unsigned char channelMask_;
-    /// Keyframes.
+    /// Keyframes when not compressed. Empty after compression, so use GetKeyFrame() to access the keyframes of any track.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Keyframe times when compressed.
+    PODVector<float> keyTimes_;
+    /// Quantized channel data when compressed: positions, rotations and scales, three values per keyframe or only one set for a constant channel.
+    PODVector<unsigned short> keyData_;
+    /// Minimum of quantized positions.
+    Vector3 positionMin_;
+    /// Quantization step of positions.
+    Vector3 positionStep_;
+    /// Minimum of quantized scales.
+    Vector3 scaleMin_;
+    /// Quantization step of scales.
+    Vector3 scaleStep_;
+    /// Bitmask of channels that are stored only once.
+    unsigned char constantMask_;
+    /// Offset of the rotations in the quantized data.
+    unsigned rotationOffset_;
+    /// Offset of the scales in the quantized data.
+    unsigned scaleOffset_;
+    /// Compressed flag.
+    bool compressed_;
 };
 
 /// %Animation trigger point.
@@ -102,6 +139,8 @@ public:
     void SetLength(float length);
     /// Set all animation tracks.
     void SetTracks(const Vector<AnimationTrack>& tracks);
+    /// Compress all animation tracks with the given error tolerances. Rotation error is an angle in radians.
+    void Compress(float positionError = 0.001f, float rotationError = 0.001f, float scaleError = 0.001f);
     /// Add a trigger point.
     void AddTrigger(float time, bool timeIsNormalized, const Variant& data);
     /// Remove a trigger point by index.
@@ -131,8 +170,13 @@ public:
     const Vector<AnimationTriggerPoint>& GetTriggers() const { return triggers_; }
     /// Return number of animation trigger points.
     unsigned GetNumTriggers() const {return triggers_.Size(); }
+    /// Return whether any track is compressed.
+    bool IsCompressed() const;
     
 private:
+    /// Recalculate the memory use.
+    void UpdateMemoryUse();
+    
     /// Animation name.
     String animationName_;
     /// Animation name hash.
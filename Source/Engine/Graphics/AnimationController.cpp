@@ -74,7 +74,7 @@ void AnimationController::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(AnimationController, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(AnimationController, HandleScenePostUpdate));
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -754,7 +754,7 @@ void AnimationController::OnNodeSet(Node* node)
     {
         Scene* scene = GetScene();
         if (scene && IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(AnimationController, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(AnimationController, HandleScenePostUpdate));
     }
 }
 
@@ -822,11 +822,9 @@ void AnimationController::FindAnimation(const String& name, unsigned& index, Ani
     }
 }
 
-void AnimationController::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void AnimationController::HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
-    using namespace ScenePostUpdate;
-    
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 }
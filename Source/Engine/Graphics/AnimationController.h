@@ -31,6 +31,7 @@ namespace Urho3D
 class AnimatedModel;
 class Animation;
 class AnimationState;
+class SceneUpdateEvent;
 struct Bone;
 
 /// Control data for an animation.
@@ -183,7 +184,7 @@ private:
     /// Find the internal index and animation state of an animation.
     void FindAnimation(const String& name, unsigned& index, AnimationState*& state) const;
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData);
     
     /// Animation control structures.
     Vector<AnimationControl> animations_;
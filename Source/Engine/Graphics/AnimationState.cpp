@@ -34,9 +34,27 @@
 namespace Urho3D
 {
 
+/// Return whether a bone is a descendant of another bone, according to the skeleton's parent indices.
+static bool IsDescendantBone(const Vector<Bone>& bones, unsigned index, unsigned ancestorIndex)
+{
+    // Limit the walk to the number of bones in case of a malformed hierarchy
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        unsigned parentIndex = bones[index].parentIndex_;
+        if (parentIndex == index || parentIndex >= bones.Size())
+            return false;
+        if (parentIndex == ancestorIndex)
+            return true;
+        index = parentIndex;
+    }
+    
+    return false;
+}
+
 AnimationStateTrack::AnimationStateTrack() :
     track_(0),
     bone_(0),
+    boneIndex_(M_MAX_UNSIGNED),
     weight_(1.0f),
     keyFrame_(0)
 {
@@ -128,9 +146,14 @@ void AnimationState::SetStartBone(Bone* startBone)
     const Vector<AnimationTrack>& tracks = animation_->GetTracks();
     stateTracks_.Clear();
     
-    if (!startBone->node_)
+    // In pose buffer mode the bones do not need nodes, and the child bones are found from the skeleton instead
+    bool usePoseBuffer = model_->GetUsePoseBuffer();
+    if (!startBone->node_ && !usePoseBuffer)
         return;
     
+    const Vector<Bone>& bones = skeleton.GetBones();
+    unsigned startIndex = startBone - &bones[0];
+    
     for (unsigned i = 0; i < tracks.Size(); ++i)
     {
         AnimationStateTrack stateTrack;
@@ -142,6 +165,12 @@ void AnimationState::SetStartBone(Bone* startBone)
         
         if (nameHash == startBone->nameHash_)
             trackBone = startBone;
+        else if (usePoseBuffer)
+        {
+            Bone* bone = skeleton.GetBone(nameHash);
+            if (bone && IsDescendantBone(bones, bone - &bones[0], startIndex))
+                trackBone = bone;
+        }
         else
         {
             Node* trackBoneNode = startBone->node_->GetChild(nameHash, true);
@@ -149,10 +178,12 @@ void AnimationState::SetStartBone(Bone* startBone)
                 trackBone = skeleton.GetBone(nameHash);
         }
         
-        if (trackBone && trackBone->node_)
+        if (trackBone && (trackBone->node_ || usePoseBuffer))
         {
             stateTrack.bone_ = trackBone;
-            stateTrack.node_ = trackBone->node_;
+            stateTrack.boneIndex_ = trackBone - &bones[0];
+            if (!usePoseBuffer)
+                stateTrack.node_ = trackBone->node_;
             stateTracks_.Push(stateTrack);
         }
     }
@@ -220,6 +251,16 @@ void AnimationState::SetBoneWeight(unsigned index, float weight, bool recursive)
                     SetBoneWeight(childTrackIndex, weight, true);
             }
         }
+        // In pose buffer mode there are no bone nodes, so find the child bones' tracks from the parent indices
+        else if (stateTracks_[index].bone_)
+        {
+            unsigned boneIndex = stateTracks_[index].boneIndex_;
+            for (unsigned i = 0; i < stateTracks_.Size(); ++i)
+            {
+                if (i != index && stateTracks_[i].bone_ && stateTracks_[i].bone_->parentIndex_ == boneIndex)
+                    SetBoneWeight(i, weight, true);
+            }
+        }
     }
 }
 
@@ -345,6 +386,10 @@ unsigned AnimationState::GetTrackIndex(const String& name) const
         Node* node = stateTracks_[i].node_;
         if (node && node->GetName() == name)
             return i;
+        // In pose buffer mode the tracks only have bones
+        Bone* bone = stateTracks_[i].bone_;
+        if (!node && bone && bone->name_ == name)
+            return i;
     }
     
     return M_MAX_UNSIGNED;
@@ -368,6 +413,9 @@ unsigned AnimationState::GetTrackIndex(StringHash nameHash) const
         Node* node = stateTracks_[i].node_;
         if (node && node->GetNameHash() == nameHash)
             return i;
+        Bone* bone = stateTracks_[i].bone_;
+        if (!node && bone && bone->nameHash_ == nameHash)
+            return i;
     }
 
     return M_MAX_UNSIGNED;
@@ -378,19 +426,41 @@ float AnimationState::GetLength() const
     return animation_ ? animation_->GetLength() : 0.0f;
 }
 
+bool AnimationState::HasCustomBoneWeights() const
+{
+    for (Vector<AnimationStateTrack>::ConstIterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
+    {
+        if (i->weight_ != 1.0f)
+            return true;
+    }
+    
+    return false;
+}
+
 void AnimationState::Apply()
 {
     if (!animation_ || !IsEnabled())
         return;
     
     if (model_)
-        ApplyToModel();
+        ApplyToModel(time_);
     else
         ApplyToNodes();
 }
 
-void AnimationState::ApplyToModel()
+void AnimationState::ApplyToPose(float time)
+{
+    if (!animation_ || !IsEnabled() || !model_ || !model_->GetUsePoseBuffer())
+        return;
+    
+    ApplyToModel(time);
+}
+
+void AnimationState::ApplyToModel(float time)
 {
+    // In pose buffer mode write to the model's bone arrays instead of the bone nodes
+    bool usePoseBuffer = model_->GetUsePoseBuffer();
+    
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
     {
         AnimationStateTrack& stateTrack = *i;
@@ -400,7 +470,9 @@ void AnimationState::ApplyToModel()
         if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
             continue;
         
-        if (Equals(finalWeight, 1.0f))
+        if (usePoseBuffer)
+            ApplyTrackToPose(stateTrack, finalWeight, time);
+        else if (Equals(finalWeight, 1.0f))
             ApplyTrackFullWeight(stateTrack);
         else
             ApplyTrackBlended(stateTrack, finalWeight);
@@ -419,55 +491,21 @@ void AnimationState::ApplyTrackFullWeight(AnimationStateTrack& stateTrack)
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
     
-    if (track->keyFrames_.Empty() || !node)
+    if (!track->GetNumKeyFrames() || !node)
         return;
     
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-    
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, position, rotation, scale);
     
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
     unsigned char channelMask = track->channelMask_;
-    
-    if (!interpolate)
-    {
-        // No interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(keyFrame->position_);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(keyFrame->rotation_);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(keyFrame->scale_);
-    }
-    else
-    {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-        
-        // Interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(keyFrame->position_.Lerp(nextKeyFrame->position_, t));
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t));
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(keyFrame->scale_.Lerp(nextKeyFrame->scale_, t));
-    }
+    if (channelMask & CHANNEL_POSITION)
+        node->SetPosition(position);
+    if (channelMask & CHANNEL_ROTATION)
+        node->SetRotation(rotation);
+    if (channelMask & CHANNEL_SCALE)
+        node->SetScale(scale);
 }
 
 void AnimationState::ApplyTrackBlended(AnimationStateTrack& stateTrack, float weight)
@@ -475,63 +513,55 @@ void AnimationState::ApplyTrackBlended(AnimationStateTrack& stateTrack, float we
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
     
-    if (track->keyFrames_.Empty() || !node)
+    if (!track->GetNumKeyFrames() || !node)
         return;
     
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, position, rotation, scale);
     
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
-    
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
+    // Blend between old transform & animation
     unsigned char channelMask = track->channelMask_;
+    if (channelMask & CHANNEL_POSITION)
+        node->SetPosition(node->GetPosition().Lerp(position, weight));
+    if (channelMask & CHANNEL_ROTATION)
+        node->SetRotation(node->GetRotation().Slerp(rotation, weight));
+    if (channelMask & CHANNEL_SCALE)
+        node->SetScale(node->GetScale().Lerp(scale, weight));
+}
+
+void AnimationState::ApplyTrackToPose(AnimationStateTrack& stateTrack, float weight, float time)
+{
+    const AnimationTrack* track = stateTrack.track_;
+    unsigned index = stateTrack.boneIndex_;
+    
+    if (!track->GetNumKeyFrames() || index >= model_->bonePositions_.Size())
+        return;
+    
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    track->Sample(time, animation_->GetLength(), looped_, stateTrack.keyFrame_, position, rotation, scale);
     
-    if (!interpolate)
+    unsigned char channelMask = track->channelMask_;
+    if (Equals(weight, 1.0f))
     {
-        // No interpolation, blend between old transform & animation
         if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(node->GetPosition().Lerp(keyFrame->position_, weight));
+            model_->bonePositions_[index] = position;
         if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(node->GetRotation().Slerp(keyFrame->rotation_, weight));
+            model_->boneRotations_[index] = rotation;
         if (channelMask & CHANNEL_SCALE)
-            node->SetScale(node->GetScale().Lerp(keyFrame->scale_, weight));
+            model_->boneScales_[index] = scale;
     }
     else
     {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-        
-        // Interpolation, blend between old transform & animation
         if (channelMask & CHANNEL_POSITION)
-        {
-            node->SetPosition(node->GetPosition().Lerp(
-                keyFrame->position_.Lerp(nextKeyFrame->position_, t), weight));
-        }
+            model_->bonePositions_[index] = model_->bonePositions_[index].Lerp(position, weight);
         if (channelMask & CHANNEL_ROTATION)
-        {
-            node->SetRotation(node->GetRotation().Slerp(
-                keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t), weight));
-        }
+            model_->boneRotations_[index] = model_->boneRotations_[index].Slerp(rotation, weight);
         if (channelMask & CHANNEL_SCALE)
-        {
-            node->SetScale(node->GetScale().Lerp(
-                keyFrame->scale_.Lerp(nextKeyFrame->scale_, t), weight));
-        }
+            model_->boneScales_[index] = model_->boneScales_[index].Lerp(scale, weight);
     }
 }
 
@@ -48,6 +48,8 @@ struct AnimationStateTrack
     const AnimationTrack* track_;
     /// Bone pointer.
     Bone* bone_;
+    /// Bone index in the skeleton.
+    unsigned boneIndex_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
     /// Blending weight.
@@ -120,19 +122,25 @@ public:
     float GetLength() const;
     /// Return blending layer.
     unsigned char GetLayer() const { return layer_; }
+    /// Return whether any per-bone blending weight differs from the default 1.0.
+    bool HasCustomBoneWeights() const;
     
     /// Apply the animation at the current time position.
     void Apply();
+    /// Apply the animation to the model's pose buffer at the given time position, without changing the state's time position. Used by the shared pose cache.
+    void ApplyToPose(float time);
     
 private:
     /// Apply animation to a skeleton.
-    void ApplyToModel();
+    void ApplyToModel(float time);
     /// Apply animation to a scene node hierarchy.
     void ApplyToNodes();
     /// Apply animation track to a scene node, full weight.
     void ApplyTrackFullWeight(AnimationStateTrack& stateTrack);
     /// Apply animation track to a scene node, blended with current node transform.
     void ApplyTrackBlended(AnimationStateTrack& stateTrack, float weight);
+    /// Apply animation track to the model's pose buffer, blended with the current pose.
+    void ApplyTrackToPose(AnimationStateTrack& stateTrack, float weight, float time);
     
     /// Animated model (model mode.)
     WeakPtr<AnimatedModel> model_;
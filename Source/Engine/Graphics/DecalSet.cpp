@@ -1134,7 +1134,7 @@ void DecalSet::UpdateEventSubscription(bool checkAllDecals)
     
     if (enabled && !subscribed_)
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(DecalSet, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(DecalSet, HandleScenePostUpdate));
         subscribed_ = true;
     }
     else if (!enabled && subscribed_)
@@ -1144,11 +1144,9 @@ void DecalSet::UpdateEventSubscription(bool checkAllDecals)
     }
 }
 
-void DecalSet::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void DecalSet::HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
-    using namespace ScenePostUpdate;
-    
-    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    float timeStep = eventData.timeStep_;
     
     for (List<Decal>::Iterator i = decals_.Begin(); i != decals_.End();)
     {
@@ -31,6 +31,7 @@ namespace Urho3D
 {
 
 class IndexBuffer;
+class SceneUpdateEvent;
 class VertexBuffer;
 
 /// %Decal vertex.
@@ -198,7 +199,7 @@ private:
     /// Subscribe/unsubscribe from scene post-update as necessary.
     void UpdateEventSubscription(bool checkAllDecals);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData);
     
     /// Geometry.
     SharedPtr<Geometry> geometry_;
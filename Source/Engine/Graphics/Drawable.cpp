@@ -80,7 +80,8 @@ Drawable::Drawable(Context* context, unsigned char drawableFlags) :
     octant_(0),
     firstLight_(0),
     zone_(0),
-    zoneDirty_(false)
+    zoneDirty_(false),
+    zoneTemporary_(false)
 {
 }
 
@@ -179,6 +180,9 @@ void Drawable::SetLodBias(float bias)
 void Drawable::SetViewMask(unsigned mask)
 {
     viewMask_ = mask;
+    // Octree queries filter by the view mask, so their cached results must not be reused
+    if (octant_)
+        octant_->MarkDrawablesChanged();
     MarkNetworkUpdate();
 }
 
@@ -199,6 +203,9 @@ void Drawable::SetZoneMask(unsigned mask)
     zoneMask_ = mask;
     // Mark dirty to reset cached zone
     OnMarkedDirty(node_);
+    // Zones are found for the drawables from the zone query results, so those must not be reused
+    if (octant_)
+        octant_->MarkDrawablesChanged();
     MarkNetworkUpdate();
 }
 
@@ -211,12 +218,16 @@ void Drawable::SetMaxLights(unsigned num)
 void Drawable::SetCastShadows(bool enable)
 {
     castShadows_ = enable;
+    if (octant_)
+        octant_->MarkDrawablesChanged();
     MarkNetworkUpdate();
 }
 
 void Drawable::SetOccluder(bool enable)
 {
     occluder_ = enable;
+    if (octant_)
+        octant_->MarkDrawablesChanged();
     MarkNetworkUpdate();
 }
 
@@ -274,6 +285,7 @@ void Drawable::SetZone(Zone* zone, bool temporary)
 
     // If the zone assignment was temporary (inconclusive) set the dirty flag so that it will be re-evaluated on the next frame
     zoneDirty_ = temporary;
+    zoneTemporary_ = temporary;
 }
 
 void Drawable::SetSortValue(float value)
@@ -358,7 +370,10 @@ void Drawable::OnMarkedDirty(Node* node)
 
     // Mark zone assignment dirty when transform changes
     if (node == node_)
+    {
         zoneDirty_ = true;
+        zoneTemporary_ = false;
+    }
 }
 
 void Drawable::AddToOctree()
@@ -117,6 +117,8 @@ public:
     
     /// Handle enabled/disabled state change.
     virtual void OnSetEnabled();
+    /// Prepare for a threaded octree raycast. Called from the main thread before ProcessRayQuery() is called from a worker thread.
+    virtual void PrepareRayQuery(const RayOctreeQuery& query) {}
     /// Process octree raycast. May be called from a worker thread.
     virtual void ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results);
     /// Update before octree reinsertion. Is called from a worker thread.
@@ -218,6 +220,8 @@ public:
     Zone* GetZone() const { return zone_; }
     /// Return whether current zone is inconclusive or dirty due to the drawable moving.
     bool IsZoneDirty() const { return zoneDirty_; }
+    /// Return whether the zone assignment is inconclusive, and the drawable has not moved since.
+    bool IsZoneTemporary() const { return zoneTemporary_; }
     /// Return distance from camera.
     float GetDistance() const { return distance_; }
     /// Return LOD scaled distance from camera.
@@ -338,6 +342,8 @@ protected:
     Zone* zone_;
     /// Zone inconclusive or dirtied flag.
     bool zoneDirty_;
+    /// Zone inconclusive flag.
+    bool zoneTemporary_;
     /// Set of cameras from which is seen on the current frame.
     HashSet<Camera*> viewCameras_;
 };
@@ -43,6 +43,9 @@ namespace Urho3D
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
 static const int RAYCASTS_PER_WORK_ITEM = 4;
+static const unsigned MIN_THREADED_REINSERTIONS = 256;
+static const unsigned MIN_THREADED_PACKED_BOX_UPDATES = 64;
+static const unsigned PACKED_QUERY_BATCH_SIZE = 64;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
@@ -62,6 +65,16 @@ void RaycastDrawablesWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+void MergeRaycastResults(void* aux, unsigned threadIndex)
+{
+    Octree* octree = reinterpret_cast<Octree*>(aux);
+    PODVector<RayQueryResult>& results = octree->rayQueryResults_[threadIndex];
+    PODVector<RayQueryResult>& dest = octree->rayQuery_->result_;
+    
+    dest.Insert(dest.End(), results.Begin(), results.End());
+    results.Clear();
+}
+
 void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
 {
     const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
@@ -81,6 +94,50 @@ void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex)
+{
+    Octree* octree = reinterpret_cast<Octree*>(item->aux_);
+    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
+    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+    Octant** dest = &octree->reinsertOctants_[start - octree->drawableUpdates_.Begin().ptr_];
+    
+    while (start != end)
+    {
+        Drawable* drawable = *start;
+        Octant* octant = drawable ? drawable->GetOctant() : 0;
+        // Skip if no octant or does not belong to this octree anymore
+        if (octant && octant->GetRoot() == octree)
+            *dest = octant->GetReinsertOctant(drawable, drawable->GetWorldBoundingBox());
+        else
+            *dest = 0;
+        ++start;
+        ++dest;
+    }
+}
+
+void GetDrawablesWork(const WorkItem* item, unsigned threadIndex)
+{
+    const Octree* octree = reinterpret_cast<const Octree*>(item->aux_);
+    OctreeQuery** start = reinterpret_cast<OctreeQuery**>(item->start_);
+    OctreeQuery** end = reinterpret_cast<OctreeQuery**>(item->end_);
+    
+    while (start != end)
+    {
+        OctreeQuery& query = **start++;
+        query.result_.Clear();
+        octree->GetDrawablesInternal(query, false);
+    }
+}
+
+void UpdatePackedBoxesWork(const WorkItem* item, unsigned threadIndex)
+{
+    Octant** start = reinterpret_cast<Octant**>(item->start_);
+    Octant** end = reinterpret_cast<Octant**>(item->end_);
+    
+    while (start != end)
+        (*start++)->UpdatePackedBoxes();
+}
+
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -91,7 +148,9 @@ Octant::Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* r
     numDrawables_(0),
     parent_(parent),
     root_(root),
-    index_(index)
+    index_(index),
+    version_(0),
+    packedBoxesDirty_(false)
 {
     Initialize(box);
 
@@ -103,6 +162,9 @@ Octant::~Octant()
 {
     if (root_)
     {
+        if (packedBoxesDirty_)
+            root_->packedBoxUpdates_.Remove(this);
+        
         // Remove the drawables (if any) from this octant to the root octant
         for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
         {
@@ -143,29 +205,28 @@ Octant* Octant::GetOrCreateChild(unsigned index)
         newMax.z_ = oldCenter.z_;
 
     children_[index] = new Octant(BoundingBox(newMin, newMax), level_ + 1, this, root_, index);
+    if (root_)
+        ++root_->structureVersion_;
     return children_[index];
 }
 
 void Octant::DeleteChild(unsigned index)
 {
     assert(index < NUM_OCTANTS);
-    delete children_[index];
-    children_[index] = 0;
+    if (children_[index])
+    {
+        delete children_[index];
+        children_[index] = 0;
+        if (root_)
+            ++root_->structureVersion_;
+    }
 }
 
 void Octant::InsertDrawable(Drawable* drawable)
 {
     const BoundingBox& box = drawable->GetWorldBoundingBox();
 
-    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
-    bool insertHere;
-    if (this == root_)
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
-    else
-        insertHere = CheckDrawableFit(box);
-
-    if (insertHere)
+    if (CheckInsertHere(drawable, box))
     {
         Octant* oldOctant = drawable->octant_;
         if (oldOctant != this)
@@ -177,14 +238,7 @@ void Octant::InsertDrawable(Drawable* drawable)
         }
     }
     else
-    {
-        Vector3 boxCenter = box.Center();
-        unsigned x = boxCenter.x_ < center_.x_ ? 0 : 1;
-        unsigned y = boxCenter.y_ < center_.y_ ? 0 : 2;
-        unsigned z = boxCenter.z_ < center_.z_ ? 0 : 4;
-
-        GetOrCreateChild(x + y + z)->InsertDrawable(drawable);
-    }
+        GetOrCreateChild(GetChildIndex(box.Center()))->InsertDrawable(drawable);
 }
 
 bool Octant::CheckDrawableFit(const BoundingBox& box) const
@@ -211,6 +265,78 @@ bool Octant::CheckDrawableFit(const BoundingBox& box) const
     return false;
 }
 
+bool Octant::CheckInsertHere(Drawable* drawable, const BoundingBox& box) const
+{
+    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
+    // Also if drawable is outside the root octant bounds, insert to root
+    if (this == root_)
+        return !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
+    else
+        return CheckDrawableFit(box);
+}
+
+Octant* Octant::GetReinsertOctant(Drawable* drawable, const BoundingBox& box)
+{
+    // Non-occludees are always inserted to the root
+    if (!drawable->IsOccludee())
+        return this != root_ ? root_ : 0;
+    // Skip if still fits this octant
+    if (cullingBox_.IsInside(box) == INSIDE && CheckDrawableFit(box))
+        return 0;
+    
+    // Walk up until the drawable is inside the culling bounds. The child octant chosen by the drawable's center then has the
+    // drawable inside its culling bounds too, so insertion can proceed down from here like from the root
+    Octant* octant = this;
+    while (octant != root_ && octant->cullingBox_.IsInside(box) != INSIDE)
+        octant = octant->parent_;
+    
+    // Walk down through the existing child octants. Missing child octants are created when the drawable is inserted
+    Vector3 boxCenter = box.Center();
+    while (!octant->CheckInsertHere(drawable, box))
+    {
+        Octant* child = octant->children_[octant->GetChildIndex(boxCenter)];
+        if (!child)
+            break;
+        octant = child;
+    }
+    
+    return octant;
+}
+
+void Octant::MarkPackedBoxesDirty()
+{
+    if (!packedBoxesDirty_ && root_ && root_->packedCulling_)
+    {
+        packedBoxesDirty_ = true;
+        root_->packedBoxUpdates_.Push(this);
+    }
+}
+
+void Octant::UpdatePackedBoxes()
+{
+    unsigned numDrawables = drawables_.Size();
+    packedBoxes_.Resize(((numDrawables + 3) >> 2) * PACKED_BOX_FLOATS);
+    packedBoxesDirty_ = false;
+    
+    if (!numDrawables)
+        return;
+    
+    float* dest = &packedBoxes_[0];
+    for (unsigned i = 0; i < numDrawables; ++i)
+    {
+        const BoundingBox& box = drawables_[i]->GetWorldBoundingBox();
+        unsigned lane = i & 3;
+        dest[lane] = box.min_.x_;
+        dest[lane + 4] = box.min_.y_;
+        dest[lane + 8] = box.min_.z_;
+        dest[lane + 12] = box.max_.x_;
+        dest[lane + 16] = box.max_.y_;
+        dest[lane + 20] = box.max_.z_;
+        if (lane == 3)
+            dest += PACKED_BOX_FLOATS;
+    }
+}
+
 void Octant::ResetRoot()
 {
     root_ = 0;
@@ -248,7 +374,7 @@ void Octant::Initialize(const BoundingBox& box)
     cullingBox_ = BoundingBox(worldBoundingBox_.min_ - halfSize_, worldBoundingBox_.max_ + halfSize_);
 }
 
-void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
+void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside, OctreeQueryCache* cache) const
 {
     if (this != root_)
     {
@@ -262,17 +388,126 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
         }
     }
 
-    if (drawables_.Size())
+    if (cache)
+    {
+        // Store also the octants without drawables, as they may get drawables without a change in the octree structure
+        OctreeQueryCacheEntry entry;
+        entry.octant_ = this;
+        entry.version_ = version_;
+        entry.start_ = query.result_.Size();
+        entry.numDrawables_ = drawables_.Size();
+        entry.inside_ = inside;
+        TestDrawables(query, inside);
+        entry.count_ = query.result_.Size() - entry.start_;
+        cache->octants_.Push(entry);
+        cache->numTested_ += entry.numDrawables_;
+    }
+    else
+        TestDrawables(query, inside);
+
+    for (unsigned i = 0; i < NUM_OCTANTS; ++i)
+    {
+        if (children_[i])
+            children_[i]->GetDrawablesInternal(query, inside, cache);
+    }
+}
+
+void Octant::GetCachedDrawablesInternal(OctreeQuery& query, OctreeQueryCache& cache) const
+{
+    PODVector<Drawable*>& result = query.result_;
+    result.Reserve(cache.drawables_.Size());
+    
+    // The octree structure and the query have not changed, so the same octants would be visited with the same result. Only
+    // the octants whose drawables have changed need to be tested again
+    for (PODVector<OctreeQueryCacheEntry>::Iterator i = cache.octants_.Begin(); i != cache.octants_.End(); ++i)
+    {
+        const Octant* octant = i->octant_;
+        unsigned start = result.Size();
+        
+        if (octant->version_ == i->version_)
+        {
+            if (i->count_)
+            {
+                result.Resize(start + i->count_);
+                memcpy(&result[start], &cache.drawables_[i->start_], i->count_ * sizeof(Drawable*));
+            }
+            cache.numSkipped_ += i->numDrawables_;
+        }
+        else
+        {
+            octant->TestDrawables(query, i->inside_);
+            i->version_ = octant->version_;
+            i->numDrawables_ = octant->drawables_.Size();
+            cache.numTested_ += i->numDrawables_;
+        }
+        
+        i->start_ = start;
+        i->count_ = result.Size() - start;
+    }
+}
+
+void Octant::TestDrawables(OctreeQuery& query, bool inside) const
+{
+    if (drawables_.Empty())
+        return;
+    
+    const Frustum* frustum = inside || packedBoxesDirty_ || packedBoxes_.Empty() ? 0 : query.GetCullingFrustum();
+    if (frustum)
+        GetPackedDrawablesInternal(query, *frustum);
+    else
     {
         Drawable** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
         query.TestDrawables(start, end, inside);
     }
+}
+
+void Octant::GetPackedDrawablesInternal(OctreeQuery& query, const Frustum& frustum) const
+{
+    Drawable** drawables = const_cast<Drawable**>(&drawables_[0]);
+    const float* boxes = &packedBoxes_[0];
+    unsigned numDrawables = drawables_.Size();
+    Drawable* inside[PACKED_QUERY_BATCH_SIZE];
+    unsigned numInside = 0;
+    
+    // Test four bounding boxes at a time, then let the query test the drawables that are inside as if their octant was
+    for (unsigned i = 0; i < numDrawables; i += 4, boxes += PACKED_BOX_FLOATS)
+    {
+        unsigned mask = frustum.IsInsideFast4(boxes);
+        // Mask out the unused boxes of the last group
+        if (numDrawables - i < 4)
+            mask &= (1 << (numDrawables - i)) - 1;
+        if (!mask)
+            continue;
+        
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            if (mask & (1 << j))
+                inside[numInside++] = drawables[i + j];
+        }
+        
+        if (numInside > PACKED_QUERY_BATCH_SIZE - 4)
+        {
+            query.TestDrawables(inside, inside + numInside, true);
+            numInside = 0;
+        }
+    }
+    
+    if (numInside)
+        query.TestDrawables(inside, inside + numInside, true);
+}
 
+void Octant::ResetPackedBoxes()
+{
+    packedBoxes_.Clear();
+    packedBoxesDirty_ = false;
+    if (!drawables_.Empty())
+        MarkPackedBoxesDirty();
+    
     for (unsigned i = 0; i < NUM_OCTANTS; ++i)
     {
         if (children_[i])
-            children_[i]->GetDrawablesInternal(query, inside);
+            children_[i]->ResetPackedBoxes();
     }
 }
 
@@ -333,7 +568,9 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, 0, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    structureVersion_(0),
+    packedCulling_(false)
 {
     // Resize threaded ray query intermediate result vector according to number of worker threads
     WorkQueue* workQueue = GetSubsystem<WorkQueue>();
@@ -345,6 +582,7 @@ Octree::~Octree()
     // Reset root pointer from all child octants now so that they do not move their drawables to root
     drawableUpdates_.Clear();
     drawableReinsertions_.Clear();
+    packedBoxUpdates_.Clear();
     ResetRoot();
 }
 
@@ -388,6 +626,28 @@ void Octree::SetSize(const BoundingBox& box, unsigned numLevels)
     Initialize(box);
     numDrawables_ = drawables_.Size();
     numLevels_ = Max((int)numLevels, 1);
+    ++structureVersion_;
+}
+
+void Octree::SetPackedCulling(bool enable)
+{
+    if (enable == packedCulling_)
+        return;
+    
+    packedCulling_ = enable;
+    packedBoxUpdates_.Clear();
+    ResetPackedBoxes();
+    // Pack the boxes immediately so that the setting takes effect for the next query. The octants of drawables already queued
+    // for update must stay dirty, as the drawables will not queue again when they change
+    ProcessPackedBoxUpdates();
+    if (packedCulling_)
+    {
+        for (PODVector<Drawable*>::Iterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+        {
+            if (*i && (*i)->GetOctant())
+                (*i)->GetOctant()->MarkPackedBoxesDirty();
+        }
+    }
 }
 
 void Octree::Update(const FrameInfo& frame)
@@ -403,30 +663,10 @@ void Octree::Update(const FrameInfo& frame)
         WorkQueue* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
         
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = drawableUpdates_.Size() / numWorkItems;
+        // Drawables vary in update cost (for example animated models), so let idle threads steal chunks from busy ones
+        queue->ParallelFor(UpdateDrawablesWork, drawableUpdates_.Begin().ptr_, drawableUpdates_.End().ptr_,
+            const_cast<FrameInfo*>(&frame));
         
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
     }
     
@@ -445,38 +685,13 @@ void Octree::Update(const FrameInfo& frame)
     // Reinsert drawables that have been moved or resized, or that have been newly added to the octree and do not sit inside
     // the proper octant yet
     if (!drawableUpdates_.Empty())
-    {
-        PROFILE(ReinsertToOctree);
-
-        for (PODVector<Drawable*>::Iterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
-        {
-            Drawable* drawable = *i;
-            drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
-
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetRoot() != this)
-                continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
-                continue;
-
-            InsertDrawable(drawable);
-
-            #ifdef _DEBUG
-            // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
-            if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
-            {
-                LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
-                    " octant box " + octant->GetCullingBox().ToString());
-            }
-            #endif
-        }
-    }
+        ReinsertDrawables();
     
     drawableUpdates_.Clear();
+    
+    // Pack the bounding boxes of the octants that have changed, now that the drawables are in their final octants
+    if (!packedBoxUpdates_.Empty())
+        ProcessPackedBoxUpdates();
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -503,6 +718,68 @@ void Octree::GetDrawables(OctreeQuery& query) const
     GetDrawablesInternal(query, false);
 }
 
+void Octree::GetDrawables(OctreeQuery& query, OctreeQueryCache& cache, bool repeat) const
+{
+    query.result_.Clear();
+    cache.numTested_ = 0;
+    cache.numSkipped_ = 0;
+    
+    if (repeat && cache.octree_ == this && cache.structureVersion_ == structureVersion_)
+        GetCachedDrawablesInternal(query, cache);
+    else
+    {
+        cache.octree_ = const_cast<Octree*>(this);
+        cache.structureVersion_ = structureVersion_;
+        cache.octants_.Clear();
+        GetDrawablesInternal(query, false, &cache);
+    }
+    
+    cache.drawables_ = query.result_;
+}
+
+void Octree::GetDrawables(OctreeQuery** queries, unsigned numQueries, PODVector<Drawable*>& result,
+    PODVector<unsigned>& offsets) const
+{
+    PROFILE(GetDrawablesBatch);
+    
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue->GetNumThreads() && numQueries > 1)
+    {
+        // Testing a drawable reads its world bounding box, which is recalculated on demand after its node has moved. Such
+        // drawables are queued for the next octree update, so recalculate their bounding boxes here in the main thread. Then the
+        // queries only read the octree and the drawables, and can run in parallel as long as they do not share result vectors
+        for (PODVector<Drawable*>::ConstIterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+            (*i)->GetWorldBoundingBox();
+        
+        queue->ParallelFor(GetDrawablesWork, queries, queries + numQueries, const_cast<Octree*>(this));
+    }
+    else
+    {
+        WorkItem item;
+        item.start_ = queries;
+        item.end_ = queries + numQueries;
+        item.aux_ = const_cast<Octree*>(this);
+        GetDrawablesWork(&item, 0);
+    }
+    
+    offsets.Resize(numQueries + 1);
+    unsigned numResults = 0;
+    for (unsigned i = 0; i < numQueries; ++i)
+    {
+        offsets[i] = numResults;
+        numResults += queries[i]->result_.Size();
+    }
+    offsets[numQueries] = numResults;
+    
+    result.Resize(numResults);
+    for (unsigned i = 0; i < numQueries; ++i)
+    {
+        const PODVector<Drawable*>& queryResult = queries[i]->result_;
+        if (!queryResult.Empty())
+            memcpy(&result[offsets[i]], &queryResult[0], queryResult.Size() * sizeof(Drawable*));
+    }
+}
+
 void Octree::Raycast(RayOctreeQuery& query) const
 {
     PROFILE(Raycast);
@@ -524,32 +801,13 @@ void Octree::Raycast(RayOctreeQuery& query) const
         // Check that amount of drawables is large enough to justify threading
         if (rayQueryDrawables_.Size() >= RAYCASTS_PER_WORK_ITEM * 2)
         {
-            for (unsigned i = 0; i < rayQueryResults_.Size(); ++i)
-                rayQueryResults_[i].Clear();
-
-            PODVector<Drawable*>::Iterator start = rayQueryDrawables_.Begin();
-            while (start != rayQueryDrawables_.End())
-            {
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = RaycastDrawablesWork;
-                item->aux_ = const_cast<Octree*>(this);
-
-                PODVector<Drawable*>::Iterator end = rayQueryDrawables_.End();
-                if (end - start > RAYCASTS_PER_WORK_ITEM)
-                    end = start + RAYCASTS_PER_WORK_ITEM;
-
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
-            }
+            // Update the state that the drawables would otherwise update on demand in the worker threads
+            for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
+                (*i)->PrepareRayQuery(query);
 
             // Merge per-thread results
-            queue->Complete(M_MAX_UNSIGNED);
-            for (unsigned i = 0; i < rayQueryResults_.Size(); ++i)
-                query.result_.Insert(query.result_.End(), rayQueryResults_[i].Begin(), rayQueryResults_[i].End());
+            queue->ParallelReduce(RaycastDrawablesWork, MergeRaycastResults, rayQueryDrawables_.Begin().ptr_,
+                rayQueryDrawables_.End().ptr_, const_cast<Octree*>(this), RAYCASTS_PER_WORK_ITEM);
         }
         else
         {
@@ -608,9 +866,15 @@ void Octree::QueueUpdate(Drawable* drawable)
     {
         MutexLock lock(octreeMutex_);
         drawableUpdates_.Push(drawable);
+        // The bounding box may change, so the drawable's octant must not reuse query results or test the packed box until
+        // updated
+        drawable->GetOctant()->MarkDrawablesChanged();
     }
     else
+    {
         drawableUpdates_.Push(drawable);
+        drawable->GetOctant()->MarkDrawablesChanged();
+    }
     
     drawable->updateQueued_ = true;
 }
@@ -621,6 +885,84 @@ void Octree::CancelUpdate(Drawable* drawable)
     drawable->updateQueued_ = false;
 }
 
+void Octree::ReinsertDrawables()
+{
+    PROFILE(ReinsertToOctree);
+    
+    // Find the octants to reinsert from. This only reads the octree, so it can be done in worker threads when there are many
+    // drawables
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    reinsertOctants_.Resize(drawableUpdates_.Size());
+    if (queue->GetNumThreads() && drawableUpdates_.Size() >= MIN_THREADED_REINSERTIONS)
+        queue->ParallelFor(ReinsertDrawablesWork, drawableUpdates_.Begin().ptr_, drawableUpdates_.End().ptr_, this);
+    else
+    {
+        WorkItem item;
+        item.start_ = drawableUpdates_.Begin().ptr_;
+        item.end_ = drawableUpdates_.End().ptr_;
+        item.aux_ = this;
+        ReinsertDrawablesWork(&item, 0);
+    }
+    
+    // Add the drawables to their new octants, creating child octants as necessary. Remove from the old octants only after all
+    // have been added, because an octant that becomes empty is deleted, and it may be the new octant of another drawable
+    for (unsigned i = 0; i < drawableUpdates_.Size(); ++i)
+    {
+        Drawable* drawable = drawableUpdates_[i];
+        if (!drawable)
+            continue;
+        
+        drawable->updateQueued_ = false;
+        Octant* octant = reinsertOctants_[i];
+        if (!octant)
+            continue;
+        
+        const BoundingBox& box = drawable->GetWorldBoundingBox();
+        while (!octant->CheckInsertHere(drawable, box))
+            octant = octant->GetOrCreateChild(octant->GetChildIndex(box.Center()));
+        
+        Octant* oldOctant = drawable->GetOctant();
+        if (octant != oldOctant)
+        {
+            octant->AddDrawable(drawable);
+            reinsertOctants_[i] = oldOctant;
+        }
+        else
+            reinsertOctants_[i] = 0;
+        
+        #ifdef _DEBUG
+        // Verify that the drawable will be culled correctly
+        if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
+        {
+            LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
+                " octant box " + octant->GetCullingBox().ToString());
+        }
+        #endif
+    }
+    
+    for (unsigned i = 0; i < drawableUpdates_.Size(); ++i)
+    {
+        if (reinsertOctants_[i])
+            reinsertOctants_[i]->RemoveDrawable(drawableUpdates_[i], false);
+    }
+}
+
+void Octree::ProcessPackedBoxUpdates()
+{
+    PROFILE(UpdatePackedBoxes);
+    
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue->GetNumThreads() && packedBoxUpdates_.Size() >= MIN_THREADED_PACKED_BOX_UPDATES)
+        queue->ParallelFor(UpdatePackedBoxesWork, packedBoxUpdates_.Begin().ptr_, packedBoxUpdates_.End().ptr_, 0);
+    else
+    {
+        for (PODVector<Octant*>::Iterator i = packedBoxUpdates_.Begin(); i != packedBoxUpdates_.End(); ++i)
+            (*i)->UpdatePackedBoxes();
+    }
+    
+    packedBoxUpdates_.Clear();
+}
+
 void Octree::DrawDebugGeometry(bool depthTest)
 {
     DebugRenderer* debug = GetComponent<DebugRenderer>();
@@ -31,9 +31,11 @@ namespace Urho3D
 {
 
 class Octree;
+struct OctreeQueryCache;
 
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
+static const unsigned PACKED_BOX_FLOATS = 24;
 
 /// %Octree octant
 class URHO3D_API Octant
@@ -52,12 +54,17 @@ public:
     void InsertDrawable(Drawable* drawable);
     /// Check if a drawable object fits.
     bool CheckDrawableFit(const BoundingBox& box) const;
+    /// Check if a drawable object should be inserted to this octant instead of a child octant.
+    bool CheckInsertHere(Drawable* drawable, const BoundingBox& box) const;
+    /// Return the octant to reinsert a moved drawable object from, by walking up from this octant until its bounds contain the drawable, then down through the existing child octants. Return null if the drawable can stay in this octant. Does not modify the octree, so can be called from worker threads.
+    Octant* GetReinsertOctant(Drawable* drawable, const BoundingBox& box);
     
     /// Add a drawable object to this octant.
     void AddDrawable(Drawable* drawable)
     {
         drawable->SetOctant(this);
         drawables_.Push(drawable);
+        MarkDrawablesChanged();
         IncDrawableCount();
     }
     
@@ -66,6 +73,7 @@ public:
     {
         if (drawables_.Remove(drawable))
         {
+            MarkDrawablesChanged();
             if (resetOctant)
                 drawable->SetOctant(0);
             DecDrawableCount();
@@ -84,9 +92,29 @@ public:
     Octree* GetRoot() const { return root_; }
     /// Return number of drawables.
     unsigned GetNumDrawables() const { return numDrawables_; }
+    /// Return version number, which changes whenever the drawable objects of this octant are added, removed or updated.
+    unsigned GetVersion() const { return version_; }
+    /// Return child octant index for a position.
+    unsigned GetChildIndex(const Vector3& position) const
+    {
+        unsigned x = position.x_ < center_.x_ ? 0 : 1;
+        unsigned y = position.y_ < center_.y_ ? 0 : 2;
+        unsigned z = position.z_ < center_.z_ ? 0 : 4;
+        return x + y + z;
+    }
     /// Return true if there are no drawable objects in this octant and child octants.
     bool IsEmpty() { return numDrawables_ == 0; }
     
+    /// Mark the drawable objects changed: change the version number and mark the packed bounding boxes dirty.
+    void MarkDrawablesChanged()
+    {
+        ++version_;
+        MarkPackedBoxesDirty();
+    }
+    /// Mark the packed drawable bounding boxes to need an update. Queries test the drawables one by one until then.
+    void MarkPackedBoxesDirty();
+    /// Update the packed drawable bounding boxes. Called internally.
+    void UpdatePackedBoxes();
     /// Reset root pointer recursively. Called when the whole octree is being destroyed.
     void ResetRoot();
     /// Draw bounds to the debug graphics recursively.
@@ -95,8 +123,16 @@ public:
 protected:
     /// Initialize bounding box.
     void Initialize(const BoundingBox& box);
-    /// Return drawable objects by a query, called internally.
-    void GetDrawablesInternal(OctreeQuery& query, bool inside) const;
+    /// Return drawable objects by a query, optionally storing the results of each octant to a cache, called internally.
+    void GetDrawablesInternal(OctreeQuery& query, bool inside, OctreeQueryCache* cache = 0) const;
+    /// Return drawable objects by repeating a cached query, testing only the octants that have changed, called internally.
+    void GetCachedDrawablesInternal(OctreeQuery& query, OctreeQueryCache& cache) const;
+    /// Test the drawable objects of this octant only by a query, called internally.
+    void TestDrawables(OctreeQuery& query, bool inside) const;
+    /// Return drawable objects by a query by testing the packed bounding boxes against a frustum first, called internally.
+    void GetPackedDrawablesInternal(OctreeQuery& query, const Frustum& frustum) const;
+    /// Reset the packed drawable bounding boxes recursively, and mark them dirty if packed culling is enabled.
+    void ResetPackedBoxes();
     /// Return drawable objects by a ray query, called internally.
     void GetDrawablesInternal(RayOctreeQuery& query) const;
     /// Return drawable objects only for a threaded ray query, called internally.
@@ -132,6 +168,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// Drawable object world bounding boxes for vectorized frustum culling. Each group of four drawables stores four min X, Y, Z and max X, Y, Z coordinates.
+    PODVector<float> packedBoxes_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS];
     /// World bounding box center.
@@ -148,12 +186,20 @@ protected:
     Octree* root_;
     /// Octant index relative to its siblings or ROOT_INDEX for root octant
     unsigned index_;
+    /// Version number of the drawable objects.
+    unsigned version_;
+    /// Packed bounding boxes dirty flag.
+    bool packedBoxesDirty_;
 };
 
 /// %Octree component. Should be added only to the root scene node
 class URHO3D_API Octree : public Component, public Octant
 {
+    friend class Octant;
+    friend void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void GetDrawablesWork(const WorkItem* item, unsigned threadIndex);
     friend void RaycastDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void MergeRaycastResults(void* aux, unsigned threadIndex);
     
     OBJECT(Octree);
     
@@ -181,12 +227,22 @@ public:
     
     /// Return drawable objects by a query.
     void GetDrawables(OctreeQuery& query) const;
+    /// Return drawable objects by a query and store the results of each octant to a cache. If the query is a repeat of the cached query with the same parameters, test only the octants whose drawable objects have changed since and reuse the rest of the results.
+    void GetDrawables(OctreeQuery& query, OctreeQueryCache& cache, bool repeat) const;
+    /// Return drawable objects by several queries, executed in worker threads. Each query must have its own result vector. The results are also copied one query after another to a single vector, with the results of query i between offsets[i] and offsets[i + 1]. Can be called before or after the octree update, as the bounding boxes of moved drawables are updated first. Only call from the main thread.
+    void GetDrawables(OctreeQuery** queries, unsigned numQueries, PODVector<Drawable*>& result, PODVector<unsigned>& offsets) const;
     /// Return drawable objects by a ray query.
     void Raycast(RayOctreeQuery& query) const;
     /// Return the closest drawable object by a ray query.
     void RaycastSingle(RayOctreeQuery& query) const;
+    /// Set whether to cull drawable objects by testing their bounding boxes four at a time from packed per-octant arrays. The arrays are updated along with the octree, which costs time when drawable objects move.
+    void SetPackedCulling(bool enable);
     /// Return subdivision levels.
     unsigned GetNumLevels() const { return numLevels_; }
+    /// Return whether packed culling is enabled.
+    bool GetPackedCulling() const { return packedCulling_; }
+    /// Return structure version number, which changes whenever octants are created or deleted.
+    unsigned GetStructureVersion() const { return structureVersion_; }
     
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
@@ -196,10 +252,19 @@ public:
     void DrawDebugGeometry(bool depthTest);
     
 private:
+    /// Reinsert the updated drawable objects that have moved out of their octants.
+    void ReinsertDrawables();
+    /// Update the packed bounding boxes of the octants that have changed.
+    void ProcessPackedBoxUpdates();
+    
     /// Drawable objects that require update.
     PODVector<Drawable*> drawableUpdates_;
+    /// Octants to reinsert the updated drawable objects from, or null if they stay in their octants. Then the old octants to remove from.
+    PODVector<Octant*> reinsertOctants_;
     /// Drawable objects that require reinsertion.
     PODVector<Drawable*> drawableReinsertions_;
+    /// Octants with dirty packed bounding boxes.
+    PODVector<Octant*> packedBoxUpdates_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
     /// Current threaded ray query.
@@ -210,6 +275,55 @@ private:
     mutable Vector<PODVector<RayQueryResult> > rayQueryResults_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Structure version number.
+    unsigned structureVersion_;
+    /// Packed culling flag.
+    bool packedCulling_;
+};
+
+/// Cached octree query result of one octant.
+struct OctreeQueryCacheEntry
+{
+    /// Octant.
+    const Octant* octant_;
+    /// Octant version number when tested.
+    unsigned version_;
+    /// Index of the first result drawable object.
+    unsigned start_;
+    /// Number of result drawable objects.
+    unsigned count_;
+    /// Number of drawable objects tested.
+    unsigned numDrawables_;
+    /// Whether the octant was fully inside the query volume.
+    bool inside_;
+};
+
+/// Octree query results stored per octant, so that a repeated query only needs to test the octants that have changed.
+struct URHO3D_API OctreeQueryCache
+{
+    /// Construct.
+    OctreeQueryCache() :
+        structureVersion_(0),
+        numTested_(0),
+        numSkipped_(0)
+    {
+    }
+    
+    /// Reset so that the next query is performed in full.
+    void Reset() { octree_.Reset(); }
+    
+    /// Octree the results are from.
+    WeakPtr<Octree> octree_;
+    /// Octree structure version number when the results were stored.
+    unsigned structureVersion_;
+    /// Results of the visited octants in query order.
+    PODVector<OctreeQueryCacheEntry> octants_;
+    /// Result drawable objects.
+    PODVector<Drawable*> drawables_;
+    /// Number of drawable objects tested on the last query.
+    unsigned numTested_;
+    /// Number of drawable objects whose test was skipped on the last query.
+    unsigned numSkipped_;
 };
 
 }
@@ -55,6 +55,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Return frustum the octree may test packed drawable bounding boxes against before calling TestDrawables() with only the drawables inside, or null to always call TestDrawables() with all drawables.
+    virtual const Frustum* GetCullingFrustum() const { return 0; }
     
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -143,6 +145,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Return frustum for testing packed drawable bounding boxes.
+    virtual const Frustum* GetCullingFrustum() const { return &frustum_; }
     
     /// Frustum.
     Frustum frustum_;
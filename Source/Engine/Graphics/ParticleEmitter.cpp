@@ -156,7 +156,7 @@ void ParticleEmitter::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(ParticleEmitter, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(ParticleEmitter, HandleScenePostUpdate));
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -896,7 +896,7 @@ void ParticleEmitter::OnNodeSet(Node* node)
     {
         Scene* scene = GetScene();
         if (scene && IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(ParticleEmitter, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(ParticleEmitter, HandleScenePostUpdate));
     }
 }
 
@@ -1023,12 +1023,10 @@ void ParticleEmitter::GetVector3MinMax(const XMLElement& element, Vector3& minVa
     }
 }
 
-void ParticleEmitter::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void ParticleEmitter::HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
     // Store scene's timestep and use it instead of global timestep, as time scale may be other than 1
-    using namespace ScenePostUpdate;
-    
-    lastTimeStep_ = eventData[P_TIMESTEP].GetFloat();
+    lastTimeStep_ = eventData.timeStep_;
     
     // If no invisible update, check that the billboardset is in view (framenumber has changed)
     if (updateInvisible_ || viewFrameNumber_ != lastUpdateFrameNumber_)
@@ -113,6 +113,7 @@ struct TextureFrame
     float time_;
 };
 
+class SceneUpdateEvent;
 class XMLFile;
 class XMLElement;
 
@@ -304,7 +305,7 @@ protected:
     
 private:
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData);
     
     /// Particles.
     PODVector<Particle> particles_;
@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "PoseCache.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static unsigned HashKey(const PODVector<unsigned>& key)
+{
+    unsigned hash = 0;
+    for (PODVector<unsigned>::ConstIterator i = key.Begin(); i != key.End(); ++i)
+        hash = *i + (hash << 6) + (hash << 16) - hash;
+    return hash;
+}
+
+PoseCache::PoseCache() :
+    timeStep_(1.0f / 60.0f),
+    maxPoses_(1024),
+    numHits_(0),
+    numMisses_(0)
+{
+}
+
+PoseCache::~PoseCache()
+{
+}
+
+void PoseCache::SetTimeStep(float step)
+{
+    MutexLock lock(poseMutex_);
+    
+    // The cached poses were sampled with the old step, but they remain valid for the times they were calculated at
+    timeStep_ = Max(step, M_EPSILON);
+}
+
+void PoseCache::SetMaxPoses(unsigned num)
+{
+    MutexLock lock(poseMutex_);
+    
+    maxPoses_ = Max((int)num, 1);
+    if (poses_.Size() > maxPoses_)
+        poses_.Clear();
+}
+
+void PoseCache::Clear()
+{
+    MutexLock lock(poseMutex_);
+    
+    poses_.Clear();
+}
+
+void PoseCache::ResetStats()
+{
+    MutexLock lock(poseMutex_);
+    
+    numHits_ = 0;
+    numMisses_ = 0;
+}
+
+bool PoseCache::GetPose(const PODVector<unsigned>& key, unsigned frameNumber, PODVector<Matrix3x4>& dest)
+{
+    MutexLock lock(poseMutex_);
+    
+    HashMap<unsigned, PoseCacheEntry>::Iterator i = poses_.Find(HashKey(key));
+    if (i != poses_.End() && i->second_.key_ == key)
+    {
+        i->second_.lastUsedFrame_ = frameNumber;
+        dest = i->second_.boneTransforms_;
+        ++numHits_;
+        return true;
+    }
+    
+    ++numMisses_;
+    return false;
+}
+
+void PoseCache::StorePose(const PODVector<unsigned>& key, unsigned frameNumber, const PODVector<Matrix3x4>& boneTransforms)
+{
+    MutexLock lock(poseMutex_);
+    
+    // Another worker thread may have calculated the same pose meanwhile. On a hash collision keep the existing pose
+    unsigned hash = HashKey(key);
+    if (poses_.Contains(hash))
+        return;
+    
+    // When full, discard the poses that have not been used on this frame. If that is not enough, do not cache
+    if (poses_.Size() >= maxPoses_)
+    {
+        for (HashMap<unsigned, PoseCacheEntry>::Iterator i = poses_.Begin(); i != poses_.End();)
+        {
+            if (i->second_.lastUsedFrame_ != frameNumber)
+                i = poses_.Erase(i);
+            else
+                ++i;
+        }
+        
+        if (poses_.Size() >= maxPoses_)
+            return;
+    }
+    
+    PoseCacheEntry& entry = poses_[hash];
+    entry.key_ = key;
+    entry.boneTransforms_ = boneTransforms;
+    entry.lastUsedFrame_ = frameNumber;
+}
+
+unsigned PoseCache::GetNumPoses() const
+{
+    MutexLock lock(poseMutex_);
+    
+    return poses_.Size();
+}
+
+}
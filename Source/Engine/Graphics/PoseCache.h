@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+#include "Matrix3x4.h"
+#include "Mutex.h"
+#include "RefCounted.h"
+
+namespace Urho3D
+{
+
+/// Pose stored in the shared pose cache.
+struct PoseCacheEntry
+{
+    /// Key the pose was calculated for.
+    PODVector<unsigned> key_;
+    /// Bone transforms in model space.
+    PODVector<Matrix3x4> boneTransforms_;
+    /// Frame number the pose was last used on.
+    unsigned lastUsedFrame_;
+};
+
+/// Cache of skeleton poses shared between animated models in pose buffer mode. Models that play the same animations at the same quantized time positions calculate the pose only once and copy it from the cache. Accessed from the worker threads during the drawable update.
+class URHO3D_API PoseCache : public RefCounted
+{
+public:
+    /// Construct.
+    PoseCache();
+    /// Destruct.
+    ~PoseCache();
+    
+    /// Set the time quantization step in seconds. Animation time positions are rounded down to a multiple of it, so a larger step shares more poses at the cost of smoothness. Models using animation LOD quantize further in power of two multiples of the step.
+    void SetTimeStep(float step);
+    /// Set the maximum number of cached poses. When full, the poses not used on the current frame are discarded.
+    void SetMaxPoses(unsigned num);
+    /// Remove all cached poses. Should be called if an animation or a model's skeleton is modified after poses have been cached.
+    void Clear();
+    /// Reset the hit and miss counters.
+    void ResetStats();
+    
+    /// Copy a cached pose to the destination. Return true if found.
+    bool GetPose(const PODVector<unsigned>& key, unsigned frameNumber, PODVector<Matrix3x4>& dest);
+    /// Store a calculated pose.
+    void StorePose(const PODVector<unsigned>& key, unsigned frameNumber, const PODVector<Matrix3x4>& boneTransforms);
+    
+    /// Return the time quantization step.
+    float GetTimeStep() const { return timeStep_; }
+    /// Return the maximum number of cached poses.
+    unsigned GetMaxPoses() const { return maxPoses_; }
+    /// Return the number of cached poses.
+    unsigned GetNumPoses() const;
+    /// Return the number of poses found in the cache since the counters were reset.
+    unsigned GetNumHits() const { return numHits_; }
+    /// Return the number of poses that had to be calculated since the counters were reset.
+    unsigned GetNumMisses() const { return numMisses_; }
+    
+private:
+    /// Cached poses by key hash.
+    HashMap<unsigned, PoseCacheEntry> poses_;
+    /// Mutex for the worker thread access.
+    mutable Mutex poseMutex_;
+    /// Time quantization step.
+    float timeStep_;
+    /// Maximum number of cached poses.
+    unsigned maxPoses_;
+    /// Cache hit counter.
+    unsigned numHits_;
+    /// Cache miss counter.
+    unsigned numMisses_;
+};
+
+}
@@ -544,6 +544,17 @@ unsigned Renderer::GetNumOccluders(bool allViews) const
     return numOccluders;
 }
 
+unsigned Renderer::GetNumSkippedDrawables(bool allViews) const
+{
+    unsigned numSkipped = 0;
+    unsigned lastView = allViews ? numViews_ : 1;
+    
+    for (unsigned i = 0; i < lastView; ++i)
+        numSkipped += views_[i]->GetNumSkippedDrawables();
+    
+    return numSkipped;
+}
+
 void Renderer::Update(float timeStep)
 {
     PROFILE(UpdateViews);
@@ -268,6 +268,8 @@ public:
     unsigned GetNumShadowMaps(bool allViews = false) const;
     /// Return number of occluders rendered.
     unsigned GetNumOccluders(bool allViews = false) const;
+    /// Return number of drawables whose visibility test was skipped by reusing the previous frame's results.
+    unsigned GetNumSkippedDrawables(bool allViews = false) const;
     /// Return the default zone.
     Zone* GetDefaultZone() const { return defaultZone_; }
     /// Return the directional light for fullscreen quad rendering.
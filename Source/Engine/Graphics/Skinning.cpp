@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "GraphicsDefs.h"
+#include "Matrix3x4.h"
+#include "Model.h"
+#include "Skinning.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+#ifdef URHO3D_SSE_MATH
+/// Load three floats without reading past them.
+static inline __m128 LoadFloat3(const float* src)
+{
+    return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)src), _mm_load_ss(src + 2));
+}
+
+/// Store three floats without writing past them.
+static inline void StoreFloat3(float* dest, __m128 value)
+{
+    _mm_storel_pi((__m64*)dest, value);
+    _mm_store_ss(dest + 2, _mm_movehl_ps(value, value));
+}
+#endif
+
+/// Add a weighted morph delta to a three-component vertex element.
+static inline void AddMorphDelta(float* dest, const float* src, float weight)
+{
+    #ifdef URHO3D_SSE_MATH
+    StoreFloat3(dest, _mm_add_ps(LoadFloat3(dest), _mm_mul_ps(LoadFloat3(src), _mm_set1_ps(weight))));
+    #else
+    dest[0] += src[0] * weight;
+    dest[1] += src[1] * weight;
+    dest[2] += src[2] * weight;
+    #endif
+}
+
+void SkinPositions(Vector3* dest, const void* positionData, unsigned positionSize, const void* blendData, unsigned blendSize,
+    unsigned weightsOffset, unsigned indicesOffset, unsigned vertexStart, unsigned vertexCount, const Matrix3x4* skinMatrices,
+    unsigned numSkinMatrices)
+{
+    if (!dest || !positionData || !blendData || !skinMatrices || !numSkinMatrices)
+        return;
+    
+    const unsigned char* positions = (const unsigned char*)positionData + vertexStart * positionSize;
+    const unsigned char* blend = (const unsigned char*)blendData + vertexStart * blendSize;
+    dest += vertexStart;
+    
+    while (vertexCount--)
+    {
+        const float* position = (const float*)positions;
+        const float* weights = (const float*)(blend + weightsOffset);
+        const unsigned char* indices = blend + indicesOffset;
+        
+        // Blend the skin matrices first, then transform the position once
+        #ifdef URHO3D_SSE_MATH
+        __m128 row0 = _mm_setzero_ps();
+        __m128 row1 = _mm_setzero_ps();
+        __m128 row2 = _mm_setzero_ps();
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            const Matrix3x4& matrix = skinMatrices[indices[i] < numSkinMatrices ? indices[i] : 0];
+            __m128 weight = _mm_set1_ps(weights[i]);
+            row0 = _mm_add_ps(row0, _mm_mul_ps(_mm_loadu_ps(&matrix.m00_), weight));
+            row1 = _mm_add_ps(row1, _mm_mul_ps(_mm_loadu_ps(&matrix.m10_), weight));
+            row2 = _mm_add_ps(row2, _mm_mul_ps(_mm_loadu_ps(&matrix.m20_), weight));
+        }
+        
+        // Multiply the rows with (x, y, z, 1) and sum each row's products by transposing
+        __m128 pos = _mm_or_ps(LoadFloat3(position), _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+        row0 = _mm_mul_ps(row0, pos);
+        row1 = _mm_mul_ps(row1, pos);
+        row2 = _mm_mul_ps(row2, pos);
+        __m128 row3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+        StoreFloat3(&dest->x_, _mm_add_ps(_mm_add_ps(row0, row1), _mm_add_ps(row2, row3)));
+        #else
+        float blended[12];
+        for (unsigned j = 0; j < 12; ++j)
+            blended[j] = 0.0f;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            const float* matrix = skinMatrices[indices[i] < numSkinMatrices ? indices[i] : 0].Data();
+            float weight = weights[i];
+            for (unsigned j = 0; j < 12; ++j)
+                blended[j] += matrix[j] * weight;
+        }
+        
+        dest->x_ = blended[0] * position[0] + blended[1] * position[1] + blended[2] * position[2] + blended[3];
+        dest->y_ = blended[4] * position[0] + blended[5] * position[1] + blended[6] * position[2] + blended[7];
+        dest->z_ = blended[8] * position[0] + blended[9] * position[1] + blended[10] * position[2] + blended[11];
+        #endif
+        
+        positions += positionSize;
+        blend += blendSize;
+        ++dest;
+    }
+}
+
+void ApplyVertexMorph(void* vertexData, unsigned vertexSize, unsigned normalOffset, unsigned tangentOffset, unsigned elementMask,
+    unsigned morphRangeStart, const VertexBufferMorph& morph, float weight)
+{
+    elementMask &= morph.elementMask_;
+    unsigned vertexCount = morph.vertexCount_;
+    unsigned char* srcData = morph.morphData_;
+    unsigned char* destData = (unsigned char*)vertexData;
+    
+    while (vertexCount--)
+    {
+        unsigned char* dest = destData + (*((unsigned*)srcData) - morphRangeStart) * vertexSize;
+        srcData += sizeof(unsigned);
+        
+        if (elementMask & MASK_POSITION)
+        {
+            AddMorphDelta((float*)dest, (const float*)srcData, weight);
+            srcData += 3 * sizeof(float);
+        }
+        if (elementMask & MASK_NORMAL)
+        {
+            AddMorphDelta((float*)(dest + normalOffset), (const float*)srcData, weight);
+            srcData += 3 * sizeof(float);
+        }
+        if (elementMask & MASK_TANGENT)
+        {
+            AddMorphDelta((float*)(dest + tangentOffset), (const float*)srcData, weight);
+            srcData += 3 * sizeof(float);
+        }
+    }
+}
+
+}
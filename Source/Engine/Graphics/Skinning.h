@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Urho3D.h"
+
+namespace Urho3D
+{
+
+class Matrix3x4;
+class Vector3;
+struct VertexBufferMorph;
+
+/// Calculate skinned vertex positions on the CPU with four bone influences per vertex. The positions are read from the start of each vertex, and the blend weights and indices from the given offsets of the blend data. Blend indices beyond the number of skin matrices use the first matrix. The destination is written at the same vertex indices.
+URHO3D_API void SkinPositions(Vector3* dest, const void* positionData, unsigned positionSize, const void* blendData, unsigned blendSize, unsigned weightsOffset, unsigned indicesOffset, unsigned vertexStart, unsigned vertexCount, const Matrix3x4* skinMatrices, unsigned numSkinMatrices);
+/// Add a weighted vertex morph to vertex data that starts at the morph range start. Only the elements in the element mask are morphed.
+URHO3D_API void ApplyVertexMorph(void* vertexData, unsigned vertexSize, unsigned normalOffset, unsigned tangentOffset, unsigned elementMask, unsigned morphRangeStart, const VertexBufferMorph& morph, float weight);
+
+}
@@ -174,6 +174,7 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     Vector3 absViewZ = viewZ.Abs();
     unsigned cameraViewMask = view->camera_->GetViewMask();
     bool cameraZoneOverride = view->cameraZoneOverride_;
+    bool zonesUnchanged = view->zonesUnchanged_;
     PerThreadSceneResult& result = view->sceneResults_[threadIndex];
     
     while (start != end)
@@ -200,9 +201,10 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
             // For geometries, find zone, clear lights and calculate view space Z range
             if (drawable->GetDrawableFlags() & DRAWABLE_GEOMETRY)
             {
+                // A temporary zone assignment would be found again if the drawable, the camera and the zones have not changed
                 Zone* drawableZone = drawable->GetZone();
-                if (!cameraZoneOverride && (drawable->IsZoneDirty() || !drawableZone || (drawableZone->GetViewMask() &
-                    cameraViewMask) == 0))
+                if (!cameraZoneOverride && ((drawable->IsZoneDirty() && !(zonesUnchanged && drawable->IsZoneTemporary())) ||
+                    !drawableZone || (drawableZone->GetViewMask() & cameraViewMask) == 0))
                     view->FindZone(drawable);
                 
                 const BoundingBox& geomBox = drawable->GetWorldBoundingBox();
@@ -295,7 +297,10 @@ View::View(Context* context) :
     cameraZone_(0),
     farClipZone_(0),
     renderTarget_(0),
-    substituteRenderTarget_(0)
+    substituteRenderTarget_(0),
+    zonesUnchanged_(false),
+    lastViewMask_(0),
+    numSkippedDrawables_(0)
 {
     // Create octree query and scene results vector for each thread
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
@@ -674,10 +679,22 @@ void View::GetDrawables()
     WorkQueue* queue = GetSubsystem<WorkQueue>();
     PODVector<Drawable*>& tempDrawables = tempDrawables_[0];
     
+    // If the camera has not moved since the previous frame, repeat the octree queries incrementally: only the octants whose
+    // drawables have changed are tested again
+    const Frustum& frustum = camera_->GetFrustum();
+    unsigned viewMask = camera_->GetViewMask();
+    bool repeat = viewMask == lastViewMask_;
+    for (unsigned i = 0; i < NUM_FRUSTUM_VERTICES && repeat; ++i)
+        repeat = frustum.vertices_[i] == lastFrustum_.vertices_[i];
+    lastFrustum_ = frustum;
+    lastViewMask_ = viewMask;
+    
     // Get zones and occluders first
     {
-        ZoneOccluderOctreeQuery query(tempDrawables, camera_->GetFrustum(), DRAWABLE_GEOMETRY | DRAWABLE_ZONE, camera_->GetViewMask());
-        octree_->GetDrawables(query);
+        ZoneOccluderOctreeQuery query(tempDrawables, frustum, DRAWABLE_GEOMETRY | DRAWABLE_ZONE, viewMask);
+        octree_->GetDrawables(query, zoneOccluderQueryCache_, repeat);
+        zonesUnchanged_ = repeat && !zoneOccluderQueryCache_.numTested_;
+        numSkippedDrawables_ = zoneOccluderQueryCache_.numSkipped_;
     }
     
     highestZonePriority_ = M_MIN_INT;
@@ -740,18 +757,20 @@ void View::GetDrawables()
         }
     }
     
-    // Get lights and geometries. Coarse occlusion for octants is used at this point
+    // Get lights and geometries. Coarse occlusion for octants is used at this point. The occlusion may change even when the
+    // camera and the octants do not, so the results can only be reused without it
     if (occlusionBuffer_)
     {
-        OccludedFrustumOctreeQuery query(tempDrawables, camera_->GetFrustum(), occlusionBuffer_, DRAWABLE_GEOMETRY |
-            DRAWABLE_LIGHT, camera_->GetViewMask());
+        OccludedFrustumOctreeQuery query(tempDrawables, frustum, occlusionBuffer_, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT,
+            viewMask);
         octree_->GetDrawables(query);
+        geometryQueryCache_.Reset();
     }
     else
     {
-        FrustumOctreeQuery query(tempDrawables, camera_->GetFrustum(), DRAWABLE_GEOMETRY | DRAWABLE_LIGHT,
-            camera_->GetViewMask());
-        octree_->GetDrawables(query);
+        FrustumOctreeQuery query(tempDrawables, frustum, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, viewMask);
+        octree_->GetDrawables(query, geometryQueryCache_, repeat);
+        numSkippedDrawables_ += geometryQueryCache_.numSkipped_;
     }
     
     // Check drawable occlusion, find zones for moved drawables and collect geometries & lights in worker threads
@@ -766,30 +785,8 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
         
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-        
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-            
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-            
-            start = end;
-        }
-        
-        queue->Complete(M_MAX_UNSIGNED);
+        // Occlusion testing and batch updates make the per-drawable cost uneven, so use balanced parallel chunks
+        queue->ParallelFor(CheckVisibilityWork, tempDrawables.Begin().ptr_, tempDrawables.End().ptr_, this);
     }
     
     // Combine lights, geometries & scene Z range from the threads
@@ -839,12 +836,41 @@ void View::GetBatches()
     PODVector<Light*> vertexLights;
     BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassName_) ? &batchQueues_[alphaPassName_] : (BatchQueue*)0;
     
+    // Start the threaded geometry updates of visible drawables, so that they run during light processing and batch building.
+    // The visible geometries do not change anymore, and the shadow geometries found later are distinct from them. Submit one
+    // descriptor per drawable as a batch, which the worker threads process in adaptively sized chunks
+    WorkBatch* geometryUpdateBatch;
+    {
+        threadedGeometries_.Clear();
+        for (PODVector<Drawable*>::Iterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+        {
+            if ((*i)->GetUpdateGeometryType() == UPDATE_WORKER_THREAD)
+                threadedGeometries_.Push(*i);
+        }
+        
+        geometryUpdateDescriptors_.Resize(threadedGeometries_.Size());
+        for (unsigned i = 0; i < threadedGeometries_.Size(); ++i)
+        {
+            WorkDescriptor& descriptor = geometryUpdateDescriptors_[i];
+            descriptor.workFunction_ = UpdateDrawableGeometriesWork;
+            descriptor.start_ = &threadedGeometries_[i];
+            descriptor.end_ = &threadedGeometries_[i] + 1;
+            descriptor.aux_ = const_cast<FrameInfo*>(&frame_);
+        }
+        
+        geometryUpdateBatch = geometryUpdateDescriptors_.Size() ? queue->AddWorkBatch(&geometryUpdateDescriptors_[0],
+            geometryUpdateDescriptors_.Size()) : (WorkBatch*)0;
+    }
+    
     // Process lit geometries and shadow casters for each light
     {
         PROFILE(ProcessLights);
         
         lightQueryResults_.Resize(lights_.Size());
         
+        SharedPtr<WorkItem> lightSink = queue->GetFreeItem();
+        lightSink->priority_ = M_MAX_UNSIGNED;
+        
         for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
         {
             SharedPtr<WorkItem> item = queue->GetFreeItem();
@@ -856,11 +882,13 @@ void View::GetBatches()
             query.light_ = lights_[i];
             
             item->start_ = &query;
+            queue->AddDependency(lightSink, item);
             queue->AddWorkItem(item);
         }
         
-        // Ensure all lights have been processed before proceeding
-        queue->Complete(M_MAX_UNSIGNED);
+        // Ensure all lights have been processed before proceeding. Geometry updates may still continue
+        queue->AddWorkItem(lightSink);
+        queue->CompleteItem(lightSink);
     }
     
     // Build light queues and lit batches
@@ -1123,6 +1151,9 @@ void View::GetBatches()
             }
         }
     }
+    
+    // Finish the threaded geometry updates before the scene can be modified again
+    queue->CompleteBatch(geometryUpdateBatch);
 }
 
 void View::UpdateGeometries()
@@ -1171,7 +1202,8 @@ void View::UpdateGeometries()
         }
     }
     
-    // Update geometries. Split into threaded and non-threaded updates.
+    // Update geometries. Split into threaded and non-threaded updates. Visible geometries already updated in worker threads during
+    // GetBatches() need no further update, unless they were dirtied again
     {
         nonThreadedGeometries_.Clear();
         threadedGeometries_.Clear();
@@ -1193,33 +1225,12 @@ void View::UpdateGeometries()
                 threadedGeometries_.Push(*i);
         }
         
-        if (threadedGeometries_.Size())
-        {
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
-            
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
-            {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-                
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-                
-                start = end;
-            }
-        }
-        
-        // While the work queue is processed, update non-threaded geometries
+        // While the sorting work is processed, update non-threaded geometries, then update the rest in parallel
         for (PODVector<Drawable*>::ConstIterator i = nonThreadedGeometries_.Begin(); i != nonThreadedGeometries_.End(); ++i)
             (*i)->UpdateGeometry(frame_);
+        
+        queue->ParallelFor(UpdateDrawableGeometriesWork, threadedGeometries_.Begin().ptr_, threadedGeometries_.End().ptr_,
+            const_cast<FrameInfo*>(&frame_));
     }
     
     // Finally ensure all threaded work has completed
@@ -26,6 +26,7 @@
 #include "HashSet.h"
 #include "List.h"
 #include "Object.h"
+#include "Octree.h"
 #include "Polyhedron.h"
 #include "Zone.h"
 
@@ -45,6 +46,7 @@ class Texture2D;
 class Viewport;
 class Zone;
 struct RenderPathCommand;
+struct WorkDescriptor;
 struct WorkItem;
 
 /// Intermediate light processing result.
@@ -147,6 +149,8 @@ public:
     const PODVector<Light*>& GetLights() const { return lights_; }
     /// Return light batch queues.
     const Vector<LightBatchQueue>& GetLightQueues() const { return lightQueues_; }
+    /// Return number of drawable objects whose visibility test was skipped by reusing the previous frame's octree query results.
+    unsigned GetNumSkippedDrawables() const { return numSkippedDrawables_; }
     /// Set global (per-frame) shader parameters. Called by Batch and internally by View.
     void SetGlobalShaderParameters();
     /// Set camera-specific shader parameters. Called by Batch and internally by View.
@@ -300,6 +304,18 @@ private:
     int highestZonePriority_;
     /// Camera zone's override flag.
     bool cameraZoneOverride_;
+    /// Zones unchanged from the previous frame flag. If set, temporary zone assignments do not need to be re-evaluated.
+    bool zonesUnchanged_;
+    /// Camera view mask on the previous frame.
+    unsigned lastViewMask_;
+    /// Number of drawable objects whose visibility test was skipped.
+    unsigned numSkippedDrawables_;
+    /// Camera frustum on the previous frame.
+    Frustum lastFrustum_;
+    /// Zone and occluder octree query results from the previous frame.
+    OctreeQueryCache zoneOccluderQueryCache_;
+    /// Geometry and light octree query results from the previous frame.
+    OctreeQueryCache geometryQueryCache_;
     /// Draw shadows flag.
     bool drawShadows_;
     /// Deferred flag. Inferred from the existence of a light volume command in the renderpath.
@@ -326,6 +342,8 @@ private:
     PODVector<Drawable*> nonThreadedGeometries_;
     /// Geometry objects that will be updated in worker threads.
     PODVector<Drawable*> threadedGeometries_;
+    /// Work descriptors of the visible geometry updates started before batch building.
+    PODVector<WorkDescriptor> geometryUpdateDescriptors_;
     /// Occluder objects.
     PODVector<Drawable*> occluders_;
     /// Lights.
@@ -155,6 +155,11 @@ void Zone::SetFogHeightScale(float scale)
 void Zone::SetPriority(int priority)
 {
     priority_ = priority;
+    // Clear the zone assignments of the drawables inside, as they are only re-evaluated when dirty. Also change the octant
+    // version, so that views do not keep the temporary zone assignments as if the zones were unchanged
+    OnMarkedDirty(node_);
+    if (octant_)
+        octant_->MarkDrawablesChanged();
     MarkNetworkUpdate();
 }
 
@@ -29,6 +29,7 @@
 namespace Urho3D
 {
 
+class BoundingBox;
 class Color;
 class IntRect;
 class IntVector2;
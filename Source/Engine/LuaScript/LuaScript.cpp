@@ -174,8 +174,8 @@ void LuaScript::ScriptSubscribeToEvent(const String& eventName, const String& fu
     {
         LuaFunctionVector& functions = eventHandleFunctions_[eventType];
         
-        HashSet<Object*>* receivers = context_->GetEventReceivers(eventType);
-        if (!receivers || !receivers->Contains(this))
+        EventReceiverGroup* receivers = context_->GetEventReceivers(eventType);
+        if (!receivers || !receivers->receivers_.Contains(this))
             SubscribeToEvent(eventType, HANDLER(LuaScript, HandleEvent));
 
         if (!functions.Contains(function))
@@ -225,8 +225,8 @@ void LuaScript::ScriptSubscribeToEvent(void* sender, const String& eventName, co
     {
         LuaFunctionVector& functions = objectHandleFunctions_[object][eventType];
 
-        HashSet<Object*>* receivers = context_->GetEventReceivers(object, eventType);
-        if (!receivers || !receivers->Contains(this))
+        EventReceiverGroup* receivers = context_->GetEventReceivers(object, eventType);
+        if (!receivers || !receivers->receivers_.Contains(this))
         {
             SubscribeToEvent(object, eventType, HANDLER(LuaScript, HandleObjectEvent));
             
@@ -127,6 +127,38 @@ BoundingBox BoundingBox::Transformed(const Matrix3& transform) const
 
 BoundingBox BoundingBox::Transformed(const Matrix3x4& transform) const
 {
+    #ifdef URHO3D_SSE_MATH
+    __m128 minPt = _mm_loadu_ps(&min_.x_);
+    // Load starting from min Z to stay inside the object, then rotate the max coordinates to the first three elements
+    __m128 maxPt = _mm_loadu_ps(&min_.z_);
+    maxPt = _mm_shuffle_ps(maxPt, maxPt, _MM_SHUFFLE(0, 3, 2, 1));
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 center = _mm_mul_ps(_mm_add_ps(maxPt, minPt), half);
+    __m128 edge = _mm_mul_ps(_mm_sub_ps(maxPt, minPt), half);
+    
+    // Transpose the matrix so that each column can be multiplied by a single coordinate
+    __m128 c0 = _mm_loadu_ps(&transform.m00_);
+    __m128 c1 = _mm_loadu_ps(&transform.m10_);
+    __m128 c2 = _mm_loadu_ps(&transform.m20_);
+    __m128 c3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    
+    __m128 newCenter = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(c0, _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0))),
+        _mm_mul_ps(c1, _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1)))),
+        _mm_mul_ps(c2, _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2)))), c3);
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 newEdge = _mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(_mm_andnot_ps(signMask, c0), _mm_shuffle_ps(edge, edge, _MM_SHUFFLE(0, 0, 0, 0))),
+        _mm_mul_ps(_mm_andnot_ps(signMask, c1), _mm_shuffle_ps(edge, edge, _MM_SHUFFLE(1, 1, 1, 1)))),
+        _mm_mul_ps(_mm_andnot_ps(signMask, c2), _mm_shuffle_ps(edge, edge, _MM_SHUFFLE(2, 2, 2, 2))));
+    
+    float newMin[4];
+    float newMax[4];
+    _mm_storeu_ps(newMin, _mm_sub_ps(newCenter, newEdge));
+    _mm_storeu_ps(newMax, _mm_add_ps(newCenter, newEdge));
+    return BoundingBox(Vector3(newMin), Vector3(newMax));
+    #else
     Vector3 newCenter = transform * Center();
     Vector3 oldEdge = Size() * 0.5f;
     Vector3 newEdge = Vector3(
@@ -136,6 +168,7 @@ BoundingBox BoundingBox::Transformed(const Matrix3x4& transform) const
     );
     
     return BoundingBox(newCenter - newEdge, newCenter + newEdge);
+    #endif
 }
 
 Rect BoundingBox::Projected(const Matrix4& projection) const
@@ -186,6 +186,51 @@ Rect Frustum::Projected(const Matrix4& projection) const
     return rect;
 }
 
+unsigned Frustum::IsInsideFast4(const float* boxes) const
+{
+    #ifdef URHO3D_SSE_MATH
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 minX = _mm_loadu_ps(boxes);
+    __m128 minY = _mm_loadu_ps(boxes + 4);
+    __m128 minZ = _mm_loadu_ps(boxes + 8);
+    __m128 maxX = _mm_loadu_ps(boxes + 12);
+    __m128 maxY = _mm_loadu_ps(boxes + 16);
+    __m128 maxZ = _mm_loadu_ps(boxes + 20);
+    __m128 centerX = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+    __m128 centerY = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+    __m128 centerZ = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+    __m128 edgeX = _mm_sub_ps(centerX, minX);
+    __m128 edgeY = _mm_sub_ps(centerY, minY);
+    __m128 edgeZ = _mm_sub_ps(centerZ, minZ);
+    __m128 outside = _mm_setzero_ps();
+    
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = planes_[i];
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.normal_.x_)),
+            _mm_mul_ps(centerY, _mm_set1_ps(plane.normal_.y_))), _mm_add_ps(_mm_mul_ps(centerZ,
+            _mm_set1_ps(plane.normal_.z_)), _mm_set1_ps(plane.d_)));
+        __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeX, _mm_set1_ps(plane.absNormal_.x_)),
+            _mm_mul_ps(edgeY, _mm_set1_ps(plane.absNormal_.y_))), _mm_mul_ps(edgeZ, _mm_set1_ps(plane.absNormal_.z_)));
+        // Same test as IsInsideFast(): outside if the center is further behind the plane than the projected half size
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(_mm_setzero_ps(), absDist)));
+    }
+    
+    return ~(unsigned)_mm_movemask_ps(outside) & 0xf;
+    #else
+    unsigned result = 0;
+    
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        BoundingBox box(Vector3(boxes[i], boxes[i + 4], boxes[i + 8]), Vector3(boxes[i + 12], boxes[i + 16], boxes[i + 20]));
+        if (IsInsideFast(box) == INSIDE)
+            result |= 1 << i;
+    }
+    
+    return result;
+    #endif
+}
+
 void Frustum::UpdatePlanes()
 {
     planes_[PLANE_NEAR].Define(vertices_[2], vertices_[1], vertices_[0]);
@@ -151,6 +151,9 @@ public:
         return INSIDE;
     }
     
+    /// Test if four bounding boxes are (partially) inside or outside. The boxes are packed as arrays of four min X, Y, Z and max X, Y, Z coordinates. Return a bitmask with bits set for the boxes that are inside.
+    unsigned IsInsideFast4(const float* boxes) const;
+    
     /// Return distance of a point to the frustum, or 0 if inside.
     float Distance(const Vector3& point) const
     {
@@ -27,6 +27,15 @@
 #include <cstdlib>
 #include <cmath>
 
+// The SSE math code paths are only available on x86 and x64
+#if defined(URHO3D_SSE_MATH) && !(defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
+#undef URHO3D_SSE_MATH
+#endif
+
+#ifdef URHO3D_SSE_MATH
+#include <xmmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
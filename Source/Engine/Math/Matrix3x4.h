@@ -292,6 +292,26 @@ public:
     /// Multiply a matrix.
     Matrix3x4 operator * (const Matrix3x4& rhs) const
     {
+        #ifdef URHO3D_SSE_MATH
+        Matrix3x4 ret;
+        __m128 r0 = _mm_loadu_ps(&rhs.m00_);
+        __m128 r1 = _mm_loadu_ps(&rhs.m10_);
+        __m128 r2 = _mm_loadu_ps(&rhs.m20_);
+        // The implicit last row of the right-hand matrix picks up the translation
+        __m128 r3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+        
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            __m128 row = _mm_loadu_ps(&m00_ + i * 4);
+            _mm_storeu_ps(&ret.m00_ + i * 4, _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), r0),
+                _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), r1)),
+                _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), r2)),
+                _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), r3)));
+        }
+        
+        return ret;
+        #else
         return Matrix3x4(
             m00_ * rhs.m00_ + m01_ * rhs.m10_ + m02_ * rhs.m20_,
             m00_ * rhs.m01_ + m01_ * rhs.m11_ + m02_ * rhs.m21_,
@@ -306,6 +326,7 @@ public:
             m20_ * rhs.m02_ + m21_ * rhs.m12_ + m22_ * rhs.m22_,
             m20_ * rhs.m03_ + m21_ * rhs.m13_ + m22_ * rhs.m23_ + m23_
         );
+        #endif
     }
     
     /// Multiply a 4x4 matrix.
@@ -143,12 +143,28 @@ public:
     /// Multiply a quaternion.
     Quaternion operator * (const Quaternion& rhs) const
     {
+        #ifdef URHO3D_SSE_MATH
+        Quaternion ret;
+        __m128 q = _mm_loadu_ps(&w_);
+        __m128 r = _mm_loadu_ps(&rhs.w_);
+        // Negate the W component of the second and third terms, and all of the fourth, to match the scalar sums
+        __m128 negW = _mm_set_ps(0.0f, 0.0f, 0.0f, -0.0f);
+        __m128 sum = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 0, 0, 0)), r), _mm_xor_ps(negW,
+            _mm_mul_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 2, 1, 1)), _mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 0, 0, 1)))));
+        sum = _mm_add_ps(sum, _mm_xor_ps(negW, _mm_mul_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(1, 3, 2, 2)),
+            _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 1, 3, 2)))));
+        sum = _mm_sub_ps(sum, _mm_mul_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 1, 3, 3)), _mm_shuffle_ps(r, r,
+            _MM_SHUFFLE(1, 3, 2, 3))));
+        _mm_storeu_ps(&ret.w_, sum);
+        return ret;
+        #else
         return Quaternion(
             w_ * rhs.w_ - x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_,
             w_ * rhs.x_ + x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_,
             w_ * rhs.y_ + y_ * rhs.w_ + z_ * rhs.x_ - x_ * rhs.z_,
             w_ * rhs.z_ + z_ * rhs.w_ + x_ * rhs.y_ - y_ * rhs.x_
         );
+        #endif
     }
     
     /// Multiply a Vector3.
@@ -177,6 +193,15 @@ public:
     /// Normalize to unit length.
     void Normalize()
     {
+        #ifdef URHO3D_SSE_MATH
+        __m128 q = _mm_loadu_ps(&w_);
+        __m128 n = _mm_mul_ps(q, q);
+        n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 3, 0, 1)));
+        n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(0, 1, 2, 3)));
+        float lenSquared = _mm_cvtss_f32(n);
+        if (!Urho3D::Equals(lenSquared, 1.0f) && lenSquared > 0.0f)
+            _mm_storeu_ps(&w_, _mm_mul_ps(q, _mm_set1_ps(1.0f / sqrtf(lenSquared))));
+        #else
         float lenSquared = LengthSquared();
         if (!Urho3D::Equals(lenSquared, 1.0f) && lenSquared > 0.0f)
         {
@@ -186,11 +211,17 @@ public:
             y_ *= invLen;
             z_ *= invLen;
         }
+        #endif
     }
     
     /// Return normalized to unit length.
     Quaternion Normalized() const
     {
+        #ifdef URHO3D_SSE_MATH
+        Quaternion ret(*this);
+        ret.Normalize();
+        return ret;
+        #else
         float lenSquared = LengthSquared();
         if (!Urho3D::Equals(lenSquared, 1.0f) && lenSquared > 0.0f)
         {
@@ -199,6 +230,7 @@ public:
         }
         else
             return *this;
+        #endif
     }
     
     /// Return inverse.
@@ -27,6 +27,10 @@
 namespace Urho3D
 {
 
+class Node;
+class PhysicsWorld;
+class RigidBody;
+
 /// Physics world is about to be stepped.
 EVENT(E_PHYSICSPRESTEP, PhysicsPreStep)
 {
@@ -105,4 +109,103 @@ EVENT(E_NODECOLLISIONEND, NodeCollisionEnd)
     PARAM(P_TRIGGER, Trigger);              // bool
 }
 
+/// Typed parameters of the physics pre-step and post-step events.
+class URHO3D_API PhysicsStepEvent : public TypedEvent
+{
+    TYPED_EVENT(PhysicsStepEvent);
+
+public:
+    /// Construct.
+    PhysicsStepEvent(StringHash eventType, PhysicsWorld* world = 0, float timeStep = 0.0f) :
+        TypedEvent(eventType),
+        world_(world),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const;
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData);
+    
+    /// Physics world.
+    PhysicsWorld* world_;
+    /// Timestep in seconds.
+    float timeStep_;
+};
+
+/// Typed parameters of the physics collision start, collision and collision end events.
+class URHO3D_API PhysicsCollisionEvent : public TypedEvent
+{
+    TYPED_EVENT(PhysicsCollisionEvent);
+
+public:
+    /// Construct.
+    PhysicsCollisionEvent(StringHash eventType) :
+        TypedEvent(eventType),
+        world_(0),
+        nodeA_(0),
+        nodeB_(0),
+        bodyA_(0),
+        bodyB_(0),
+        trigger_(false),
+        contacts_(0)
+    {
+    }
+    
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const;
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData);
+    
+    /// Physics world.
+    PhysicsWorld* world_;
+    /// First node.
+    Node* nodeA_;
+    /// Second node.
+    Node* nodeB_;
+    /// First rigid body.
+    RigidBody* bodyA_;
+    /// Second rigid body.
+    RigidBody* bodyB_;
+    /// Trigger flag.
+    bool trigger_;
+    /// Contact buffer, in the same format as the Contacts parameter. Null in the collision end event.
+    const PODVector<unsigned char>* contacts_;
+};
+
+/// Typed parameters of the node collision start, collision and collision end events.
+class URHO3D_API NodeCollisionEvent : public TypedEvent
+{
+    TYPED_EVENT(NodeCollisionEvent);
+
+public:
+    /// Construct.
+    NodeCollisionEvent(StringHash eventType) :
+        TypedEvent(eventType),
+        body_(0),
+        otherNode_(0),
+        otherBody_(0),
+        trigger_(false),
+        contacts_(0)
+    {
+    }
+    
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const;
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData);
+    
+    /// Rigid body of the node receiving the event.
+    RigidBody* body_;
+    /// Other node.
+    Node* otherNode_;
+    /// Other rigid body.
+    RigidBody* otherBody_;
+    /// Trigger flag.
+    bool trigger_;
+    /// Contact buffer, in the same format as the Contacts parameter. Null in the collision end event.
+    const PODVector<unsigned char>* contacts_;
+};
+
 }
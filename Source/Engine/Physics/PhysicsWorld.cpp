@@ -556,26 +556,20 @@ void PhysicsWorld::OnNodeSet(Node* node)
     if (node)
     {
         scene_ = GetScene();
-        SubscribeToEvent(node, E_SCENESUBSYSTEMUPDATE, HANDLER(PhysicsWorld, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(node, E_SCENESUBSYSTEMUPDATE, TYPED_HANDLER(PhysicsWorld, HandleSceneSubsystemUpdate));
     }
 }
 
-void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
-    using namespace SceneSubsystemUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void PhysicsWorld::PreStep(float timeStep)
 {
     // Send pre-step event
-    using namespace PhysicsPreStep;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPRESTEP, eventData);
+    PhysicsStepEvent eventData(E_PHYSICSPRESTEP, this, timeStep);
+    SendEvent(eventData);
 
     // Start profiling block for the actual simulation step
 #ifdef URHO3D_PROFILING
@@ -596,12 +590,8 @@ void PhysicsWorld::PostStep(float timeStep)
     SendCollisionEvents();
 
     // Send post-step event
-    using namespace PhysicsPreStep;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPOSTSTEP, eventData);
+    PhysicsStepEvent eventData(E_PHYSICSPOSTSTEP, this, timeStep);
+    SendEvent(eventData);
 }
 
 void PhysicsWorld::SendCollisionEvents()
@@ -609,15 +599,11 @@ void PhysicsWorld::SendCollisionEvents()
     PROFILE(SendCollisionEvents);
 
     currentCollisions_.Clear();
-    physicsCollisionData_.Clear();
-    nodeCollisionData_.Clear();
     
     int numManifolds = collisionDispatcher_->getNumManifolds();
 
     if (numManifolds)
     {
-        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
-
         for (int i = 0; i < numManifolds; ++i)
         {
             btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
@@ -677,12 +663,6 @@ void PhysicsWorld::SendCollisionEvents()
             bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
             bool newCollision = !previousCollisions_.Contains(i->first_);
 
-            physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
-            physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
-            physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
-            physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
-            physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
-
             contacts_.Clear();
 
             for (int j = 0; j < numContacts; ++j)
@@ -694,36 +674,47 @@ void PhysicsWorld::SendCollisionEvents()
                 contacts_.WriteFloat(point.m_appliedImpulse);
             }
 
-            physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
+            // The contact buffer is referred to instead of copied, unless a subscriber takes an event data map
+            PhysicsCollisionEvent physicsCollisionData(E_PHYSICSCOLLISIONSTART);
+            physicsCollisionData.world_ = this;
+            physicsCollisionData.nodeA_ = nodeA;
+            physicsCollisionData.nodeB_ = nodeB;
+            physicsCollisionData.bodyA_ = bodyA;
+            physicsCollisionData.bodyB_ = bodyB;
+            physicsCollisionData.trigger_ = trigger;
+            physicsCollisionData.contacts_ = &contacts_.GetBuffer();
 
             // Send separate collision start event if collision is new
             if (newCollision)
             {
-                SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
+                SendEvent(physicsCollisionData);
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
             // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
+            physicsCollisionData.SetEventType(E_PHYSICSCOLLISION);
+            SendEvent(physicsCollisionData);
             if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                 continue;
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+            NodeCollisionEvent nodeCollisionData(E_NODECOLLISIONSTART);
+            nodeCollisionData.body_ = bodyA;
+            nodeCollisionData.otherNode_ = nodeB;
+            nodeCollisionData.otherBody_ = bodyB;
+            nodeCollisionData.trigger_ = trigger;
+            nodeCollisionData.contacts_ = &contacts_.GetBuffer();
 
             if (newCollision)
             {
-                nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                nodeA->SendEvent(nodeCollisionData);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+            nodeCollisionData.SetEventType(E_NODECOLLISION);
+            nodeA->SendEvent(nodeCollisionData);
             if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                 continue;
 
@@ -737,25 +728,28 @@ void PhysicsWorld::SendCollisionEvents()
                 contacts_.WriteFloat(point.m_appliedImpulse);
             }
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+            nodeCollisionData.body_ = bodyB;
+            nodeCollisionData.otherNode_ = nodeA;
+            nodeCollisionData.otherBody_ = bodyA;
 
             if (newCollision)
             {
-                nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                nodeCollisionData.SetEventType(E_NODECOLLISIONSTART);
+                nodeB->SendEvent(nodeCollisionData);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+            nodeCollisionData.SetEventType(E_NODECOLLISION);
+            nodeB->SendEvent(nodeCollisionData);
         }
     }
 
     // Send collision end events as applicable
     {
-        physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
+        PhysicsCollisionEvent physicsCollisionData(E_PHYSICSCOLLISIONEND);
+        physicsCollisionData.world_ = this;
+        NodeCollisionEvent nodeCollisionData(E_NODECOLLISIONEND);
 
         for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold*>::Iterator i = previousCollisions_.Begin(); i != previousCollisions_.End(); ++i)
         {
@@ -782,31 +776,31 @@ void PhysicsWorld::SendCollisionEvents()
                 WeakPtr<Node> nodeWeakA(nodeA);
                 WeakPtr<Node> nodeWeakB(nodeB);
 
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
+                physicsCollisionData.bodyA_ = bodyA;
+                physicsCollisionData.bodyB_ = bodyB;
+                physicsCollisionData.nodeA_ = nodeA;
+                physicsCollisionData.nodeB_ = nodeB;
+                physicsCollisionData.trigger_ = trigger;
 
-                SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
+                SendEvent(physicsCollisionData);
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
+                nodeCollisionData.body_ = bodyA;
+                nodeCollisionData.otherNode_ = nodeB;
+                nodeCollisionData.otherBody_ = bodyB;
+                nodeCollisionData.trigger_ = trigger;
 
-                nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                nodeA->SendEvent(nodeCollisionData);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
+                nodeCollisionData.body_ = bodyB;
+                nodeCollisionData.otherNode_ = nodeA;
+                nodeCollisionData.otherBody_ = bodyA;
 
-                nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                nodeB->SendEvent(nodeCollisionData);
             }
         }
     }
@@ -814,6 +808,82 @@ void PhysicsWorld::SendCollisionEvents()
     previousCollisions_ = currentCollisions_;
 }
 
+void PhysicsStepEvent::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace PhysicsPreStep;
+
+    eventData[P_WORLD] = world_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
+void PhysicsStepEvent::FromVariantMap(const VariantMap& eventData)
+{
+    using namespace PhysicsPreStep;
+
+    world_ = static_cast<PhysicsWorld*>(GetParameter(eventData, P_WORLD).GetPtr());
+    timeStep_ = GetParameter(eventData, P_TIMESTEP).GetFloat();
+}
+
+void PhysicsCollisionEvent::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace PhysicsCollision;
+
+    eventData[P_WORLD] = world_;
+    eventData[P_NODEA] = nodeA_;
+    eventData[P_NODEB] = nodeB_;
+    eventData[P_BODYA] = bodyA_;
+    eventData[P_BODYB] = bodyB_;
+    eventData[P_TRIGGER] = trigger_;
+    if (contacts_)
+        eventData[P_CONTACTS] = *contacts_;
+}
+
+void PhysicsCollisionEvent::FromVariantMap(const VariantMap& eventData)
+{
+    using namespace PhysicsCollision;
+
+    world_ = static_cast<PhysicsWorld*>(GetParameter(eventData, P_WORLD).GetPtr());
+    nodeA_ = static_cast<Node*>(GetParameter(eventData, P_NODEA).GetPtr());
+    nodeB_ = static_cast<Node*>(GetParameter(eventData, P_NODEB).GetPtr());
+    bodyA_ = static_cast<RigidBody*>(GetParameter(eventData, P_BODYA).GetPtr());
+    bodyB_ = static_cast<RigidBody*>(GetParameter(eventData, P_BODYB).GetPtr());
+    trigger_ = GetParameter(eventData, P_TRIGGER).GetBool();
+    // Contacts are not modified by handlers, so keep referring to the sender's buffer if set. Otherwise refer to the buffer
+    // inside the map, which stays valid for the duration of the handler
+    if (!contacts_)
+    {
+        VariantMap::ConstIterator i = eventData.Find(P_CONTACTS);
+        contacts_ = i != eventData.End() ? &i->second_.GetBuffer() : 0;
+    }
+}
+
+void NodeCollisionEvent::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace NodeCollision;
+
+    eventData[P_BODY] = body_;
+    eventData[P_OTHERNODE] = otherNode_;
+    eventData[P_OTHERBODY] = otherBody_;
+    eventData[P_TRIGGER] = trigger_;
+    if (contacts_)
+        eventData[P_CONTACTS] = *contacts_;
+}
+
+void NodeCollisionEvent::FromVariantMap(const VariantMap& eventData)
+{
+    using namespace NodeCollision;
+
+    body_ = static_cast<RigidBody*>(GetParameter(eventData, P_BODY).GetPtr());
+    otherNode_ = static_cast<Node*>(GetParameter(eventData, P_OTHERNODE).GetPtr());
+    otherBody_ = static_cast<RigidBody*>(GetParameter(eventData, P_OTHERBODY).GetPtr());
+    trigger_ = GetParameter(eventData, P_TRIGGER).GetBool();
+    if (!contacts_)
+    {
+        VariantMap::ConstIterator i = eventData.Find(P_CONTACTS);
+        contacts_ = i != eventData.End() ? &i->second_.GetBuffer() : 0;
+    }
+}
+
 void RegisterPhysicsLibrary(Context* context)
 {
     CollisionShape::RegisterObject(context);
@@ -50,6 +50,7 @@ class Node;
 class Ray;
 class RigidBody;
 class Scene;
+class SceneUpdateEvent;
 class Serializer;
 class XMLElement;
 
@@ -213,7 +214,7 @@ protected:
 
 private:
     /// Handle the scene subsystem update event, step simulation here.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(StringHash eventType, SceneUpdateEvent& eventData);
     /// Handle collision model reload finished.
     void HandleModelReloadFinished(StringHash eventType, VariantMap& eventData);
     /// Trigger update before each physics simulation step.
@@ -251,10 +252,6 @@ private:
     HashMap<Pair<Model*, unsigned>, SharedPtr<CollisionGeometryData> > triMeshCache_;
     /// Cache for convex geometry data by model and LOD level.
     HashMap<Pair<Model*, unsigned>, SharedPtr<CollisionGeometryData> > convexCache_;
-    /// Preallocated event data map for physics collision events.
-    VariantMap physicsCollisionData_;
-    /// Preallocated event data map for node collision events.
-    VariantMap nodeCollisionData_;
     /// Preallocated buffer for physics collision contact data.
     VectorBuffer contacts_;
     /// Simulation steps per second.
@@ -37,7 +37,9 @@ Component::Component(Context* context) :
     node_(0),
     id_(0),
     networkUpdate_(false),
-    enabled_(true)
+    enabled_(true),
+    delayedDirty_(0),
+    delayedDirtyNext_(0)
 {
 }
 
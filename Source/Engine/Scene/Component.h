@@ -114,6 +114,10 @@ protected:
     bool networkUpdate_;
     /// Enabled flag.
     bool enabled_;
+    /// Delayed dirty notification queued flag. Set atomically by the scene during a threaded update.
+    volatile unsigned delayedDirty_;
+    /// Next component in the scene's delayed dirty notification list.
+    Component* delayedDirtyNext_;
 };
 
 template <class T> T* Component::GetComponent() const { return static_cast<T*>(GetComponent(T::GetTypeStatic())); }
@@ -41,6 +41,7 @@ LogicComponent::LogicComponent(Context* context) :
 
 LogicComponent::~LogicComponent()
 {
+    RemoveParallelUpdate();
 }
 
 void LogicComponent::OnSetEnabled()
@@ -69,6 +70,7 @@ void LogicComponent::OnNodeSet(Node* node)
     else
     {
         // We are being detached from a node: execute user-defined stop function and prepare for destruction
+        RemoveParallelUpdate();
         Stop();
     }
 }
@@ -88,10 +90,22 @@ void LogicComponent::UpdateEventSubscription()
     
     bool enabled = IsEnabledEffective();
     
-    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
+    // The parallel update starts after the delayed start, which is called from the scene update event in the main thread
+    bool needParallelUpdate = enabled && (updateEventMask_ & USE_UPDATE) && (updateEventMask_ & USE_PARALLELUPDATE) &&
+        delayedStartCalled_;
+    if (needParallelUpdate && !(currentEventMask_ & USE_PARALLELUPDATE))
+    {
+        scene->AddParallelUpdate(this);
+        parallelUpdateScene_ = scene;
+        currentEventMask_ |= USE_PARALLELUPDATE;
+    }
+    else if (!needParallelUpdate && (currentEventMask_ & USE_PARALLELUPDATE))
+        RemoveParallelUpdate();
+    
+    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_) && !needParallelUpdate;
     if (needUpdate && !(currentEventMask_ & USE_UPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, HANDLER(LogicComponent, HandleSceneUpdate));
+        SubscribeToEvent(scene, E_SCENEUPDATE, TYPED_HANDLER(LogicComponent, HandleSceneUpdate));
         currentEventMask_ |= USE_UPDATE;
     }
     else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
@@ -103,10 +117,10 @@ void LogicComponent::UpdateEventSubscription()
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
     if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(LogicComponent, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(LogicComponent, HandleScenePostUpdate));
         currentEventMask_ |= USE_POSTUPDATE;
     }
-    else if (!needUpdate && (currentEventMask_ & USE_POSTUPDATE))
+    else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
     {
         UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
         currentEventMask_ &= ~USE_POSTUPDATE;
@@ -119,7 +133,7 @@ void LogicComponent::UpdateEventSubscription()
     bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
     if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
     {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, HANDLER(LogicComponent, HandlePhysicsPreStep));
+        SubscribeToEvent(world, E_PHYSICSPRESTEP, TYPED_HANDLER(LogicComponent, HandlePhysicsPreStep));
         currentEventMask_ |= USE_FIXEDUPDATE;
     }
     else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
@@ -131,7 +145,7 @@ void LogicComponent::UpdateEventSubscription()
     bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
     if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
     {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, HANDLER(LogicComponent, HandlePhysicsPostStep));
+        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, TYPED_HANDLER(LogicComponent, HandlePhysicsPostStep));
         currentEventMask_ |= USE_FIXEDPOSTUPDATE;
     }
     else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
@@ -141,10 +155,16 @@ void LogicComponent::UpdateEventSubscription()
     }
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::RemoveParallelUpdate()
+{
+    if (parallelUpdateScene_)
+        parallelUpdateScene_->RemoveParallelUpdate(this);
+    parallelUpdateScene_.Reset();
+    currentEventMask_ &= ~USE_PARALLELUPDATE;
+}
+
+void LogicComponent::HandleSceneUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
-    using namespace SceneUpdate;
-    
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
@@ -158,34 +178,35 @@ void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventDa
             currentEventMask_ &= ~USE_UPDATE;
             return;
         }
+        
+        // If updating in the worker threads, switch over from the event. The first update follows later in this frame
+        if (updateEventMask_ & USE_PARALLELUPDATE)
+        {
+            UpdateEventSubscription();
+            return;
+        }
     }
     
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
-    using namespace ScenePostUpdate;
-    
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(eventData.timeStep_);
 }
 
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandlePhysicsPreStep(StringHash eventType, PhysicsStepEvent& eventData)
 {
-    using namespace PhysicsPreStep;
-    
     // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
+    FixedUpdate(eventData.timeStep_);
 }
 
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandlePhysicsPostStep(StringHash eventType, PhysicsStepEvent& eventData)
 {
-    using namespace PhysicsPostStep;
-    
     // Execute user-defined fixed post-update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
+    FixedUpdate(eventData.timeStep_);
 }
 
 }
@@ -25,6 +25,9 @@
 namespace Urho3D
 {
 
+class PhysicsStepEvent;
+class SceneUpdateEvent;
+
 /// Bitmask for using the scene update event.
 static const unsigned char USE_UPDATE = 0x1;
 /// Bitmask for using the scene post-update event.
@@ -33,6 +36,8 @@ static const unsigned char USE_POSTUPDATE = 0x2;
 static const unsigned char USE_FIXEDUPDATE = 0x4;
 /// Bitmask for using the physics post-update event.
 static const unsigned char USE_FIXEDPOSTUPDATE = 0x8;
+/// Bitmask for calling Update() in the worker threads during the scene's parallel update phase instead of from the scene update event. Use together with USE_UPDATE.
+static const unsigned char USE_PARALLELUPDATE = 0x10;
 
 /// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class.
 class URHO3D_API LogicComponent : public Component
@@ -52,7 +57,7 @@ class URHO3D_API LogicComponent : public Component
     virtual void DelayedStart() {}
     /// Called when the component is detached from a scene node, usually on destruction.
     virtual void Stop() {}
-    /// Called on scene update, variable timestep.
+    /// Called on scene update, variable timestep. With USE_PARALLELUPDATE, called from a worker thread after the scene update event: may then only modify the component's own node and state, must not create or remove nodes or components, send or subscribe to events, or use the resource cache or the profiler, and may read other nodes only if no other parallel update modifies them.
     virtual void Update(float timeStep) {}
     /// Called on scene post-update, variable timestep.
     virtual void PostUpdate(float timeStep) {}
@@ -61,7 +66,7 @@ class URHO3D_API LogicComponent : public Component
     /// Called on physics post-update, fixed timestep.
     virtual void FixedPostUpdate(float timeStep) {}
     
-    /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
+    /// Set what update events should be subscribed to. Use this for optimization: by default all are in use except the parallel update. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(unsigned char mask);
     
     /// Return what update events are subscribed to.
@@ -76,17 +81,21 @@ protected:
 private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
+    /// Leave the parallel update phase of the scene it was added to.
+    void RemoveParallelUpdate();
     /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneUpdate(StringHash eventType, SceneUpdateEvent& eventData);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData);
     /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
+    void HandlePhysicsPreStep(StringHash eventType, PhysicsStepEvent& eventData);
     /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
+    void HandlePhysicsPostStep(StringHash eventType, PhysicsStepEvent& eventData);
     
     /// Requested event subscription mask.
     unsigned char updateEventMask_;
+    /// Scene whose parallel update phase the component is in.
+    WeakPtr<Scene> parallelUpdateScene_;
     /// Current event subscription mask.
     unsigned char currentEventMask_;
     /// Flag for delayed start.
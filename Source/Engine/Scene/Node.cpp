@@ -47,6 +47,7 @@ Node::Node(Context* context) :
     parent_(0),
     scene_(0),
     id_(0),
+    transformIndex_(M_MAX_UNSIGNED),
     position_(Vector3::ZERO),
     rotation_(Quaternion::IDENTITY),
     scale_(Vector3::ONE),
@@ -585,26 +586,43 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
-    if (dirty_)
-        return;
-
-    dirty_ = true;
+    Node* current = this;
 
-    // Notify listener components first, then mark child nodes
-    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    for (;;)
     {
-        if (*i)
+        // When a node is dirty, all its children are dirty too, so the subtree needs no further marking. This also keeps
+        // a node moved several times before its transform is read from notifying its listeners more than once
+        if (current->dirty_)
+            return;
+
+        current->dirty_ = true;
+        if (current->transformIndex_ != M_MAX_UNSIGNED)
+            current->scene_->MarkTransformDirty(current->transformIndex_);
+
+        // Notify listener components first, then mark child nodes
+        Vector<WeakPtr<Component> >& listeners = current->listeners_;
+        for (Vector<WeakPtr<Component> >::Iterator i = listeners.Begin(); i != listeners.End();)
         {
-            (*i)->OnMarkedDirty(this);
-            ++i;
+            if (*i)
+            {
+                (*i)->OnMarkedDirty(current);
+                ++i;
+            }
+            // If listener has expired, erase from list
+            else
+                i = listeners.Erase(i);
         }
-        // If listener has expired, erase from list
-        else
-            i = listeners_.Erase(i);
-    }
 
-    for (Vector<SharedPtr<Node> >::Iterator i = children_.Begin(); i != children_.End(); ++i)
-        (*i)->MarkDirty();
+        // Continue with the last child in this loop instead of recursing, so that deep chains (for example skeleton bones)
+        // do not recurse once per level
+        Vector<SharedPtr<Node> >& children = current->children_;
+        if (children.Empty())
+            return;
+
+        for (unsigned i = 0; i < children.Size() - 1; ++i)
+            children[i]->MarkDirty();
+        current = children.Back();
+    }
 }
 
 Node* Node::CreateChild(const String& name, CreateMode mode, unsigned id)
@@ -639,6 +657,8 @@ void Node::AddChild(Node* node, unsigned index)
     node->parent_ = this;
     node->MarkDirty();
     node->MarkNetworkUpdate();
+    if (scene_)
+        scene_->AddTransforms(node);
 
     // Send change event
     if (scene_)
@@ -1024,6 +1044,11 @@ void Node::SetID(unsigned id)
 
 void Node::SetScene(Scene* scene)
 {
+    // Leave the previous scene's flat transform update, so that it does not refer to this node. Remove the children too, as
+    // they would read a stale parent transform
+    if (transformIndex_ != M_MAX_UNSIGNED)
+        scene_->RemoveTransforms(this);
+
     scene_ = scene;
 }
 
@@ -1357,7 +1382,12 @@ void Node::MarkReplicationDirty()
 
 Node* Node::CreateChild(unsigned id, CreateMode mode)
 {
-    SharedPtr<Node> newNode(new Node(context_));
+    // Create through the factory if nodes are pooled
+    SharedPtr<Node> newNode;
+    if (context_->GetObjectPool(Node::GetTypeStatic()))
+        newNode = StaticCast<Node>(context_->CreateObject(Node::GetTypeStatic()));
+    else
+        newNode = new Node(context_);
 
     // If zero ID specified, or the ID is already taken, let the scene assign
     if (scene_)
@@ -1493,6 +1523,8 @@ void Node::RemoveChild(Vector<SharedPtr<Node> >::Iterator i)
         scene_->SendEvent(E_NODEREMOVED, eventData);
     }
 
+    if (scene_)
+        scene_->RemoveTransforms(*i);
     (*i)->parent_ = 0;
     (*i)->MarkDirty();
     (*i)->MarkNetworkUpdate();
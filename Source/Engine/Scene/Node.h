@@ -58,6 +58,7 @@ class URHO3D_API Node : public Serializable
     BASEOBJECT(Node);
     
     friend class Connection;
+    friend class Scene;
     
 public:
     /// Construct.
@@ -414,6 +415,8 @@ private:
     Scene* scene_;
     /// Unique ID within the scene.
     unsigned id_;
+    /// Index in the scene's flat transform update, or M_MAX_UNSIGNED if not included.
+    unsigned transformIndex_;
     /// Position.
     Vector3 position_;
     /// Rotation.
@@ -0,0 +1,385 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Component.h"
+#include "Context.h"
+#include "FileSystem.h"
+#include "Log.h"
+#include "MemoryBuffer.h"
+#include "Node.h"
+#include "Prefab.h"
+#include "Profiler.h"
+#include "XMLFile.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+Prefab::Prefab(Context* context) :
+    Resource(context),
+    hasIDAttributes_(false)
+{
+}
+
+Prefab::~Prefab()
+{
+}
+
+void Prefab::RegisterObject(Context* context)
+{
+    context->RegisterFactory<Prefab>();
+}
+
+bool Prefab::Load(Deserializer& source)
+{
+    if (GetExtension(source.GetName()) != ".xml")
+        return LoadBinary(source);
+
+    SharedPtr<XMLFile> xml(new XMLFile(context_));
+    if (!xml->Load(source))
+        return false;
+
+    return LoadXML(xml->GetRoot());
+}
+
+bool Prefab::LoadBinary(Deserializer& source)
+{
+    PROFILE(LoadPrefab);
+
+    Clear();
+
+    unsigned nodeID = source.ReadUInt();
+    if (!CompileNode(source, nodeID, M_MAX_UNSIGNED))
+    {
+        Clear();
+        return false;
+    }
+
+    UpdateMemoryUse();
+    return true;
+}
+
+bool Prefab::LoadXML(const XMLElement& source)
+{
+    PROFILE(LoadPrefab);
+
+    Clear();
+
+    if (source.IsNull())
+    {
+        LOGERROR("Could not load prefab, null source element");
+        return false;
+    }
+
+    // Keep the document alive in case some components have to be loaded from their elements
+    xmlFile_ = source.GetFile();
+    if (!CompileNodeXML(source, M_MAX_UNSIGNED))
+    {
+        Clear();
+        return false;
+    }
+
+    if (componentElements_.Empty())
+        xmlFile_.Reset();
+
+    UpdateMemoryUse();
+    return true;
+}
+
+void Prefab::SetAttributes(Serializable* dest, unsigned start, unsigned count) const
+{
+    const Vector<AttributeInfo>* attributes = dest->GetAttributes();
+    if (!attributes)
+        return;
+
+    for (unsigned i = start; i < start + count; ++i)
+    {
+        const PrefabAttribute& attr = attributes_[i];
+        if (attr.index_ < attributes->Size())
+            dest->OnSetAttribute(attributes->At(attr.index_), attr.value_);
+    }
+}
+
+bool Prefab::LoadComponent(Component* dest, unsigned dataIndex) const
+{
+    if (dataIndex < componentData_.Size())
+    {
+        MemoryBuffer buffer(componentData_[dataIndex].GetData(), componentData_[dataIndex].GetSize());
+        return dest->Load(buffer);
+    }
+    else if (dataIndex < componentElements_.Size())
+        return dest->LoadXML(componentElements_[dataIndex]);
+    else
+        return false;
+}
+
+bool Prefab::CompileNode(Deserializer& source, unsigned id, unsigned parent)
+{
+    unsigned index = nodes_.Size();
+    PrefabNode newNode;
+    newNode.id_ = id;
+    newNode.parent_ = parent;
+    newNode.firstAttribute_ = attributes_.Size();
+    nodes_.Push(newNode);
+
+    if (!CompileAttributes(source, context_->GetAttributes(Node::GetTypeStatic())))
+    {
+        LOGERROR("Could not load prefab node, stream not open or at end");
+        return false;
+    }
+
+    nodes_[index].numAttributes_ = attributes_.Size() - nodes_[index].firstAttribute_;
+    nodes_[index].firstComponent_ = components_.Size();
+
+    unsigned numComponents = source.ReadVLE();
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        VectorBuffer compBuffer(source, source.ReadVLE());
+        PrefabComponent newComponent;
+        newComponent.type_ = compBuffer.ReadShortStringHash();
+        newComponent.id_ = compBuffer.ReadUInt();
+        newComponent.firstAttribute_ = attributes_.Size();
+        newComponent.dataIndex_ = M_MAX_UNSIGNED;
+
+        if (context_->GetTypeName(newComponent.type_).Empty())
+        {
+            LOGWARNING("Component type " + newComponent.type_.ToString() + " not known, skipping it in prefab");
+            continue;
+        }
+
+        // If the component has attributes that are not registered to its type, such as a script object's, the data is
+        // not consumed exactly. Then load it from the data when instantiating
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(newComponent.type_);
+        unsigned dataStart = compBuffer.GetPosition();
+        if (!CompileAttributes(compBuffer, attributes) || !compBuffer.IsEof())
+        {
+            attributes_.Resize(newComponent.firstAttribute_);
+            newComponent.dataIndex_ = componentData_.Size();
+            componentData_.Push(VectorBuffer(compBuffer.GetData() + dataStart, compBuffer.GetSize() - dataStart));
+            hasIDAttributes_ = true;
+        }
+        else
+            CheckIDAttributes(attributes);
+
+        newComponent.numAttributes_ = attributes_.Size() - newComponent.firstAttribute_;
+        components_.Push(newComponent);
+    }
+
+    nodes_[index].numComponents_ = components_.Size() - nodes_[index].firstComponent_;
+
+    unsigned numChildren = source.ReadVLE();
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        unsigned childID = source.ReadUInt();
+        if (!CompileNode(source, childID, index))
+            return false;
+    }
+
+    return true;
+}
+
+bool Prefab::CompileNodeXML(const XMLElement& source, unsigned parent)
+{
+    unsigned index = nodes_.Size();
+    PrefabNode newNode;
+    newNode.id_ = source.GetInt("id");
+    newNode.parent_ = parent;
+    newNode.firstAttribute_ = attributes_.Size();
+    nodes_.Push(newNode);
+
+    if (!CompileAttributesXML(source, context_->GetAttributes(Node::GetTypeStatic())))
+        LOGWARNING("Unknown node attribute in prefab XML data");
+
+    nodes_[index].numAttributes_ = attributes_.Size() - nodes_[index].firstAttribute_;
+    nodes_[index].firstComponent_ = components_.Size();
+
+    XMLElement compElem = source.GetChild("component");
+    while (compElem)
+    {
+        String typeName = compElem.GetAttribute("type");
+        PrefabComponent newComponent;
+        newComponent.type_ = ShortStringHash(typeName);
+        newComponent.id_ = compElem.GetInt("id");
+        newComponent.firstAttribute_ = attributes_.Size();
+        newComponent.dataIndex_ = M_MAX_UNSIGNED;
+
+        if (context_->GetTypeName(newComponent.type_).Empty())
+            LOGWARNING("Component type " + typeName + " not known, skipping it in prefab");
+        else
+        {
+            const Vector<AttributeInfo>* attributes = context_->GetAttributes(newComponent.type_);
+            if (!CompileAttributesXML(compElem, attributes))
+            {
+                attributes_.Resize(newComponent.firstAttribute_);
+                newComponent.dataIndex_ = componentElements_.Size();
+                componentElements_.Push(compElem);
+                hasIDAttributes_ = true;
+            }
+            else
+                CheckIDAttributes(attributes);
+
+            newComponent.numAttributes_ = attributes_.Size() - newComponent.firstAttribute_;
+            components_.Push(newComponent);
+        }
+
+        compElem = compElem.GetNext("component");
+    }
+
+    nodes_[index].numComponents_ = components_.Size() - nodes_[index].firstComponent_;
+
+    XMLElement childElem = source.GetChild("node");
+    while (childElem)
+    {
+        if (!CompileNodeXML(childElem, index))
+            return false;
+
+        childElem = childElem.GetNext("node");
+    }
+
+    return true;
+}
+
+bool Prefab::CompileAttributes(Deserializer& source, const Vector<AttributeInfo>* attributes)
+{
+    if (!attributes)
+        return true;
+
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+
+        if (source.IsEof())
+            return false;
+
+        attributes_.Push(PrefabAttribute(i, source.ReadVariant(attr.type_)));
+    }
+
+    return true;
+}
+
+bool Prefab::CompileAttributesXML(const XMLElement& source, const Vector<AttributeInfo>* attributes)
+{
+    bool allKnown = true;
+    XMLElement attrElem = source.GetChild("attribute");
+    unsigned startIndex = 0;
+
+    while (attrElem)
+    {
+        if (!attributes)
+            return false;
+
+        String name = attrElem.GetAttribute("name");
+        unsigned i = startIndex;
+        unsigned attempts = attributes->Size();
+
+        // Match the attributes in the same way as Serializable::LoadXML()
+        while (attempts)
+        {
+            const AttributeInfo& attr = attributes->At(i);
+            if ((attr.mode_ & AM_FILE) && !attr.name_.Compare(name, true))
+            {
+                Variant varValue;
+
+                if (attr.enumNames_)
+                {
+                    String value = attrElem.GetAttribute("value");
+                    int enumValue = 0;
+                    const char** enumPtr = attr.enumNames_;
+                    while (*enumPtr)
+                    {
+                        if (!value.Compare(*enumPtr, false))
+                        {
+                            varValue = enumValue;
+                            break;
+                        }
+                        ++enumPtr;
+                        ++enumValue;
+                    }
+                    if (varValue.IsEmpty())
+                        LOGWARNING("Unknown enum value " + value + " in attribute " + attr.name_);
+                }
+                else
+                    varValue = attrElem.GetVariantValue(attr.type_);
+
+                if (!varValue.IsEmpty())
+                    attributes_.Push(PrefabAttribute(i, varValue));
+
+                startIndex = (i + 1) % attributes->Size();
+                break;
+            }
+            else
+            {
+                i = (i + 1) % attributes->Size();
+                --attempts;
+            }
+        }
+
+        if (!attempts)
+            allKnown = false;
+
+        attrElem = attrElem.GetNext("attribute");
+    }
+
+    return allKnown;
+}
+
+void Prefab::CheckIDAttributes(const Vector<AttributeInfo>* attributes)
+{
+    if (!attributes || hasIDAttributes_)
+        return;
+
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        if (attributes->At(i).mode_ & (AM_NODEID | AM_COMPONENTID | AM_NODEIDVECTOR))
+        {
+            hasIDAttributes_ = true;
+            return;
+        }
+    }
+}
+
+void Prefab::Clear()
+{
+    nodes_.Clear();
+    components_.Clear();
+    attributes_.Clear();
+    componentData_.Clear();
+    componentElements_.Clear();
+    xmlFile_.Reset();
+    hasIDAttributes_ = false;
+}
+
+void Prefab::UpdateMemoryUse()
+{
+    unsigned memoryUse = sizeof(Prefab) + nodes_.Size() * sizeof(PrefabNode) + components_.Size() * sizeof(PrefabComponent) +
+        attributes_.Size() * sizeof(PrefabAttribute);
+    for (unsigned i = 0; i < componentData_.Size(); ++i)
+        memoryUse += componentData_[i].GetSize();
+
+    SetMemoryUse(memoryUse);
+}
+
+}
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Resource.h"
+#include "VectorBuffer.h"
+#include "XMLElement.h"
+
+namespace Urho3D
+{
+
+class Component;
+class Serializable;
+class XMLFile;
+
+/// Attribute value of a prefab node or component, with the attribute's index pre-resolved.
+struct PrefabAttribute
+{
+    /// Construct undefined.
+    PrefabAttribute()
+    {
+    }
+
+    /// Construct with attribute index and value.
+    PrefabAttribute(unsigned index, const Variant& value) :
+        index_(index),
+        value_(value)
+    {
+    }
+
+    /// Index in the object type's attributes.
+    unsigned index_;
+    /// Attribute value.
+    Variant value_;
+};
+
+/// %Node of a prefab.
+struct PrefabNode
+{
+    /// Node ID in the source data.
+    unsigned id_;
+    /// Parent node index, or M_MAX_UNSIGNED for the root node.
+    unsigned parent_;
+    /// Index of the first attribute.
+    unsigned firstAttribute_;
+    /// Number of attributes.
+    unsigned numAttributes_;
+    /// Index of the first component.
+    unsigned firstComponent_;
+    /// Number of components.
+    unsigned numComponents_;
+};
+
+/// %Component of a prefab.
+struct PrefabComponent
+{
+    /// Component type.
+    ShortStringHash type_;
+    /// Component ID in the source data.
+    unsigned id_;
+    /// Index of the first attribute.
+    unsigned firstAttribute_;
+    /// Number of attributes.
+    unsigned numAttributes_;
+    /// Index of the serialized data to load the component from, or M_MAX_UNSIGNED if the attributes have been compiled.
+    unsigned dataIndex_;
+};
+
+/// Compiled node hierarchy for fast repeated instantiation with Scene::Instantiate(). Loaded from the same binary or XML data as Scene::Instantiate() and Scene::InstantiateXML() take, and resolves the attributes once, so that instantiating only creates the objects and writes the attribute values.
+class URHO3D_API Prefab : public Resource
+{
+    OBJECT(Prefab);
+
+public:
+    /// Construct.
+    Prefab(Context* context);
+    /// Destruct.
+    virtual ~Prefab();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Load resource. The data is treated as XML if the source name has the .xml extension, otherwise as binary. Return true if successful.
+    virtual bool Load(Deserializer& source);
+    /// Load from binary node data. Return true if successful.
+    bool LoadBinary(Deserializer& source);
+    /// Load from an XML node element. Return true if successful.
+    bool LoadXML(const XMLElement& source);
+
+    /// Write the compiled attributes to a node or component.
+    void SetAttributes(Serializable* dest, unsigned start, unsigned count) const;
+    /// Load a component whose attributes could not be compiled from its serialized data. Return true if successful.
+    bool LoadComponent(Component* dest, unsigned dataIndex) const;
+
+    /// Return the nodes, parents before their children.
+    const PODVector<PrefabNode>& GetNodes() const { return nodes_; }
+    /// Return the components.
+    const PODVector<PrefabComponent>& GetComponents() const { return components_; }
+    /// Return the compiled attributes.
+    const Vector<PrefabAttribute>& GetAttributes() const { return attributes_; }
+    /// Return whether any component has node or component ID attributes that need to be resolved after instantiation.
+    bool HasIDAttributes() const { return hasIDAttributes_; }
+
+private:
+    /// Compile a node and its children from binary data.
+    bool CompileNode(Deserializer& source, unsigned id, unsigned parent);
+    /// Compile a node and its children from an XML element.
+    bool CompileNodeXML(const XMLElement& source, unsigned parent);
+    /// Compile the attributes of an object type from binary data. Return true if all attributes were read.
+    bool CompileAttributes(Deserializer& source, const Vector<AttributeInfo>* attributes);
+    /// Compile the attributes of an object type from an XML element. Return true if all attributes were recognized.
+    bool CompileAttributesXML(const XMLElement& source, const Vector<AttributeInfo>* attributes);
+    /// Check a component type for ID attributes.
+    void CheckIDAttributes(const Vector<AttributeInfo>* attributes);
+    /// Clear the compiled data.
+    void Clear();
+    /// Update the memory use.
+    void UpdateMemoryUse();
+
+    /// Nodes.
+    PODVector<PrefabNode> nodes_;
+    /// Components.
+    PODVector<PrefabComponent> components_;
+    /// Attribute values.
+    Vector<PrefabAttribute> attributes_;
+    /// Binary data of components that could not be compiled.
+    Vector<VectorBuffer> componentData_;
+    /// XML elements of components that could not be compiled.
+    Vector<XMLElement> componentElements_;
+    /// XML file that the component elements refer to.
+    SharedPtr<XMLFile> xmlFile_;
+    /// ID attributes flag.
+    bool hasIDAttributes_;
+};
+
+}
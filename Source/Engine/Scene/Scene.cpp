@@ -21,12 +21,15 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "Component.h"
 #include "Context.h"
 #include "CoreEvents.h"
 #include "File.h"
 #include "Log.h"
+#include "LogicComponent.h"
 #include "PackageFile.h"
+#include "Prefab.h"
 #include "Profiler.h"
 #include "ReplicationState.h"
 #include "Scene.h"
@@ -50,9 +53,34 @@ static const int ASYNC_LOAD_MIN_FPS = 30;
 static const int ASYNC_LOAD_MAX_MSEC = (int)(1000.0f / ASYNC_LOAD_MIN_FPS);
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const unsigned MIN_THREADED_TRANSFORM_UPDATES = 1024;
+
+void UpdateTransformsWork(const WorkItem* item, unsigned threadIndex)
+{
+    Scene* scene = reinterpret_cast<Scene*>(item->aux_);
+    Node** start = reinterpret_cast<Node**>(item->start_);
+    Node** end = reinterpret_cast<Node**>(item->end_);
+    unsigned startIndex = start - scene->transformNodes_.Begin().ptr_;
+
+    scene->UpdateTransforms(startIndex, startIndex + (end - start));
+}
+
+void UpdateLogicComponentsWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *(reinterpret_cast<float*>(item->aux_));
+    LogicComponent** start = reinterpret_cast<LogicComponent**>(item->start_);
+    LogicComponent** end = reinterpret_cast<LogicComponent**>(item->end_);
+
+    while (start != end)
+    {
+        (*start)->Update(timeStep);
+        ++start;
+    }
+}
 
 Scene::Scene(Context* context) :
     Node(context),
+    delayedDirtyComponents_(0),
     replicatedNodeID_(FIRST_REPLICATED_ID),
     replicatedComponentID_(FIRST_REPLICATED_ID),
     localNodeID_(FIRST_LOCAL_ID),
@@ -64,13 +92,16 @@ Scene::Scene(Context* context) :
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    flatTransformUpdate_(false),
+    numTransformHoles_(0),
+    transformOrderDirty_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, HANDLER(Scene, HandleUpdate));
+    SubscribeToEvent(E_UPDATE, TYPED_HANDLER(Scene, HandleUpdate));
 }
 
 Scene::~Scene()
@@ -375,6 +406,61 @@ Node* Scene::InstantiateXML(Deserializer& source, const Vector3& position, const
     return InstantiateXML(xml->GetRoot(), position, rotation, mode);
 }
 
+Node* Scene::Instantiate(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    if (!prefab || prefab->GetNodes().Empty())
+    {
+        LOGERROR("Null or empty prefab, can not instantiate");
+        return 0;
+    }
+
+    PROFILE(InstantiatePrefab);
+
+    const PODVector<PrefabNode>& nodes = prefab->GetNodes();
+    const PODVector<PrefabComponent>& components = prefab->GetComponents();
+    // The original IDs only need to be remembered if there are ID attributes to resolve
+    bool resolve = prefab->HasIDAttributes();
+    SceneResolver resolver;
+    PODVector<Node*> newNodes(nodes.Size());
+
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        const PrefabNode& nodeData = nodes[i];
+        // Rewrite IDs when instantiating
+        Node* newNode = i ? newNodes[nodeData.parent_]->CreateChild(0, (mode == REPLICATED && nodeData.id_ < FIRST_LOCAL_ID) ?
+            REPLICATED : LOCAL) : CreateChild(0, mode);
+        newNodes[i] = newNode;
+        if (resolve)
+            resolver.AddNode(nodeData.id_, newNode);
+        prefab->SetAttributes(newNode, nodeData.firstAttribute_, nodeData.numAttributes_);
+
+        for (unsigned j = nodeData.firstComponent_; j < nodeData.firstComponent_ + nodeData.numComponents_; ++j)
+        {
+            const PrefabComponent& compData = components[j];
+            Component* newComponent = newNode->CreateComponent(compData.type_, (mode == REPLICATED && compData.id_ <
+                FIRST_LOCAL_ID) ? REPLICATED : LOCAL);
+            if (!newComponent)
+                continue;
+
+            if (resolve)
+                resolver.AddComponent(compData.id_, newComponent);
+            if (compData.dataIndex_ == M_MAX_UNSIGNED)
+                prefab->SetAttributes(newComponent, compData.firstAttribute_, compData.numAttributes_);
+            else if (!prefab->LoadComponent(newComponent, compData.dataIndex_))
+            {
+                newNodes[0]->Remove();
+                return 0;
+            }
+        }
+    }
+
+    if (resolve)
+        resolver.Resolve();
+    newNodes[0]->ApplyAttributes();
+    newNodes[0]->SetTransform(position, rotation);
+    return newNodes[0];
+}
+
 void Scene::Clear(bool clearReplicated, bool clearLocal)
 {
     StopAsyncLoading();
@@ -461,6 +547,34 @@ void Scene::UnregisterAllVars()
     varNames_.Clear();
 }
 
+void Scene::SetFlatTransformUpdate(bool enable)
+{
+    if (enable == flatTransformUpdate_)
+        return;
+
+    flatTransformUpdate_ = enable;
+
+    // Build the order on the next update, or release it now
+    if (enable)
+        transformOrderDirty_ = true;
+    else
+    {
+        for (unsigned i = 0; i < transformNodes_.Size(); ++i)
+        {
+            if (transformNodes_[i])
+                transformNodes_[i]->transformIndex_ = M_MAX_UNSIGNED;
+        }
+
+        transformNodes_.Clear();
+        transformParents_.Clear();
+        worldTransforms_.Clear();
+        worldRotations_.Clear();
+        transformDirty_.Clear();
+        transformLevels_.Clear();
+        numTransformHoles_ = 0;
+    }
+}
+
 Node* Scene::GetNode(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
@@ -515,6 +629,30 @@ const String& Scene::GetVarName(ShortStringHash hash) const
     return i != varNames_.End() ? i->second_ : String::EMPTY;
 }
 
+void Scene::GetAllComponents(PODVector<Component*>& dest, ShortStringHash type) const
+{
+    dest.Clear();
+
+    ObjectPool* pool = context_->GetObjectPool(type);
+    if (!pool)
+    {
+        GetComponents(dest, type, true);
+        return;
+    }
+
+    // The pool holds the components of all scenes, as well as components whose node has been destroyed
+    unsigned capacity = pool->GetSlabCapacity();
+    for (unsigned i = 0; i < pool->GetNumSlabs(); ++i)
+    {
+        for (unsigned j = 0; j < capacity; ++j)
+        {
+            Component* component = static_cast<Component*>(pool->GetObject(i, j));
+            if (component && component->GetNode() && component->GetNode()->GetScene() == this)
+                dest.Push(component);
+        }
+    }
+}
+
 void Scene::Update(float timeStep)
 {
     if (asyncLoading_)
@@ -527,17 +665,25 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
-    using namespace SceneUpdate;
+    // Update variable timestep logic
+    SceneUpdateEvent updateEvent(E_SCENEUPDATE, this, timeStep);
+    SendEvent(updateEvent);
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_SCENE] = this;
-    eventData[P_TIMESTEP] = timeStep;
+    // Update the thread-safe logic components in the worker threads. Transform changes are handled as in the threaded octree
+    // update: components that can not react to them in the worker threads are notified when the phase ends
+    if (!parallelUpdates_.Empty())
+    {
+        PROFILE(ParallelUpdate);
 
-    // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        BeginThreadedUpdate();
+        queue->ParallelFor(UpdateLogicComponentsWork, parallelUpdates_.Begin().ptr_, parallelUpdates_.End().ptr_, &timeStep);
+        EndThreadedUpdate();
+    }
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
-    SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    SceneUpdateEvent subsystemUpdateEvent(E_SCENESUBSYSTEMUPDATE, this, timeStep);
+    SendEvent(subsystemUpdateEvent);
 
     // Update transform smoothing
     {
@@ -554,7 +700,11 @@ void Scene::Update(float timeStep)
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    SceneUpdateEvent postUpdateEvent(E_SCENEPOSTUPDATE, this, timeStep);
+    SendEvent(postUpdateEvent);
+
+    if (flatTransformUpdate_)
+        UpdateTransforms();
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -576,20 +726,47 @@ void Scene::EndThreadedUpdate()
 
     threadedUpdate_ = false;
 
-    if (!delayedDirtyComponents_.Empty())
+    if (delayedDirtyComponents_)
     {
         PROFILE(EndThreadedUpdate);
 
-        for (PODVector<Component*>::ConstIterator i = delayedDirtyComponents_.Begin(); i != delayedDirtyComponents_.End(); ++i)
-            (*i)->OnMarkedDirty((*i)->GetNode());
-        delayedDirtyComponents_.Clear();
+        // The worker threads have finished, so the list can be detached without atomic operations. Notify in queueing order
+        Component* components = delayedDirtyComponents_;
+        delayedDirtyComponents_ = 0;
+        Component* reversed = 0;
+        while (components)
+        {
+            Component* next = components->delayedDirtyNext_;
+            components->delayedDirtyNext_ = reversed;
+            reversed = components;
+            components = next;
+        }
+
+        while (reversed)
+        {
+            Component* component = reversed;
+            reversed = component->delayedDirtyNext_;
+            component->delayedDirtyNext_ = 0;
+            component->delayedDirty_ = 0;
+            component->OnMarkedDirty(component->GetNode());
+        }
     }
 }
 
 void Scene::DelayedMarkedDirty(Component* component)
 {
-    MutexLock lock(sceneMutex_);
-    delayedDirtyComponents_.Push(component);
+    // Queue each component once, however many times its node is dirtied during the threaded update
+    if (!AtomicCompareExchange(&component->delayedDirty_, 1, 0))
+        return;
+
+    // Push to the front of the list. The list is only detached after the worker threads have finished
+    for (;;)
+    {
+        Component* next = delayedDirtyComponents_;
+        component->delayedDirtyNext_ = next;
+        if (AtomicCompareExchangePointer((void* volatile*)&delayedDirtyComponents_, component, next))
+            break;
+    }
 }
 
 unsigned Scene::GetFreeNodeID(CreateMode mode)
@@ -868,12 +1045,99 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void Scene::UpdateTransforms()
 {
-    using namespace Update;
+    if (!flatTransformUpdate_)
+        return;
+
+    PROFILE(UpdateTransforms);
+
+    if (transformOrderDirty_)
+        RebuildTransformOrder();
+
+    // The nodes of each level only depend on the previous levels, so a level can be split between threads
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    bool threaded = queue->GetNumThreads() > 0;
 
+    for (unsigned i = 0; i + 1 < transformLevels_.Size(); ++i)
+    {
+        unsigned start = transformLevels_[i];
+        unsigned end = transformLevels_[i + 1];
+
+        if (threaded && end - start >= MIN_THREADED_TRANSFORM_UPDATES)
+            queue->ParallelFor(UpdateTransformsWork, transformNodes_.Begin().ptr_ + start, transformNodes_.Begin().ptr_ + end, this);
+        else
+            UpdateTransforms(start, end);
+    }
+}
+
+void Scene::AddTransforms(Node* node)
+{
+    // A pending rebuild will pick up the node. If the parent is not in the order, it is not attached to the scene either
+    if (!flatTransformUpdate_ || transformOrderDirty_ || node->transformIndex_ != M_MAX_UNSIGNED)
+        return;
+    Node* parent = node->parent_;
+    unsigned parentIndex = parent == this ? M_MAX_UNSIGNED : parent->transformIndex_;
+    if (parent != this && parentIndex == M_MAX_UNSIGNED)
+        return;
+
+    // Append to the last level, or start a new level if the parent is on it
+    unsigned index = transformNodes_.Size();
+    unsigned numLevels = transformLevels_.Size() - 1;
+    if (!numLevels || (parentIndex != M_MAX_UNSIGNED && parentIndex >= transformLevels_[numLevels - 1]))
+        transformLevels_.Push(index + 1);
+    else
+        transformLevels_.Back() = index + 1;
+
+    transformNodes_.Push(node);
+    transformParents_.Push(parentIndex);
+    worldTransforms_.Push(Matrix3x4::IDENTITY);
+    worldRotations_.Push(Quaternion::IDENTITY);
+    transformDirty_.Push(1);
+    node->transformIndex_ = index;
+
+    for (Vector<SharedPtr<Node> >::ConstIterator i = node->children_.Begin(); i != node->children_.End(); ++i)
+        AddTransforms(*i);
+}
+
+void Scene::RemoveTransforms(Node* node)
+{
+    if (node->transformIndex_ != M_MAX_UNSIGNED)
+    {
+        RemoveTransform(node->transformIndex_);
+        node->transformIndex_ = M_MAX_UNSIGNED;
+    }
+
+    for (Vector<SharedPtr<Node> >::ConstIterator i = node->children_.Begin(); i != node->children_.End(); ++i)
+        RemoveTransforms(*i);
+}
+
+void Scene::RemoveTransform(unsigned index)
+{
+    transformNodes_[index] = 0;
+    transformDirty_[index] = 0;
+
+    // Compact the order once half of it is holes
+    ++numTransformHoles_;
+    if (numTransformHoles_ * 2 > transformNodes_.Size())
+        transformOrderDirty_ = true;
+}
+
+void Scene::AddParallelUpdate(LogicComponent* component)
+{
+    if (component)
+        parallelUpdates_.Push(component);
+}
+
+void Scene::RemoveParallelUpdate(LogicComponent* component)
+{
+    parallelUpdates_.Remove(component);
+}
+
+void Scene::HandleUpdate(StringHash eventType, UpdateEvent& eventData)
+{
     if (updateEnabled_)
-        Update(eventData[P_TIMESTEP].GetFloat());
+        Update(eventData.timeStep_);
 }
 
 void Scene::UpdateAsyncLoading()
@@ -958,6 +1222,123 @@ void Scene::FinishSaving(Serializer* dest) const
     }
 }
 
+void Scene::RebuildTransformOrder()
+{
+    PROFILE(RebuildTransformOrder);
+
+    // Nodes that have been detached from the hierarchy are left out of the new order
+    for (unsigned i = 0; i < transformNodes_.Size(); ++i)
+    {
+        if (transformNodes_[i])
+            transformNodes_[i]->transformIndex_ = M_MAX_UNSIGNED;
+    }
+
+    transformNodes_.Clear();
+    transformParents_.Clear();
+    transformLevels_.Clear();
+
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
+    {
+        transformNodes_.Push(*i);
+        transformParents_.Push(M_MAX_UNSIGNED);
+    }
+
+    // Append the children of each level after it
+    unsigned levelStart = 0;
+    transformLevels_.Push(0);
+    while (levelStart < transformNodes_.Size())
+    {
+        unsigned levelEnd = transformNodes_.Size();
+        for (unsigned i = levelStart; i < levelEnd; ++i)
+        {
+            const Vector<SharedPtr<Node> >& children = transformNodes_[i]->children_;
+            for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+            {
+                transformNodes_.Push(*j);
+                transformParents_.Push(i);
+            }
+        }
+
+        transformLevels_.Push(levelEnd);
+        levelStart = levelEnd;
+    }
+
+    unsigned numNodes = transformNodes_.Size();
+    worldTransforms_.Resize(numNodes);
+    worldRotations_.Resize(numNodes);
+    transformDirty_.Resize(numNodes);
+
+    // Nodes with a valid world transform only need to be copied. The rest are updated on the next pass
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = transformNodes_[i];
+        node->transformIndex_ = i;
+        transformDirty_[i] = node->dirty_ ? 1 : 0;
+        if (!node->dirty_)
+        {
+            worldTransforms_[i] = node->worldTransform_;
+            worldRotations_[i] = node->worldRotation_;
+        }
+    }
+
+    numTransformHoles_ = 0;
+    transformOrderDirty_ = false;
+}
+
+void Scene::UpdateTransforms(unsigned start, unsigned end)
+{
+    for (unsigned i = start; i < end; ++i)
+    {
+        if (!transformDirty_[i])
+            continue;
+
+        transformDirty_[i] = 0;
+        Node* node = transformNodes_[i];
+
+        // The node may have already been updated on demand. Otherwise use the parent's world transform from the previous
+        // levels instead of walking up the hierarchy
+        if (node->dirty_)
+        {
+            unsigned parent = transformParents_[i];
+            if (parent == M_MAX_UNSIGNED)
+            {
+                node->worldTransform_ = node->GetTransform();
+                node->worldRotation_ = node->rotation_;
+            }
+            else
+            {
+                node->worldTransform_ = worldTransforms_[parent] * node->GetTransform();
+                node->worldRotation_ = worldRotations_[parent] * node->rotation_;
+            }
+
+            node->dirty_ = false;
+        }
+
+        // Only nodes with children are read back by the next levels
+        if (!node->children_.Empty())
+        {
+            worldTransforms_[i] = node->worldTransform_;
+            worldRotations_[i] = node->worldRotation_;
+        }
+    }
+}
+
+void SceneUpdateEvent::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace SceneUpdate;
+
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
+void SceneUpdateEvent::FromVariantMap(const VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+
+    scene_ = static_cast<Scene*>(GetParameter(eventData, P_SCENE).GetPtr());
+    timeStep_ = GetParameter(eventData, P_TIMESTEP).GetFloat();
+}
+
 void RegisterSceneLibrary(Context* context)
 {
     Node::RegisterObject(context);
@@ -965,6 +1346,7 @@ void RegisterSceneLibrary(Context* context)
     SmoothedTransform::RegisterObject(context);
     UnknownComponent::RegisterObject(context);
     SplinePath::RegisterObject(context);
+    Prefab::RegisterObject(context);
 }
 
 }
@@ -32,7 +32,11 @@ namespace Urho3D
 {
 
 class File;
+class LogicComponent;
 class PackageFile;
+class Prefab;
+class UpdateEvent;
+struct WorkItem;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -62,6 +66,8 @@ class URHO3D_API Scene : public Node
     using Node::GetComponent;
     using Node::SaveXML;
 
+    friend void UpdateTransformsWork(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     Scene(Context* context);
@@ -95,6 +101,8 @@ public:
     Node* InstantiateXML(const XMLElement& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Instantiate scene content from XML data. Return root node if successful.
     Node* InstantiateXML(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate scene content from a compiled prefab. Return root node if successful.
+    Node* Instantiate(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Clear scene completely of either replicated, local or all nodes and components.
     void Clear(bool clearReplicated = true, bool clearLocal = true);
     /// Enable or disable scene update.
@@ -117,6 +125,8 @@ public:
     void UnregisterVar(const String& name);
     /// Clear all registered node user variable hash reverse mappings.
     void UnregisterAllVars();
+    /// Set whether to update the dirty world transforms of all nodes in one flat pass at the end of the scene update, instead of on demand. Default false.
+    void SetFlatTransformUpdate(bool enable);
 
     /// Return node from the whole scene by ID, or null if not found.
     Node* GetNode(unsigned id) const;
@@ -144,6 +154,12 @@ public:
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
     /// Return a node user variable name, or empty if not registered.
     const String& GetVarName(ShortStringHash hash) const;
+    /// Return all components of a type in the scene, in no particular order. If the type is pooled, iterates its object pool instead of the nodes; components added with AddComponent() instead of being created by the factory are then not included.
+    void GetAllComponents(PODVector<Component*>& dest, ShortStringHash type) const;
+    /// Template version of returning all components of a type in the scene.
+    template <class T> void GetAllComponents(PODVector<T*>& dest) const;
+    /// Return whether dirty world transforms are updated in one flat pass.
+    bool GetFlatTransformUpdate() const { return flatTransformUpdate_; }
 
     /// Update scene. Called by HandleUpdate.
     void Update(float timeStep);
@@ -151,7 +167,7 @@ public:
     void BeginThreadedUpdate();
     /// End a threaded update. Notify components that marked themselves for delayed dirty processing.
     void EndThreadedUpdate();
-    /// Add a component to the delayed dirty notify queue. Is thread-safe.
+    /// Add a component to the delayed dirty notify queue, unless already queued. Is thread-safe and does not lock.
     void DelayedMarkedDirty(Component* component);
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
@@ -181,10 +197,22 @@ public:
     void MarkNetworkUpdate(Component* component);
     /// Mark a node dirty in scene replication states. The node does not need to have own replication state yet.
     void MarkReplicationDirty(Node* node);
+    /// Update the dirty world transforms in the flat transform update order. Called at the end of the scene update when enabled.
+    void UpdateTransforms();
+    /// Mark a node's world transform dirty in the flat transform update. Is thread-safe. Called by Node.
+    void MarkTransformDirty(unsigned index) { transformDirty_[index] = 1; }
+    /// Append a node and its children to the flat transform update after it has been added to a parent. Called by Node.
+    void AddTransforms(Node* node);
+    /// Remove a node and its children from the flat transform update before it is removed from its parent or the scene. Called by Node.
+    void RemoveTransforms(Node* node);
+    /// Add a logic component to the parallel update phase. Called by LogicComponent.
+    void AddParallelUpdate(LogicComponent* component);
+    /// Remove a logic component from the parallel update phase. Called by LogicComponent.
+    void RemoveParallelUpdate(LogicComponent* component);
 
 private:
     /// Handle the logic update event to update the scene, if active.
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleUpdate(StringHash eventType, UpdateEvent& eventData);
     /// Update asynchronous loading.
     void UpdateAsyncLoading();
     /// Finish asynchronous loading.
@@ -193,6 +221,12 @@ private:
     void FinishLoading(Deserializer* source);
     /// Finish saving. Sets the scene filename and checksum.
     void FinishSaving(Serializer* dest) const;
+    /// Sort the nodes breadth-first into the flat transform update order.
+    void RebuildTransformOrder();
+    /// Update the dirty world transforms of a range of the flat transform update order.
+    void UpdateTransforms(unsigned start, unsigned end);
+    /// Remove a node from the flat transform update order.
+    void RemoveTransform(unsigned index);
 
     /// Replicated scene nodes by ID.
     HashMap<unsigned, Node*> replicatedNodes_;
@@ -216,10 +250,24 @@ private:
     HashSet<unsigned> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
     HashSet<unsigned> networkUpdateComponents_;
-    /// Delayed dirty notification queue for components.
-    PODVector<Component*> delayedDirtyComponents_;
-    /// Mutex for the delayed dirty notification queue.
+    /// Delayed dirty notification queue for components as an intrusive list, most recently queued first.
+    Component* volatile delayedDirtyComponents_;
+    /// Mutex for the network update sets during threaded update.
     Mutex sceneMutex_;
+    /// Nodes in the flat transform update order: breadth-first, so that parents come before their children. Added nodes are appended to a level after their parent's and removed nodes are null until the order is rebuilt.
+    PODVector<Node*> transformNodes_;
+    /// Parent indices in the flat transform update order, or M_MAX_UNSIGNED for the root-level nodes.
+    PODVector<unsigned> transformParents_;
+    /// World transforms in the flat transform update order.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// World rotations in the flat transform update order.
+    PODVector<Quaternion> worldRotations_;
+    /// World transform dirty flags in the flat transform update order.
+    PODVector<unsigned char> transformDirty_;
+    /// Start indices of each hierarchy level in the flat transform update order, followed by the end index.
+    PODVector<unsigned> transformLevels_;
+    /// Logic components updated in the worker threads after the scene update event.
+    PODVector<LogicComponent*> parallelUpdates_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
     /// Next free non-local node ID.
@@ -246,8 +294,16 @@ private:
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Flat transform update flag.
+    bool flatTransformUpdate_;
+    /// Number of removed nodes in the flat transform update order.
+    unsigned numTransformHoles_;
+    /// Flat transform update order needs rebuild flag.
+    bool transformOrderDirty_;
 };
 
+template <class T> void Scene::GetAllComponents(PODVector<T*>& dest) const { GetAllComponents(reinterpret_cast<PODVector<Component*>&>(dest), T::GetTypeStatic()); }
+
 /// Register Scene library objects.
 void URHO3D_API RegisterSceneLibrary(Context* context);
 
@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -72,6 +74,31 @@ EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed parameters of the scene update, scene subsystem update and scene post-update events.
+class URHO3D_API SceneUpdateEvent : public TypedEvent
+{
+    TYPED_EVENT(SceneUpdateEvent);
+
+public:
+    /// Construct.
+    SceneUpdateEvent(StringHash eventType, Scene* scene = 0, float timeStep = 0.0f) :
+        TypedEvent(eventType),
+        scene_(scene),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const;
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData);
+    
+    /// Scene.
+    Scene* scene_;
+    /// Timestep in seconds.
+    float timeStep_;
+};
+
 /// Asynchronous scene loading progress.
 EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
@@ -35,6 +35,7 @@
 #include "Material.h"
 #include "Octree.h"
 #include "ParticleEmitter.h"
+#include "PoseCache.h"
 #include "Renderer.h"
 #include "RenderPath.h"
 #include "Scene.h"
@@ -699,6 +700,8 @@ static void RegisterAnimation(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Animation", "void set_numTriggers(uint)", asMETHOD(Animation, SetNumTriggers), asCALL_THISCALL);
     engine->RegisterObjectMethod("Animation", "AnimationTriggerPoint@+ get_triggers(uint) const", asFUNCTION(AnimationGetTrigger), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Animation", "uint get_numTriggers() const", asMETHOD(Animation, GetNumTriggers), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Animation", "void Compress(float positionError = 0.001, float rotationError = 0.001, float scaleError = 0.001)", asMETHOD(Animation, Compress), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Animation", "bool get_compressed() const", asMETHOD(Animation, IsCompressed), asCALL_THISCALL);
 }
 
 static void RegisterDrawable(asIScriptEngine* engine)
@@ -898,11 +901,27 @@ static void AnimationStateSetBoneWeight(const String& name, float weight, Animat
     ptr->SetBoneWeight(name, weight);
 }
 
+static PoseCache* ConstructPoseCache()
+{
+    return new PoseCache();
+}
+
 static void RegisterAnimatedModel(asIScriptEngine* engine)
 {
     RegisterRefCounted<AnimationState>(engine, "AnimationState");
+    RegisterRefCounted<PoseCache>(engine, "PoseCache");
     RegisterStaticModel<AnimatedModel>(engine, "AnimatedModel", false);
     
+    engine->RegisterObjectBehaviour("PoseCache", asBEHAVE_FACTORY, "PoseCache@+ f()", asFUNCTION(ConstructPoseCache), asCALL_CDECL);
+    engine->RegisterObjectMethod("PoseCache", "void Clear()", asMETHOD(PoseCache, Clear), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "void ResetStats()", asMETHOD(PoseCache, ResetStats), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "void set_timeStep(float)", asMETHOD(PoseCache, SetTimeStep), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "float get_timeStep() const", asMETHOD(PoseCache, GetTimeStep), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "void set_maxPoses(uint)", asMETHOD(PoseCache, SetMaxPoses), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "uint get_maxPoses() const", asMETHOD(PoseCache, GetMaxPoses), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "uint get_numPoses() const", asMETHOD(PoseCache, GetNumPoses), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "uint get_numHits() const", asMETHOD(PoseCache, GetNumHits), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PoseCache", "uint get_numMisses() const", asMETHOD(PoseCache, GetNumMisses), asCALL_THISCALL);
     engine->RegisterObjectBehaviour("AnimationState", asBEHAVE_FACTORY, "AnimationState@+ f(Node@+, Animation@+)", asFUNCTION(ConstructAnimationState), asCALL_CDECL);
     engine->RegisterObjectMethod("AnimationState", "void AddWeight(float)", asMETHOD(AnimationState, AddWeight), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimationState", "void AddTime(float)", asMETHOD(AnimationState, AddTime), asCALL_THISCALL);
@@ -939,6 +958,8 @@ static void RegisterAnimatedModel(asIScriptEngine* engine)
     engine->RegisterObjectMethod("AnimatedModel", "void RemoveAllAnimationStates()", asMETHOD(AnimatedModel, RemoveAllAnimationStates), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "void SetMorphWeight(uint, float)", asMETHODPR(AnimatedModel, SetMorphWeight, (unsigned, float), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "void ResetMorphWeights()", asMETHOD(AnimatedModel, ResetMorphWeights), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "Node@+ CreateBoneNode(const String&in)", asMETHOD(AnimatedModel, CreateBoneNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "void RemoveBoneNode(const String&in)", asMETHOD(AnimatedModel, RemoveBoneNode), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "float GetMorphWeight(uint) const", asMETHODPR(AnimatedModel, GetMorphWeight, (unsigned) const, float), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "AnimationState@+ GetAnimationState(Animation@+) const", asMETHODPR(AnimatedModel, GetAnimationState, (Animation*) const, AnimationState*), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "AnimationState@+ GetAnimationState(uint) const", asMETHODPR(AnimatedModel, GetAnimationState, (unsigned) const, AnimationState*), asCALL_THISCALL);
@@ -947,6 +968,12 @@ static void RegisterAnimatedModel(asIScriptEngine* engine)
     engine->RegisterObjectMethod("AnimatedModel", "float get_animationLodBias() const", asMETHOD(AnimatedModel, GetAnimationLodBias), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "void set_updateInvisible(bool)", asMETHOD(AnimatedModel, SetUpdateInvisible), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "bool get_updateInvisible() const", asMETHOD(AnimatedModel, GetUpdateInvisible), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "void set_usePoseBuffer(bool)", asMETHOD(AnimatedModel, SetUsePoseBuffer), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "bool get_usePoseBuffer() const", asMETHOD(AnimatedModel, GetUsePoseBuffer), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "void set_poseCache(PoseCache@+)", asMETHOD(AnimatedModel, SetPoseCache), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "PoseCache@+ get_poseCache() const", asMETHOD(AnimatedModel, GetPoseCache), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "void set_cpuSkinning(bool)", asMETHOD(AnimatedModel, SetCPUSkinning), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "bool get_cpuSkinning() const", asMETHOD(AnimatedModel, GetCPUSkinning), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "Skeleton@+ get_skeleton()", asMETHOD(AnimatedModel, GetSkeleton), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "uint get_numAnimationStates() const", asMETHOD(AnimatedModel, GetNumAnimationStates), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "AnimationState@+ get_animationStates(const String&in) const", asMETHODPR(AnimatedModel, GetAnimationState, (const String&) const, AnimationState*), asCALL_THISCALL);
@@ -1361,6 +1388,7 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Renderer", "uint get_numLights(bool) const", asMETHOD(Renderer, GetNumLights), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "uint get_numShadowMaps(bool) const", asMETHOD(Renderer, GetNumShadowMaps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "uint get_numOccluders(bool) const", asMETHOD(Renderer, GetNumOccluders), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_numSkippedDrawables(bool) const", asMETHOD(Renderer, GetNumSkippedDrawables), asCALL_THISCALL);
     engine->RegisterGlobalFunction("Renderer@+ get_renderer()", asFUNCTION(GetRenderer), asCALL_CDECL);
 }
 
@@ -1509,6 +1537,8 @@ static void RegisterOctree(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Octree", "Array<Node@>@ GetDrawables(const Sphere&in, uint8 drawableFlags = DRAWABLE_ANY, uint viewMask = DEFAULT_VIEWMASK)", asFUNCTION(OctreeGetDrawablesSphere), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Octree", "const BoundingBox& get_worldBoundingBox() const", asMETHODPR(Octree, GetWorldBoundingBox, () const, const BoundingBox&), asCALL_THISCALL);
     engine->RegisterObjectMethod("Octree", "uint get_numLevels() const", asMETHOD(Octree, GetNumLevels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Octree", "void set_packedCulling(bool)", asMETHOD(Octree, SetPackedCulling), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Octree", "bool get_packedCulling() const", asMETHOD(Octree, GetPackedCulling), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Octree@+ get_octree() const", asFUNCTION(SceneGetOctree), asCALL_CDECL_OBJLAST);
     engine->RegisterGlobalFunction("Octree@+ get_octree()", asFUNCTION(GetOctree), asCALL_CDECL);
 }
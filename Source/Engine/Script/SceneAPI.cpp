@@ -24,6 +24,7 @@
 #include "APITemplates.h"
 #include "DebugRenderer.h"
 #include "PackageFile.h"
+#include "Prefab.h"
 #include "Scene.h"
 #include "SmoothedTransform.h"
 #include "Sort.h"
@@ -203,6 +204,13 @@ static void RegisterSplinePath(asIScriptEngine* engine)
     engine->RegisterObjectMethod("SplinePath", "bool get_isFinished() const", asMETHOD(SplinePath, IsFinished), asCALL_THISCALL);
 }
 
+static void RegisterPrefab(asIScriptEngine* engine)
+{
+    RegisterResource<Prefab>(engine, "Prefab");
+    engine->RegisterObjectMethod("Prefab", "bool LoadXML(const XMLElement&in)", asMETHOD(Prefab, LoadXML), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Prefab", "bool get_hasIDAttributes() const", asMETHOD(Prefab, HasIDAttributes), asCALL_THISCALL);
+}
+
 static void RegisterScene(asIScriptEngine* engine)
 {
     engine->RegisterGlobalProperty("const uint FIRST_REPLICATED_ID", (void*)&FIRST_REPLICATED_ID);
@@ -222,6 +230,7 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "Node@+ InstantiateXML(File@+, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asFUNCTION(SceneInstantiateXML), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "Node@+ InstantiateXML(XMLFile@+, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asFUNCTION(SceneInstantiateXMLFile), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "Node@+ InstantiateXML(const XMLElement&in, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asMETHODPR(Scene, InstantiateXML, (const XMLElement&, const Vector3&, const Quaternion&, CreateMode), Node*), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "Node@+ Instantiate(Prefab@+, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asMETHODPR(Scene, Instantiate, (Prefab*, const Vector3&, const Quaternion&, CreateMode), Node*), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void Clear(bool clearReplicated = true, bool clearLocal = true)", asMETHOD(Scene, Clear), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void AddRequiredPackageFile(PackageFile@+)", asMETHOD(Scene, AddRequiredPackageFile), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void ClearRequiredPackageFiles()", asMETHOD(Scene, ClearRequiredPackageFiles), asCALL_THISCALL);
@@ -234,6 +243,8 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "void Update(float)", asMETHOD(Scene, Update), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_updateEnabled(bool)", asMETHOD(Scene, SetUpdateEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "bool get_updateEnabled() const", asMETHOD(Scene, IsUpdateEnabled), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_flatTransformUpdate(bool)", asMETHOD(Scene, SetFlatTransformUpdate), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool get_flatTransformUpdate() const", asMETHOD(Scene, GetFlatTransformUpdate), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_timeScale(float)", asMETHOD(Scene, SetTimeScale), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "float get_timeScale() const", asMETHOD(Scene, GetTimeScale), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_elapsedTime(float)", asMETHOD(Scene, SetElapsedTime), asCALL_THISCALL);
@@ -263,6 +274,7 @@ void RegisterSceneAPI(asIScriptEngine* engine)
     RegisterNode(engine);
     RegisterSmoothedTransform(engine);
     RegisterSplinePath(engine);
+    RegisterPrefab(engine);
     RegisterScene(engine);
 }
 
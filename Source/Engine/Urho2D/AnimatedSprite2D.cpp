@@ -80,7 +80,7 @@ void AnimatedSprite2D::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(AnimatedSprite2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(AnimatedSprite2D, HandleScenePostUpdate));
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -145,15 +145,13 @@ void AnimatedSprite2D::OnNodeSet(Node* node)
     {
         Scene* scene = GetScene();
         if (scene && IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(AnimatedSprite2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(AnimatedSprite2D, HandleScenePostUpdate));
     }
 }
 
-void AnimatedSprite2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void AnimatedSprite2D::HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
-    using namespace ScenePostUpdate;
-    float timeStep = eventData[P_TIMESTEP].GetFloat();
-    animationTime_ += timeStep * speed_;
+    animationTime_ += eventData.timeStep_ * speed_;
 
     if (!animation_)
         return;
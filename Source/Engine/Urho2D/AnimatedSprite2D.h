@@ -28,6 +28,7 @@ namespace Urho3D
 {
 
 class Animation2D;
+class SceneUpdateEvent;
 
 /// Cycle mode.
 enum CycleMode
@@ -79,7 +80,7 @@ protected:
     /// Handle node being assigned.
     virtual void OnNodeSet(Node* node);
     /// Handle scene post update.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData);
 
     /// Speed.
     float speed_;
@@ -245,29 +245,7 @@ void DrawableProxy2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& ev
         PROFILE(CheckDrawableVisibility);
 
         WorkQueue* queue = GetSubsystem<WorkQueue>();
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = drawables_.Size() / numWorkItems;
-        
-        PODVector<Drawable2D*>::Iterator start = drawables_.Begin();
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckDrawableVisibility;
-            item->aux_ = this;
-
-            PODVector<Drawable2D*>::Iterator end = drawables_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-            
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-            
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->ParallelFor(CheckDrawableVisibility, drawables_.Begin().ptr_, drawables_.End().ptr_, this);
     }
 
     vertexCount_ = 0;
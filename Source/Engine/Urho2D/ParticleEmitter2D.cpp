@@ -67,7 +67,7 @@ void ParticleEmitter2D::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -175,7 +175,7 @@ void ParticleEmitter2D::OnNodeSet(Node* node)
     {
         Scene* scene = GetScene();
         if (scene && IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, TYPED_HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
     }
 }
 
@@ -240,7 +240,7 @@ void ParticleEmitter2D::UpdateVertices()
     verticesDirty_ = false;
 }
 
-void ParticleEmitter2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void ParticleEmitter2D::HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData)
 {
     MarkForUpdate();
 }
@@ -28,6 +28,7 @@ namespace Urho3D
 {
 
 class ParticleEffect2D;
+class SceneUpdateEvent;
 
 /// 2D particle.
  struct Particle2D
@@ -107,7 +108,7 @@ private:
     /// Update vertices.
     virtual void UpdateVertices();
     /// Handle scene post update.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, SceneUpdateEvent& eventData);
     /// Emit particle.
     bool EmitParticle(const Vector3& worldPosition, float worldAngle, float worldScale);
     /// Update particle.
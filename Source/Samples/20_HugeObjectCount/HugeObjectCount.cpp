@@ -49,7 +49,8 @@ HugeObjectCount::HugeObjectCount(Context* context) :
     yaw_(0.0f),
     pitch_(0.0f),
     animate_(false),
-    useGroups_(false)
+    useGroups_(false),
+    packedCulling_(false)
 {
 }
 
@@ -85,7 +86,8 @@ void HugeObjectCount::CreateScene()
     
     // Create the Octree component to the scene so that drawable objects can be rendered. Use default volume
     // (-1000, -1000, -1000) to (1000, 1000, 1000)
-    scene_->CreateComponent<Octree>();
+    Octree* octree = scene_->CreateComponent<Octree>();
+    octree->SetPackedCulling(packedCulling_);
 
     // Create a Zone for ambient light & fog control
     Node* zoneNode = scene_->CreateChild("Zone");
@@ -170,7 +172,8 @@ void HugeObjectCount::CreateInstructions()
     instructionText->SetText(
         "Use WASD keys and mouse to move\n"
         "Space to toggle animation\n"
-        "G to toggle object group optimization"
+        "G to toggle object group optimization\n"
+        "P to toggle packed octree culling"
     );
     instructionText->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
     // The text has multiple rows. Center them in relation to each other
@@ -260,6 +263,13 @@ void HugeObjectCount::HandleUpdate(StringHash eventType, VariantMap& eventData)
         useGroups_ = !useGroups_;
         CreateScene();
     }
+    
+    // Toggle testing the objects' bounding boxes four at a time during octree culling
+    if (input->GetKeyPress('P'))
+    {
+        packedCulling_ = !packedCulling_;
+        scene_->GetComponent<Octree>()->SetPackedCulling(packedCulling_);
+    }
 
     // Move the camera, scale movement with time step
     MoveCamera(timeStep);
@@ -39,6 +39,7 @@ class Scene;
 ///     - Allowing examination of performance hotspots in the rendering code
 ///     - Using the profiler to measure the time taken to animate the scene
 ///     - Optionally speeding up rendering by grouping objects with the StaticModelGroup component
+///     - Optionally switching the octree to test object bounding boxes four at a time when culling
 class HugeObjectCount : public Sample
 {
     OBJECT(HugeObjectCount);
@@ -80,4 +81,6 @@ private:
     bool animate_;
     /// Group optimization flag.
     bool useGroups_;
+    /// Packed octree culling flag.
+    bool packedCulling_;
 };
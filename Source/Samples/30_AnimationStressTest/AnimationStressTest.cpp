@@ -0,0 +1,301 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AnimatedModel.h"
+#include "Animation.h"
+#include "AnimationController.h"
+#include "Camera.h"
+#include "CoreEvents.h"
+#include "Engine.h"
+#include "Font.h"
+#include "Graphics.h"
+#include "Input.h"
+#include "Light.h"
+#include "Material.h"
+#include "Model.h"
+#include "Octree.h"
+#include "PoseCache.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "Text.h"
+#include "UI.h"
+#include "Zone.h"
+
+#include "AnimationStressTest.h"
+
+#include "DebugNew.h"
+
+/// Smallest and largest number of animated models.
+static const unsigned MIN_MODELS = 250;
+static const unsigned MAX_MODELS = 16000;
+
+DEFINE_APPLICATION_MAIN(AnimationStressTest)
+
+AnimationStressTest::AnimationStressTest(Context* context) :
+    Sample(context),
+    yaw_(0.0f),
+    pitch_(20.0f),
+    numModels_(2000),
+    usePoseBuffer_(true),
+    compressAnimation_(false),
+    usePoseCache_(false)
+{
+}
+
+void AnimationStressTest::Start()
+{
+    // Execute base class startup
+    Sample::Start();
+
+    // Create the scene content
+    CreateScene();
+
+    // Create the UI content
+    CreateInstructions();
+
+    // Setup the viewport for displaying the scene
+    SetupViewport();
+
+    // Hook up to the frame update events
+    SubscribeToEvents();
+}
+
+void AnimationStressTest::CreateScene()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    // Clear the scene before changing the animation, as the animation states refer to its tracks
+    if (!scene_)
+        scene_ = new Scene(context_);
+    else
+        scene_->Clear();
+
+    // Compress the walk animation, or reload it from the file to return to the uncompressed keyframes
+    Animation* walkAnimation = cache->GetResource<Animation>("Models/Jack_Walk.ani");
+    if (walkAnimation)
+    {
+        if (compressAnimation_)
+            walkAnimation->Compress();
+        else if (walkAnimation->IsCompressed())
+            cache->ReloadResource(walkAnimation);
+    }
+
+    // Create a new pose cache, as the cached poses of the old animation data are no longer valid
+    poseCache_ = usePoseCache_ ? new PoseCache() : 0;
+
+    // Create octree, use default volume (-1000, -1000, -1000) to (1000, 1000, 1000)
+    scene_->CreateComponent<Octree>();
+
+    // Create scene node & StaticModel component for showing a static plane
+    Node* planeNode = scene_->CreateChild("Plane");
+    planeNode->SetScale(Vector3(500.0f, 1.0f, 500.0f));
+    StaticModel* planeObject = planeNode->CreateComponent<StaticModel>();
+    planeObject->SetModel(cache->GetResource<Model>("Models/Plane.mdl"));
+    planeObject->SetMaterial(cache->GetResource<Material>("Materials/StoneTiled.xml"));
+
+    // Create a Zone component for ambient lighting & fog control
+    Node* zoneNode = scene_->CreateChild("Zone");
+    Zone* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetAmbientColor(Color(0.15f, 0.15f, 0.15f));
+    zone->SetFogColor(Color(0.5f, 0.5f, 0.7f));
+    zone->SetFogStart(200.0f);
+    zone->SetFogEnd(400.0f);
+
+    // Create a directional light to the world. Leave shadows off, so that the frame time is mostly animation
+    Node* lightNode = scene_->CreateChild("DirectionalLight");
+    lightNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    Light* light = lightNode->CreateComponent<Light>();
+    light->SetLightType(LIGHT_DIRECTIONAL);
+
+    // Create the animated models in a square grid, with varying animation start times so that they do not move in unison.
+    // Use AnimationController components to advance the animations
+    const float MODEL_SPACING = 3.0f;
+    int gridSize = (int)ceilf(sqrtf((float)numModels_));
+    Model* jackModel = cache->GetResource<Model>("Models/Jack.mdl");
+    Material* jackMaterial = cache->GetResource<Material>("Materials/Jack.xml");
+
+    for (unsigned i = 0; i < numModels_; ++i)
+    {
+        int x = i % gridSize;
+        int z = i / gridSize;
+        Node* modelNode = scene_->CreateChild("Jack");
+        modelNode->SetPosition(Vector3((x - gridSize / 2) * MODEL_SPACING, 0.0f, (z - gridSize / 2) * MODEL_SPACING));
+        modelNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+        AnimatedModel* modelObject = modelNode->CreateComponent<AnimatedModel>();
+        // The pose buffer mode must be chosen before setting the model, as it decides whether bone nodes are created
+        modelObject->SetUsePoseBuffer(usePoseBuffer_);
+        modelObject->SetModel(jackModel);
+        modelObject->SetMaterial(jackMaterial);
+        // The models copy their pose from the cache when another model has calculated it for the same quantized time
+        modelObject->SetPoseCache(poseCache_);
+
+        AnimationController* controller = modelNode->CreateComponent<AnimationController>();
+        controller->PlayExclusive("Models/Jack_Walk.ani", 0, true);
+        controller->SetTime("Models/Jack_Walk.ani", Random(1.0f));
+    }
+
+    // Create the camera. Create it outside the scene so that we can clear the whole scene without affecting it
+    if (!cameraNode_)
+    {
+        cameraNode_ = new Node(context_);
+        cameraNode_->SetPosition(Vector3(0.0f, 20.0f, -60.0f));
+        cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+        Camera* camera = cameraNode_->CreateComponent<Camera>();
+        camera->SetFarClip(400.0f);
+    }
+}
+
+void AnimationStressTest::CreateInstructions()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    UI* ui = GetSubsystem<UI>();
+
+    // Construct new Text object, set string to display and font to use
+    Text* instructionText = ui->GetRoot()->CreateChild<Text>();
+    instructionText->SetText(
+        "Use WASD keys and mouse to move\n"
+        "PageUp / PageDown to double / halve the number of models\n"
+        "P to toggle pose buffer mode\n"
+        "C to toggle animation compression\n"
+        "X to toggle the shared pose cache"
+    );
+    instructionText->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
+    // The text has multiple rows. Center them in relation to each other
+    instructionText->SetTextAlignment(HA_CENTER);
+
+    // Position the text relative to the screen center
+    instructionText->SetHorizontalAlignment(HA_CENTER);
+    instructionText->SetVerticalAlignment(VA_CENTER);
+    instructionText->SetPosition(0, ui->GetRoot()->GetHeight() / 4);
+
+    // Construct a text to show the current settings at the top of the screen
+    statusText_ = ui->GetRoot()->CreateChild<Text>();
+    statusText_->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
+    statusText_->SetHorizontalAlignment(HA_CENTER);
+    statusText_->SetPosition(0, 10);
+    UpdateStatus();
+}
+
+void AnimationStressTest::UpdateStatus()
+{
+    Animation* walkAnimation = GetSubsystem<ResourceCache>()->GetResource<Animation>("Models/Jack_Walk.ani");
+
+    statusText_->SetText("Models: " + String(numModels_) + "  Pose buffer: " + String(usePoseBuffer_ ? "on" : "off") +
+        "  Animation compression: " + String(compressAnimation_ ? "on" : "off") + "  Animation memory: " +
+        String(walkAnimation ? walkAnimation->GetMemoryUse() : 0) + " bytes  Pose cache: " + String(usePoseCache_ ? "on" : "off"));
+}
+
+void AnimationStressTest::SetupViewport()
+{
+    Renderer* renderer = GetSubsystem<Renderer>();
+
+    // Set up a viewport to the Renderer subsystem so that the 3D scene can be seen
+    SharedPtr<Viewport> viewport(new Viewport(context_, scene_, cameraNode_->GetComponent<Camera>()));
+    renderer->SetViewport(0, viewport);
+}
+
+void AnimationStressTest::SubscribeToEvents()
+{
+    // Subscribe HandleUpdate() function for processing update events
+    SubscribeToEvent(E_UPDATE, HANDLER(AnimationStressTest, HandleUpdate));
+}
+
+void AnimationStressTest::MoveCamera(float timeStep)
+{
+    // Do not move if the UI has a focused element (the console)
+    if (GetSubsystem<UI>()->GetFocusElement())
+        return;
+
+    Input* input = GetSubsystem<Input>();
+
+    // Movement speed as world units per second
+    const float MOVE_SPEED = 20.0f;
+    // Mouse sensitivity as degrees per pixel
+    const float MOUSE_SENSITIVITY = 0.1f;
+
+    // Use this frame's mouse motion to adjust camera node yaw and pitch. Clamp the pitch between -90 and 90 degrees
+    IntVector2 mouseMove = input->GetMouseMove();
+    yaw_ += MOUSE_SENSITIVITY * mouseMove.x_;
+    pitch_ += MOUSE_SENSITIVITY * mouseMove.y_;
+    pitch_ = Clamp(pitch_, -90.0f, 90.0f);
+
+    // Construct new orientation for the camera scene node from yaw and pitch. Roll is fixed to zero
+    cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+
+    // Read WASD keys and move the camera scene node to the corresponding direction if they are pressed
+    if (input->GetKeyDown('W'))
+        cameraNode_->Translate(Vector3::FORWARD * MOVE_SPEED * timeStep);
+    if (input->GetKeyDown('S'))
+        cameraNode_->Translate(Vector3::BACK * MOVE_SPEED * timeStep);
+    if (input->GetKeyDown('A'))
+        cameraNode_->Translate(Vector3::LEFT * MOVE_SPEED * timeStep);
+    if (input->GetKeyDown('D'))
+        cameraNode_->Translate(Vector3::RIGHT * MOVE_SPEED * timeStep);
+}
+
+void AnimationStressTest::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace Update;
+
+    // Take the frame time step, which is stored as a float
+    float timeStep = eventData[P_TIMESTEP].GetFloat();
+
+    // Change the number of models or the settings. Each change recreates the scene
+    Input* input = GetSubsystem<Input>();
+    bool recreate = false;
+    if (input->GetKeyPress(KEY_PAGEUP) && numModels_ < MAX_MODELS)
+    {
+        numModels_ *= 2;
+        recreate = true;
+    }
+    if (input->GetKeyPress(KEY_PAGEDOWN) && numModels_ > MIN_MODELS)
+    {
+        numModels_ /= 2;
+        recreate = true;
+    }
+    if (input->GetKeyPress('P'))
+    {
+        usePoseBuffer_ = !usePoseBuffer_;
+        recreate = true;
+    }
+    if (input->GetKeyPress('C'))
+    {
+        compressAnimation_ = !compressAnimation_;
+        recreate = true;
+    }
+    if (input->GetKeyPress('X'))
+    {
+        usePoseCache_ = !usePoseCache_;
+        recreate = true;
+    }
+
+    if (recreate)
+    {
+        CreateScene();
+        UpdateStatus();
+    }
+
+    // Move the camera, scale movement with time step
+    MoveCamera(timeStep);
+}
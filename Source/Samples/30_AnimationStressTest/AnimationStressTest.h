@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Sample.h"
+
+namespace Urho3D
+{
+
+class Node;
+class PoseCache;
+class Scene;
+class Text;
+
+}
+
+/// Animation stress test example.
+/// This sample demonstrates:
+///     - Populating a scene with thousands of skeletally animated models, as in the SkeletalAnimation sample
+///     - Evaluating the skeletons in pose buffers, so that animation and skinning run in the worker threads without bone nodes
+///     - Compressing an animation and comparing its memory use
+///     - Sharing the poses of models that play the same animation through a pose cache
+///     - Using the profiler to measure the time taken to animate the scene
+class AnimationStressTest : public Sample
+{
+    OBJECT(AnimationStressTest);
+
+public:
+    /// Construct.
+    AnimationStressTest(Context* context);
+
+    /// Setup after engine initialization and before running the main loop.
+    virtual void Start();
+
+private:
+    /// Construct the scene content.
+    void CreateScene();
+    /// Construct an instruction text to the UI.
+    void CreateInstructions();
+    /// Update the status text.
+    void UpdateStatus();
+    /// Set up a viewport for displaying the scene.
+    void SetupViewport();
+    /// Subscribe to application-wide logic update events.
+    void SubscribeToEvents();
+    /// Read input and moves the camera.
+    void MoveCamera(float timeStep);
+    /// Handle the logic update event.
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+
+    /// Scene.
+    SharedPtr<Scene> scene_;
+    /// Camera scene node.
+    SharedPtr<Node> cameraNode_;
+    /// Status text.
+    SharedPtr<Text> statusText_;
+    /// Pose cache shared by the animated models.
+    SharedPtr<PoseCache> poseCache_;
+    /// Camera yaw angle.
+    float yaw_;
+    /// Camera pitch angle.
+    float pitch_;
+    /// Number of animated models.
+    unsigned numModels_;
+    /// Pose buffer mode flag.
+    bool usePoseBuffer_;
+    /// Animation compression flag.
+    bool compressAnimation_;
+    /// Pose cache flag.
+    bool usePoseCache_;
+};
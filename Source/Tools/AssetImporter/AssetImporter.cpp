@@ -115,6 +115,8 @@ bool emissiveAO_ = false;
 bool noOverwriteMaterial_ = false;
 bool noOverwriteTexture_ = false;
 bool noOverwriteNewerTexture_ = false;
+bool compressAnimations_ = false;
+float animationError_ = 0.001f;
 Vector<String> nonSkinningBoneIncludes_;
 Vector<String> nonSkinningBoneExcludes_;
 
@@ -233,6 +235,11 @@ void Run(const Vector<String>& arguments)
             "-cm         Check and do not overwrite if material exists\n"
             "-ct         Check and do not overwrite if texture exists\n"
             "-ctn        Check and do not overwrite if texture has newer timestamp\n"
+            "-ac         Compress animations. Removes keyframes that can be interpolated,\n"
+            "            quantizes the keyframe data and strips channels that stay at the\n"
+            "            bone's base transform\n"
+            "-ae <error> Animation compression error tolerance for positions and scales,\n"
+            "            and in radians for rotations. Default 0.001\n"
         );
     }
     
@@ -359,6 +366,13 @@ void Run(const Vector<String>& arguments)
                 noOverwriteTexture_ = true;
             else if (argument == "ctn")
                 noOverwriteNewerTexture_ = true;
+            else if (argument == "ac")
+                compressAnimations_ = true;
+            else if (argument == "ae" && !value.Empty())
+            {
+                animationError_ = Max(ToFloat(value), 0.0f);
+                ++i;
+            }
         }
     }
     
@@ -1124,10 +1138,44 @@ void BuildAndSaveAnimations(OutModel* model)
                 track.keyFrames_.Push(kf);
             }
             
+            // When compressing, strip channels that stay at the bone's base transform, as the bones are reset to it
+            // before applying animations. The root bone's keyframes have been transformed, so leave it as is
+            if (compressAnimations_ && !isRootBone && track.keyFrames_.Size())
+            {
+                aiVector3D basePos, baseScale;
+                aiQuaternion baseRot;
+                boneNode->mTransformation.Decompose(baseScale, baseRot, basePos);
+                Vector3 basePosition = ToVector3(basePos);
+                Quaternion baseRotation = ToQuaternion(baseRot);
+                Vector3 baseScaleVec = ToVector3(baseScale);
+                float minRotationDot = cosf(animationError_ * 0.5f);
+                
+                unsigned char stripMask = track.channelMask_;
+                for (unsigned k = 0; k < track.keyFrames_.Size(); ++k)
+                {
+                    const AnimationKeyFrame& kf = track.keyFrames_[k];
+                    if ((kf.position_ - basePosition).Length() > animationError_)
+                        stripMask &= ~CHANNEL_POSITION;
+                    if (Abs(kf.rotation_.DotProduct(baseRotation)) < minRotationDot)
+                        stripMask &= ~CHANNEL_ROTATION;
+                    if ((kf.scale_ - baseScaleVec).Length() > animationError_)
+                        stripMask &= ~CHANNEL_SCALE;
+                }
+                
+                track.channelMask_ &= ~stripMask;
+                if (!track.channelMask_)
+                {
+                    PrintLine("Stripping animation track " + channelName + " that stays at the base transform");
+                    continue;
+                }
+            }
+            
             tracks.Push(track);
         }
         
         outAnim->SetTracks(tracks);
+        if (compressAnimations_)
+            outAnim->Compress(animationError_, animationError_, animationError_);
         
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
@@ -0,0 +1,709 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "BenchmarkAgent.h"
+#include "Context.h"
+#include "CoreEvents.h"
+#include "Engine.h"
+#include "File.h"
+#include "HashSet.h"
+#include "List.h"
+#include "Log.h"
+#include "MathBenchmark.h"
+#include "Mutex.h"
+#include "Node.h"
+#include "ProcessUtils.h"
+#include "Profiler.h"
+#include "SceneBenchmark.h"
+#include "StaticModel.h"
+#include "StringUtils.h"
+#include "Thread.h"
+#include "Timer.h"
+#include "WorkQueue.h"
+
+#include <cstdio>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "DebugNew.h"
+
+using namespace Urho3D;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void RunEvents(unsigned numThreads, unsigned numReceivers, unsigned numFrames);
+void RunScenes(const Vector<String>& scenarios, unsigned numThreads, unsigned numFrames, float timeStep, bool packedCulling,
+    bool flatTransforms, bool parallelUpdate, bool pooling, bool poseBuffer, bool compressAnimation, bool poseCache,
+    bool cpuSkinning, const String& outputName);
+
+/// Reference implementation of the previous mutex-guarded, priority-ordered work queue for throughput comparison.
+class LegacyWorkQueue
+{
+public:
+    /// Construct and create worker threads.
+    LegacyWorkQueue(unsigned numThreads) :
+        shutDown_(false)
+    {
+        for (unsigned i = 0; i < numThreads; ++i)
+        {
+            threads_.Push(new LegacyWorkerThread(this, i + 1));
+            threads_.Back()->Run();
+        }
+    }
+    
+    /// Stop and destroy worker threads.
+    ~LegacyWorkQueue()
+    {
+        shutDown_ = true;
+        for (unsigned i = 0; i < threads_.Size(); ++i)
+        {
+            threads_[i]->Stop();
+            delete threads_[i];
+        }
+    }
+    
+    /// Get a work item from the pool.
+    SharedPtr<WorkItem> GetFreeItem()
+    {
+        if (poolItems_.Size() > 0)
+        {
+            SharedPtr<WorkItem> item = poolItems_.Front();
+            poolItems_.PopFront();
+            return item;
+        }
+        else
+            return SharedPtr<WorkItem>(new WorkItem());
+    }
+    
+    /// Add a work item with a priority-ordered insert.
+    void AddWorkItem(SharedPtr<WorkItem> item)
+    {
+        workItems_.Push(item);
+        item->completed_ = false;
+        
+        MutexLock lock(queueMutex_);
+        if (queue_.Empty())
+            queue_.Push(item);
+        else
+        {
+            for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+            {
+                if ((*i)->priority_ <= item->priority_)
+                {
+                    queue_.Insert(i, item);
+                    break;
+                }
+            }
+        }
+    }
+    
+    /// Complete all work with at least the specified priority, also executing items in the main thread.
+    void Complete(unsigned priority)
+    {
+        while (!queue_.Empty())
+        {
+            queueMutex_.Acquire();
+            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+            {
+                WorkItem* item = queue_.Front();
+                queue_.PopFront();
+                queueMutex_.Release();
+                item->workFunction_(item, 0);
+                item->completed_ = true;
+            }
+            else
+            {
+                queueMutex_.Release();
+                break;
+            }
+        }
+        
+        while (!IsCompleted(priority))
+        {
+        }
+        
+        for (List<SharedPtr<WorkItem> >::Iterator i = workItems_.Begin(); i != workItems_.End();)
+        {
+            if ((*i)->completed_ && (*i)->priority_ >= priority)
+            {
+                poolItems_.Push(*i);
+                i = workItems_.Erase(i);
+            }
+            else
+                ++i;
+        }
+    }
+    
+    /// Return whether all work with at least the specified priority is finished.
+    bool IsCompleted(unsigned priority) const
+    {
+        for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
+        {
+            if ((*i)->priority_ >= priority && !(*i)->completed_)
+                return false;
+        }
+        
+        return true;
+    }
+    
+    /// Process items until shut down. Called by the worker threads.
+    void ProcessItems(unsigned threadIndex)
+    {
+        while (!shutDown_)
+        {
+            queueMutex_.Acquire();
+            if (!queue_.Empty())
+            {
+                WorkItem* item = queue_.Front();
+                queue_.PopFront();
+                queueMutex_.Release();
+                item->workFunction_(item, threadIndex);
+                item->completed_ = true;
+            }
+            else
+            {
+                queueMutex_.Release();
+                Time::Sleep(0);
+            }
+        }
+    }
+    
+private:
+    /// Worker thread of the reference work queue.
+    class LegacyWorkerThread : public Thread
+    {
+    public:
+        /// Construct.
+        LegacyWorkerThread(LegacyWorkQueue* owner, unsigned index) :
+            owner_(owner),
+            index_(index)
+        {
+        }
+        
+        /// Process work items until stopped.
+        virtual void ThreadFunction() { owner_->ProcessItems(index_); }
+        
+    private:
+        /// Work queue.
+        LegacyWorkQueue* owner_;
+        /// Thread index.
+        unsigned index_;
+    };
+    
+    /// Worker threads.
+    PODVector<LegacyWorkerThread*> threads_;
+    /// Work item pool.
+    List<SharedPtr<WorkItem> > poolItems_;
+    /// Work item collection. Accessed only by the main thread.
+    List<SharedPtr<WorkItem> > workItems_;
+    /// Prioritized queue for worker threads.
+    List<WorkItem*> queue_;
+    /// Queue mutex.
+    Mutex queueMutex_;
+    /// Shutting down flag.
+    volatile bool shutDown_;
+};
+
+/// Work function that does nothing.
+void EmptyWork(const WorkItem* item, unsigned threadIndex)
+{
+}
+
+/// Work function that does a small fixed amount of arithmetic.
+void TinyWork(const WorkItem* item, unsigned threadIndex)
+{
+    float* data = reinterpret_cast<float*>(item->start_);
+    float sum = 0.0f;
+    for (unsigned i = 0; i < 64; ++i)
+        sum += data[i] * data[i];
+    *reinterpret_cast<float*>(item->aux_) = sum;
+}
+
+/// Run work items through a work queue and return throughput in items per second.
+template <class T> float BenchmarkWorkQueue(T* queue, void (*workFunction)(const WorkItem*, unsigned), float* data, unsigned numItems,
+    unsigned numFrames)
+{
+    HiresTimer timer;
+    
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = workFunction;
+            item->start_ = data;
+            item->aux_ = data + 64 + i;
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    
+    return (float)numItems * numFrames * 1000000.0f / (float)Max((int)timer.GetUSec(false), 1);
+}
+
+/// Run work descriptors through the work queue in batches and return throughput in items per second.
+float BenchmarkWorkBatch(WorkQueue* queue, void (*workFunction)(const WorkItem*, unsigned), float* data, unsigned numItems,
+    unsigned numFrames)
+{
+    PODVector<WorkDescriptor> descriptors(numItems);
+    HiresTimer timer;
+    
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            WorkDescriptor& descriptor = descriptors[i];
+            descriptor.workFunction_ = workFunction;
+            descriptor.start_ = data;
+            descriptor.end_ = 0;
+            descriptor.aux_ = data + 64 + i;
+        }
+        queue->CompleteBatch(queue->AddWorkBatch(&descriptors[0], numItems));
+    }
+    
+    return (float)numItems * numFrames * 1000000.0f / (float)Max((int)timer.GetUSec(false), 1);
+}
+
+/// Event receiver for the event send benchmark.
+class EventReceiver : public Object
+{
+    OBJECT(EventReceiver);
+    
+public:
+    /// Construct.
+    EventReceiver(Context* context) :
+        Object(context),
+        time_(0.0f),
+        count_(0)
+    {
+    }
+    
+    /// Handle an update event with typed parameters.
+    void HandleUpdate(StringHash eventType, UpdateEvent& eventData)
+    {
+        time_ += eventData.timeStep_;
+    }
+    
+    /// Count an update event with typed parameters.
+    void HandleCountUpdate(StringHash eventType, UpdateEvent& eventData)
+    {
+        ++count_;
+    }
+    
+    /// Handle an update event with VariantMap parameters.
+    void HandleUpdateLegacy(StringHash eventType, VariantMap& eventData)
+    {
+        using namespace Update;
+        
+        time_ += eventData[P_TIMESTEP].GetFloat();
+    }
+    
+    /// Accumulated time.
+    float time_;
+    /// Counted events.
+    unsigned count_;
+};
+
+/// Send update events to subscribed receivers and return throughput in handler calls per second.
+float BenchmarkEvents(Object* sender, unsigned numReceivers, unsigned numFrames, bool typedEvents)
+{
+    HiresTimer timer;
+    
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        if (typedEvents)
+        {
+            UpdateEvent eventData(E_UPDATE, 1.0f / 60.0f);
+            sender->SendEvent(eventData);
+        }
+        else
+        {
+            using namespace Update;
+            
+            VariantMap& eventData = sender->GetEventDataMap();
+            eventData[P_TIMESTEP] = 1.0f / 60.0f;
+            sender->SendEvent(E_UPDATE, eventData);
+        }
+    }
+    
+    return (float)numReceivers * numFrames * 1000000.0f / (float)Max((int)timer.GetUSec(false), 1);
+}
+
+/// Send update events to receivers stored in a hash set, as the previous event routing did, and return throughput in handler calls
+/// per second.
+float BenchmarkLegacyEvents(Object* sender, const HashSet<Object*>& receivers, unsigned numFrames)
+{
+    using namespace Update;
+    
+    WeakPtr<Object> self(sender);
+    HiresTimer timer;
+    
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        VariantMap& eventData = sender->GetEventDataMap();
+        eventData[P_TIMESTEP] = 1.0f / 60.0f;
+        HashSet<Object*> processed;
+        
+        for (HashSet<Object*>::ConstIterator i = receivers.Begin(); i != receivers.End();)
+        {
+            HashSet<Object*>::ConstIterator current = i++;
+            Object* receiver = *current;
+            Object* next = 0;
+            if (i != receivers.End())
+                next = *i;
+            
+            unsigned oldSize = receivers.Size();
+            receiver->OnEvent(sender, E_UPDATE, eventData);
+            
+            if (self.Expired())
+                return 0.0f;
+            
+            if (receivers.Size() != oldSize)
+                i = receivers.Find(next);
+            
+            processed.Insert(receiver);
+        }
+    }
+    
+    return (float)receivers.Size() * numFrames * 1000000.0f / (float)Max((int)timer.GetUSec(false), 1);
+}
+
+/// Work function that posts a post-update event from each object in the range.
+void PostEventWork(const WorkItem* item, unsigned threadIndex)
+{
+    for (SharedPtr<EventReceiver>* i = reinterpret_cast<SharedPtr<EventReceiver>*>(item->start_); i <
+        reinterpret_cast<SharedPtr<EventReceiver>*>(item->end_); ++i)
+        (*i)->PostEvent(new UpdateEvent(E_POSTUPDATE, 1.0f / 60.0f));
+}
+
+/// Post events from the worker threads, send them from the main thread and return throughput in events per second.
+float BenchmarkPostedEvents(Context* context, Vector<SharedPtr<EventReceiver> >& senders, unsigned numFrames)
+{
+    WorkQueue* queue = context->GetSubsystem<WorkQueue>();
+    SharedPtr<EventReceiver> counter(new EventReceiver(context));
+    counter->SubscribeToEvent(E_POSTUPDATE, CreateTypedEventHandler<EventReceiver>(counter.Get(),
+        &EventReceiver::HandleCountUpdate));
+    HiresTimer timer;
+    
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        queue->ParallelFor(PostEventWork, senders.Begin().ptr_, senders.End().ptr_, 0);
+        context->SendPostedEvents();
+    }
+    
+    if (counter->count_ != senders.Size() * numFrames)
+        ErrorExit("Posted event count mismatch: sent " + String(counter->count_) + ", expected " + String(senders.Size() * numFrames));
+    
+    return (float)senders.Size() * numFrames * 1000000.0f / (float)Max((int)timer.GetUSec(false), 1);
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numThreads = GetNumPhysicalCPUs() - 1;
+    unsigned numItems = 1000;
+    unsigned numFrames = 0;
+    float timeStep = 1.0f / 60.0f;
+    Vector<String> scenarios;
+    String outputName;
+    bool events = false;
+    bool math = false;
+    bool packedCulling = false;
+    bool flatTransforms = false;
+    bool parallelUpdate = false;
+    bool pooling = false;
+    bool poseBuffer = false;
+    bool compressAnimation = false;
+    bool poseCache = false;
+    bool cpuSkinning = false;
+    
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+        
+        if (argument == "-threads" && !value.Empty())
+        {
+            numThreads = ToUInt(value);
+            ++i;
+        }
+        else if (argument == "-items" && !value.Empty())
+        {
+            numItems = Max((int)ToUInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-frames" && !value.Empty())
+        {
+            numFrames = Max((int)ToUInt(value), 1);
+            ++i;
+        }
+        else if (argument == "-events")
+            events = true;
+        else if (argument == "-math")
+            math = true;
+        else if (argument == "-scene" && !value.Empty())
+        {
+            scenarios = value.ToLower() == "all" ? String("objects,movingobjects,queries,cachedqueries,iteration,transforms,agents,"
+                "spawning,xmlspawning,physics,collisions,legacycollisions,crowd,replication").Split(',') : value.ToLower().Split(',');
+            ++i;
+        }
+        else if (argument == "-packedculling")
+            packedCulling = true;
+        else if (argument == "-flattransforms")
+            flatTransforms = true;
+        else if (argument == "-parallelupdate")
+            parallelUpdate = true;
+        else if (argument == "-pooling")
+            pooling = true;
+        else if (argument == "-posebuffer")
+            poseBuffer = true;
+        else if (argument == "-compressanimation")
+            compressAnimation = true;
+        else if (argument == "-posecache")
+            poseCache = true;
+        else if (argument == "-cpuskinning")
+            cpuSkinning = true;
+        else if (argument == "-timestep" && !value.Empty())
+        {
+            timeStep = Max(ToFloat(value), 0.001f);
+            ++i;
+        }
+        else if (argument == "-output" && !value.Empty())
+        {
+            outputName = value;
+            ++i;
+        }
+        else
+        {
+            ErrorExit(
+                "Usage: Benchmark [options]\n\n"
+                "Without -scene, measures WorkQueue throughput. With -events, measures event send throughput with typed and\n"
+                "VariantMap parameters. With -math, verifies the Math library operations against scalar reference code and\n"
+                "measures their throughput. With -scene, runs the engine headless with deterministic scenes and reports the frame\n"
+                "and per-subsystem timings as JSON.\n\n"
+                "Options:\n"
+                "-threads <number>    Worker thread count, default is physical CPU count - 1\n"
+                "-items <number>      Work items or event receivers per frame, default 1000\n"
+                "-frames <number>     Frames to run, default 1000 for WorkQueue and events, 300 for scenes\n"
+                "-events              Run the event send benchmark\n"
+                "-math                Run the Math library verification and benchmark\n"
+                "-scene <names>       Comma-separated scenarios: objects, movingobjects, queries, cachedqueries,\n"
+                "                     iteration, transforms, agents, spawning, xmlspawning, physics, collisions,\n"
+                "                     legacycollisions, crowd, replication or all\n"
+                "-packedculling       Cull the scenes with the octree's packed bounding box tests\n"
+                "-flattransforms      Update the scenes' transforms in a flat pass after the scene update\n"
+                "-parallelupdate      Update the scenes' logic components in the worker threads\n"
+                "-pooling             Allocate the nodes and the static model and agent components from pools\n"
+                "-posebuffer          Evaluate the animated models' skeletons in pose buffers instead of bone nodes\n"
+                "-compressanimation   Compress the crowd scenario's animation before playing it\n"
+                "-posecache           Share the crowd scenario's poses through a pose cache, implies -posebuffer\n"
+                "-cpuskinning         Skin the crowd scenario's models on the CPU and raycast against their triangles\n"
+                "-timestep <seconds>  Fixed scene timestep, default 1/60\n"
+                "-output <file>       Write the scene results to a file instead of the standard output\n"
+            );
+        }
+    }
+    
+    if (!scenarios.Empty())
+    {
+        RunScenes(scenarios, numThreads, numFrames ? numFrames : 300, timeStep, packedCulling, flatTransforms, parallelUpdate,
+            pooling, poseBuffer || poseCache, compressAnimation, poseCache, cpuSkinning, outputName);
+        return;
+    }
+    
+    if (!numFrames)
+        numFrames = 1000;
+    
+    if (events)
+    {
+        RunEvents(numThreads, numItems, numFrames);
+        return;
+    }
+    
+    if (math)
+    {
+        RunMath(numItems, numFrames);
+        return;
+    }
+    
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    WorkQueue* queue = context->GetSubsystem<WorkQueue>();
+    queue->CreateThreads(numThreads);
+    
+    PODVector<float> data(64 + numItems);
+    for (unsigned i = 0; i < data.Size(); ++i)
+        data[i] = (float)i;
+    
+    PrintLine("WorkQueue throughput with " + String(numThreads) + " worker threads, " + String(numItems) + " items per frame, " +
+        String(numFrames) + " frames");
+    PrintLine("Empty items: " + String(BenchmarkWorkQueue(queue, EmptyWork, &data[0], numItems, numFrames)) + " items/s");
+    PrintLine("Tiny items: " + String(BenchmarkWorkQueue(queue, TinyWork, &data[0], numItems, numFrames)) + " items/s");
+    PrintLine("Empty items (batch): " + String(BenchmarkWorkBatch(queue, EmptyWork, &data[0], numItems, numFrames)) + " items/s");
+    PrintLine("Tiny items (batch): " + String(BenchmarkWorkBatch(queue, TinyWork, &data[0], numItems, numFrames)) + " items/s");
+    
+    {
+        LegacyWorkQueue legacyQueue(numThreads);
+        PrintLine("Empty items (mutex queue): " + String(BenchmarkWorkQueue(&legacyQueue, EmptyWork, &data[0], numItems,
+            numFrames)) + " items/s");
+        PrintLine("Tiny items (mutex queue): " + String(BenchmarkWorkQueue(&legacyQueue, TinyWork, &data[0], numItems,
+            numFrames)) + " items/s");
+    }
+}
+
+void RunEvents(unsigned numThreads, unsigned numReceivers, unsigned numFrames)
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+    SharedPtr<Object> sender(new EventReceiver(context));
+    Vector<SharedPtr<EventReceiver> > receivers;
+    
+    PrintLine("Event send throughput with " + String(numReceivers) + " receivers, " + String(numFrames) + " frames");
+    
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        receivers.Push(SharedPtr<EventReceiver>(new EventReceiver(context)));
+        receivers.Back()->SubscribeToEvent(E_UPDATE, CreateTypedEventHandler<EventReceiver>(receivers.Back().Get(),
+            &EventReceiver::HandleUpdate));
+    }
+    PrintLine("Typed handlers, typed send: " + String(BenchmarkEvents(sender, numReceivers, numFrames, true)) + " calls/s");
+    PrintLine("Typed handlers, VariantMap send: " + String(BenchmarkEvents(sender, numReceivers, numFrames, false)) + " calls/s");
+    
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        receivers[i]->SubscribeToEvent(E_UPDATE, new EventHandlerImpl<EventReceiver>(receivers[i],
+            &EventReceiver::HandleUpdateLegacy));
+    }
+    PrintLine("VariantMap handlers, typed send: " + String(BenchmarkEvents(sender, numReceivers, numFrames, true)) + " calls/s");
+    PrintLine("VariantMap handlers, VariantMap send: " + String(BenchmarkEvents(sender, numReceivers, numFrames, false)) +
+        " calls/s");
+    
+    // Subscribe to the specific sender, like logic components to the scene update, and compare to hash set routing
+    HiresTimer timer;
+    HashSet<Object*> receiverSet;
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        receivers[i]->UnsubscribeFromEvent(E_UPDATE);
+        receivers[i]->SubscribeToEvent(sender, E_UPDATE, new EventHandlerImpl<EventReceiver>(receivers[i],
+            &EventReceiver::HandleUpdateLegacy));
+        receiverSet.Insert(receivers[i]);
+    }
+    PrintLine("Unsubscribe and subscribe: " + String(timer.GetUSec(false) / 1000.0f) + " ms");
+    PrintLine("Specific sender, VariantMap send: " + String(BenchmarkEvents(sender, numReceivers, numFrames, false)) + " calls/s");
+    PrintLine("Specific sender, hash set routing: " + String(BenchmarkLegacyEvents(sender, receiverSet, numFrames)) + " calls/s");
+    PrintLine("Posted from " + String(numThreads) + " worker threads: " + String(BenchmarkPostedEvents(context, receivers,
+        numFrames)) + " events/s");
+}
+
+void RunScenes(const Vector<String>& scenarios, unsigned numThreads, unsigned numFrames, float timeStep, bool packedCulling,
+    bool flatTransforms, bool parallelUpdate, bool pooling, bool poseBuffer, bool compressAnimation, bool poseCache,
+    bool cpuSkinning, const String& outputName)
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+    
+    VariantMap engineParameters;
+    engineParameters["Headless"] = true;
+    engineParameters["WorkerThreads"] = false;
+    engineParameters["LogName"] = "Benchmark.log";
+    engineParameters["LogQuiet"] = true;
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Could not initialize the engine");
+    
+    // Create the requested amount of worker threads instead of the engine default
+    if (numThreads)
+        context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+    
+    // Pooling has to be enabled before any objects of the types are created
+    context->RegisterFactory<BenchmarkAgent>();
+    if (pooling && (!context->SetObjectPooling<Node>(true) || !context->SetObjectPooling<StaticModel>(true) ||
+        !context->SetObjectPooling<BenchmarkAgent>(true)))
+        ErrorExit("Could not enable object pooling");
+    
+    char line[512];
+    sprintf(line, "{\"threads\":%u,\"frames\":%u,\"timeStep\":%.6f,\"profiling\":%s,\"packedCulling\":%s,\"flatTransforms\":%s,"
+        "\"parallelUpdate\":%s,\"pooling\":%s,\"poseBuffer\":%s,\"compressAnimation\":%s,\"poseCache\":%s,\"cpuSkinning\":%s,\n"
+        "\"scenarios\":[", numThreads, numFrames, timeStep,
+        context->GetSubsystem<Profiler>() ? "true" : "false", packedCulling ? "true" : "false", flatTransforms ? "true" : "false",
+        parallelUpdate ? "true" : "false", pooling ? "true" : "false", poseBuffer ? "true" : "false",
+        compressAnimation ? "true" : "false", poseCache ? "true" : "false", cpuSkinning ? "true" : "false");
+    String output(line);
+    unsigned numSaved = 0;
+    
+    for (unsigned i = 0; i < scenarios.Size(); ++i)
+    {
+        // Create each scenario in a clean engine state, and destroy it before the next
+        SharedPtr<SceneBenchmark> benchmark(new SceneBenchmark(context));
+        benchmark->SetPackedCulling(packedCulling);
+        benchmark->SetFlatTransforms(flatTransforms);
+        benchmark->SetParallelUpdate(parallelUpdate);
+        benchmark->SetPoseBuffer(poseBuffer);
+        benchmark->SetCompressAnimation(compressAnimation);
+        benchmark->SetPoseCache(poseCache);
+        benchmark->SetCPUSkinning(cpuSkinning);
+        if (!benchmark->CreateScenario(scenarios[i].Trimmed()))
+        {
+            PrintLine("Failed to create scenario " + scenarios[i], true);
+            continue;
+        }
+        
+        benchmark->Run(numFrames, timeStep);
+        if (numSaved++)
+            output += ",";
+        output += "\n";
+        benchmark->SaveJSON(output);
+    }
+    
+    output += "\n]}\n";
+    
+    if (!outputName.Empty())
+    {
+        File outputFile(context, outputName, FILE_WRITE);
+        if (!outputFile.IsOpen() || outputFile.Write(output.CString(), output.Length()) != output.Length())
+            ErrorExit("Could not write output file " + outputName);
+    }
+    else
+        PrintUnicode(output);
+    
+    // Fail when any of the scenarios could not be created, so that automated runs notice it
+    if (numSaved < scenarios.Size())
+        ErrorExit();
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "BenchmarkAgent.h"
+#include "Node.h"
+
+#include "DebugNew.h"
+
+static const float MOVE_SPEED = 2.0f;
+static const float WANDER_SPEED = 90.0f;
+static const float AVOID_DISTANCE = 5.0f;
+static const float AREA_SIZE = 50.0f;
+
+BenchmarkAgent::BenchmarkAgent(Context* context) :
+    LogicComponent(context),
+    obstacles_(0),
+    phase_(0.0f),
+    time_(0.0f)
+{
+    SetUpdateEventMask(USE_UPDATE);
+}
+
+void BenchmarkAgent::SetParallel(bool enable)
+{
+    SetUpdateEventMask(enable ? USE_UPDATE | USE_PARALLELUPDATE : USE_UPDATE);
+}
+
+void BenchmarkAgent::Update(float timeStep)
+{
+    time_ += timeStep;
+    
+    Vector3 position = node_->GetPosition();
+    Vector3 direction = node_->GetDirection();
+    
+    // Wander, steer away from the nearby obstacles, and head back towards the center when outside the area. The random
+    // number generator is not used, as it is not thread-safe
+    float turn = Sin(time_ * WANDER_SPEED + phase_) * 45.0f;
+    Vector3 steer(Quaternion(turn * timeStep, Vector3::UP) * direction);
+    
+    if (obstacles_)
+    {
+        for (unsigned i = 0; i < obstacles_->Size(); ++i)
+        {
+            Vector3 offset = position - (*obstacles_)[i];
+            offset.y_ = 0.0f;
+            float distance = offset.Length();
+            if (distance < AVOID_DISTANCE && distance > M_EPSILON)
+                steer += offset * ((AVOID_DISTANCE - distance) / (AVOID_DISTANCE * distance));
+        }
+    }
+    
+    if (Abs(position.x_) > AREA_SIZE || Abs(position.z_) > AREA_SIZE)
+        steer -= Vector3(position.x_, 0.0f, position.z_).Normalized();
+    
+    steer.y_ = 0.0f;
+    if (steer.LengthSquared() > M_EPSILON)
+        node_->SetDirection(steer.Normalized());
+    node_->Translate(Vector3::FORWARD * MOVE_SPEED * timeStep);
+}
@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "LogicComponent.h"
+
+using namespace Urho3D;
+
+/// Logic component for the agents scenario: wanders inside an area and steers away from the obstacles. Only touches its own node, so it can opt into the parallel update.
+class BenchmarkAgent : public LogicComponent
+{
+    OBJECT(BenchmarkAgent);
+    
+public:
+    /// Construct.
+    BenchmarkAgent(Context* context);
+    
+    /// Set whether to update in the worker threads.
+    void SetParallel(bool enable);
+    /// Set the obstacle positions to steer away from. The vector must not change while the agents update.
+    void SetObstacles(const PODVector<Vector3>* obstacles) { obstacles_ = obstacles; }
+    /// Set the wander phase, so that the agents do not move in unison.
+    void SetPhase(float phase) { phase_ = phase; }
+    /// Handle scene update. Called by LogicComponent base class.
+    virtual void Update(float timeStep);
+    
+private:
+    /// Obstacle positions.
+    const PODVector<Vector3>* obstacles_;
+    /// Wander phase.
+    float phase_;
+    /// Time since the start.
+    float time_;
+};
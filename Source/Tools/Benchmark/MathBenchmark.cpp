@@ -0,0 +1,523 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Context.h"
+#include "Frustum.h"
+#include "GraphicsDefs.h"
+#include "MathBenchmark.h"
+#include "Model.h"
+#include "ProcessUtils.h"
+#include "Skinning.h"
+#include "Timer.h"
+
+#include <cstdio>
+
+#include "DebugNew.h"
+
+using namespace Urho3D;
+
+/// Maximum relative difference allowed between the engine and the reference results.
+static const float MATH_TOLERANCE = 0.00001f;
+/// Vertex size for the skinning and morph tests: position, normal, four blend weights and four blend indices.
+static const unsigned SKIN_VERTEX_SIZE = 44;
+/// Number of bones for the skinning test.
+static const unsigned SKIN_BONES = 32;
+/// Morph data size per vertex: index, position and normal deltas.
+static const unsigned MORPH_VERTEX_SIZE = sizeof(unsigned) + 6 * sizeof(float);
+
+/// Reference 3x4 matrix multiply.
+static Matrix3x4 ReferenceMultiply(const Matrix3x4& lhs, const Matrix3x4& rhs)
+{
+    return Matrix3x4(
+        lhs.m00_ * rhs.m00_ + lhs.m01_ * rhs.m10_ + lhs.m02_ * rhs.m20_,
+        lhs.m00_ * rhs.m01_ + lhs.m01_ * rhs.m11_ + lhs.m02_ * rhs.m21_,
+        lhs.m00_ * rhs.m02_ + lhs.m01_ * rhs.m12_ + lhs.m02_ * rhs.m22_,
+        lhs.m00_ * rhs.m03_ + lhs.m01_ * rhs.m13_ + lhs.m02_ * rhs.m23_ + lhs.m03_,
+        lhs.m10_ * rhs.m00_ + lhs.m11_ * rhs.m10_ + lhs.m12_ * rhs.m20_,
+        lhs.m10_ * rhs.m01_ + lhs.m11_ * rhs.m11_ + lhs.m12_ * rhs.m21_,
+        lhs.m10_ * rhs.m02_ + lhs.m11_ * rhs.m12_ + lhs.m12_ * rhs.m22_,
+        lhs.m10_ * rhs.m03_ + lhs.m11_ * rhs.m13_ + lhs.m12_ * rhs.m23_ + lhs.m13_,
+        lhs.m20_ * rhs.m00_ + lhs.m21_ * rhs.m10_ + lhs.m22_ * rhs.m20_,
+        lhs.m20_ * rhs.m01_ + lhs.m21_ * rhs.m11_ + lhs.m22_ * rhs.m21_,
+        lhs.m20_ * rhs.m02_ + lhs.m21_ * rhs.m12_ + lhs.m22_ * rhs.m22_,
+        lhs.m20_ * rhs.m03_ + lhs.m21_ * rhs.m13_ + lhs.m22_ * rhs.m23_ + lhs.m23_
+    );
+}
+
+/// Reference 4x4 matrix multiply.
+static Matrix4 ReferenceMultiply(const Matrix4& lhs, const Matrix4& rhs)
+{
+    const float* a = lhs.Data();
+    const float* b = rhs.Data();
+    float result[16];
+    
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        for (unsigned j = 0; j < 4; ++j)
+            result[i * 4 + j] = a[i * 4] * b[j] + a[i * 4 + 1] * b[4 + j] + a[i * 4 + 2] * b[8 + j] + a[i * 4 + 3] * b[12 + j];
+    }
+    
+    return Matrix4(result);
+}
+
+/// Reference quaternion multiply.
+static Quaternion ReferenceMultiply(const Quaternion& lhs, const Quaternion& rhs)
+{
+    return Quaternion(
+        lhs.w_ * rhs.w_ - lhs.x_ * rhs.x_ - lhs.y_ * rhs.y_ - lhs.z_ * rhs.z_,
+        lhs.w_ * rhs.x_ + lhs.x_ * rhs.w_ + lhs.y_ * rhs.z_ - lhs.z_ * rhs.y_,
+        lhs.w_ * rhs.y_ + lhs.y_ * rhs.w_ + lhs.z_ * rhs.x_ - lhs.x_ * rhs.z_,
+        lhs.w_ * rhs.z_ + lhs.z_ * rhs.w_ + lhs.x_ * rhs.y_ - lhs.y_ * rhs.x_
+    );
+}
+
+/// Reference quaternion normalize.
+static Quaternion ReferenceNormalized(const Quaternion& quat)
+{
+    float lenSquared = quat.w_ * quat.w_ + quat.x_ * quat.x_ + quat.y_ * quat.y_ + quat.z_ * quat.z_;
+    if (Equals(lenSquared, 1.0f) || lenSquared <= 0.0f)
+        return quat;
+    
+    float invLen = 1.0f / sqrtf(lenSquared);
+    return Quaternion(quat.w_ * invLen, quat.x_ * invLen, quat.y_ * invLen, quat.z_ * invLen);
+}
+
+/// Reference quaternion spherical interpolation.
+static Quaternion ReferenceSlerp(const Quaternion& lhs, Quaternion rhs, float t)
+{
+    float cosAngle = lhs.w_ * rhs.w_ + lhs.x_ * rhs.x_ + lhs.y_ * rhs.y_ + lhs.z_ * rhs.z_;
+    if (cosAngle < 0.0f)
+    {
+        cosAngle = -cosAngle;
+        rhs = Quaternion(-rhs.w_, -rhs.x_, -rhs.y_, -rhs.z_);
+    }
+    
+    float angle = acosf(cosAngle);
+    float sinAngle = sinf(angle);
+    float t1 = 1.0f - t;
+    float t2 = t;
+    if (sinAngle > 0.001f)
+    {
+        t1 = sinf((1.0f - t) * angle) / sinAngle;
+        t2 = sinf(t * angle) / sinAngle;
+    }
+    
+    return Quaternion(lhs.w_ * t1 + rhs.w_ * t2, lhs.x_ * t1 + rhs.x_ * t2, lhs.y_ * t1 + rhs.y_ * t2, lhs.z_ * t1 + rhs.z_ * t2);
+}
+
+/// Reference bounding box transform.
+static BoundingBox ReferenceTransformed(const BoundingBox& box, const Matrix3x4& transform)
+{
+    Vector3 center((box.max_.x_ + box.min_.x_) * 0.5f, (box.max_.y_ + box.min_.y_) * 0.5f, (box.max_.z_ + box.min_.z_) * 0.5f);
+    Vector3 edge((box.max_.x_ - box.min_.x_) * 0.5f, (box.max_.y_ - box.min_.y_) * 0.5f, (box.max_.z_ - box.min_.z_) * 0.5f);
+    Vector3 newCenter(
+        transform.m00_ * center.x_ + transform.m01_ * center.y_ + transform.m02_ * center.z_ + transform.m03_,
+        transform.m10_ * center.x_ + transform.m11_ * center.y_ + transform.m12_ * center.z_ + transform.m13_,
+        transform.m20_ * center.x_ + transform.m21_ * center.y_ + transform.m22_ * center.z_ + transform.m23_
+    );
+    Vector3 newEdge(
+        fabsf(transform.m00_) * edge.x_ + fabsf(transform.m01_) * edge.y_ + fabsf(transform.m02_) * edge.z_,
+        fabsf(transform.m10_) * edge.x_ + fabsf(transform.m11_) * edge.y_ + fabsf(transform.m12_) * edge.z_,
+        fabsf(transform.m20_) * edge.x_ + fabsf(transform.m21_) * edge.y_ + fabsf(transform.m22_) * edge.z_
+    );
+    
+    return BoundingBox(newCenter - newEdge, newCenter + newEdge);
+}
+
+/// Reference test of four packed bounding boxes against a frustum.
+static unsigned ReferenceIsInsideFast4(const Frustum& frustum, const float* boxes)
+{
+    unsigned result = 0;
+    
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        Vector3 center((boxes[i] + boxes[i + 12]) * 0.5f, (boxes[i + 4] + boxes[i + 16]) * 0.5f, (boxes[i + 8] + boxes[i + 20]) * 0.5f);
+        Vector3 edge(center.x_ - boxes[i], center.y_ - boxes[i + 4], center.z_ - boxes[i + 8]);
+        bool inside = true;
+        
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            const Plane& plane = frustum.planes_[j];
+            float dist = plane.normal_.x_ * center.x_ + plane.normal_.y_ * center.y_ + plane.normal_.z_ * center.z_ + plane.d_;
+            float absDist = plane.absNormal_.x_ * edge.x_ + plane.absNormal_.y_ * edge.y_ + plane.absNormal_.z_ * edge.z_;
+            if (dist < -absDist)
+            {
+                inside = false;
+                break;
+            }
+        }
+        
+        if (inside)
+            result |= 1 << i;
+    }
+    
+    return result;
+}
+
+/// Reference CPU skinning, blending the bone matrices and then transforming the position.
+static void ReferenceSkinPositions(Vector3* dest, const unsigned char* vertexData, unsigned count, const Matrix3x4* matrices)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const float* position = (const float*)(vertexData + i * SKIN_VERTEX_SIZE);
+        const float* weights = position + 6;
+        const unsigned char* indices = (const unsigned char*)(position + 10);
+        float m[12];
+        for (unsigned k = 0; k < 12; ++k)
+            m[k] = 0.0f;
+        
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            const float* bone = matrices[indices[j]].Data();
+            for (unsigned k = 0; k < 12; ++k)
+                m[k] += bone[k] * weights[j];
+        }
+        
+        dest[i] = Vector3(
+            m[0] * position[0] + m[1] * position[1] + m[2] * position[2] + m[3],
+            m[4] * position[0] + m[5] * position[1] + m[6] * position[2] + m[7],
+            m[8] * position[0] + m[9] * position[1] + m[10] * position[2] + m[11]
+        );
+    }
+}
+
+/// Reference vertex morph of positions and normals.
+static void ReferenceApplyMorph(unsigned char* vertexData, const unsigned char* morphData, unsigned count, float weight)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float* dest = (float*)(vertexData + *((const unsigned*)morphData) * SKIN_VERTEX_SIZE);
+        const float* delta = (const float*)(morphData + sizeof(unsigned));
+        for (unsigned j = 0; j < 6; ++j)
+            dest[j] += delta[j] * weight;
+        morphData += MORPH_VERTEX_SIZE;
+    }
+}
+
+/// Return the largest relative difference between two float arrays.
+static float MaxError(const float* lhs, const float* rhs, unsigned count)
+{
+    float maxError = 0.0f;
+    
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float error = fabsf(lhs[i] - rhs[i]) / Max(Max(fabsf(lhs[i]), fabsf(rhs[i])), 1.0f);
+        // Treat NaN as a mismatch
+        if (!(error <= maxError))
+            maxError = error;
+    }
+    
+    return maxError;
+}
+
+/// Print the result of one operation and return whether it was within tolerance.
+static bool Report(const char* name, unsigned numOps, long long engineUSec, long long referenceUSec, float maxError)
+{
+    bool passed = maxError <= MATH_TOLERANCE;
+    char line[256];
+    sprintf(line, "%-22s %9.2f Mops/s, reference %9.2f Mops/s, max error %g%s", name, (float)numOps / (float)Max((int)engineUSec, 1),
+        (float)numOps / (float)Max((int)referenceUSec, 1), maxError, passed ? "" : " FAILED");
+    PrintLine(line, !passed);
+    return passed;
+}
+
+void RunMath(unsigned numItems, unsigned numFrames)
+{
+    // The Time subsystem initializes the high-resolution timer
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    SetRandomSeed(1);
+    
+    PODVector<Matrix3x4> transforms(numItems);
+    PODVector<Matrix4> projections(numItems);
+    PODVector<Quaternion> rotations(numItems);
+    PODVector<Quaternion> unnormalized(numItems);
+    PODVector<BoundingBox> boxes(numItems);
+    PODVector<float> packedBoxes(numItems * 24);
+    
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        rotations[i] = Quaternion(Random(-180.0f, 180.0f), Random(-180.0f, 180.0f), Random(-180.0f, 180.0f));
+        unnormalized[i] = Quaternion(Random(-2.0f, 2.0f), Random(-2.0f, 2.0f), Random(-2.0f, 2.0f), Random(-2.0f, 2.0f));
+        transforms[i] = Matrix3x4(Vector3(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f)),
+            rotations[i], Vector3(Random(0.1f, 2.0f), Random(0.1f, 2.0f), Random(0.1f, 2.0f)));
+        float data[16];
+        for (unsigned j = 0; j < 16; ++j)
+            data[j] = Random(-2.0f, 2.0f);
+        projections[i] = Matrix4(data);
+        Vector3 center(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f));
+        Vector3 halfSize(Random(0.1f, 5.0f), Random(0.1f, 5.0f), Random(0.1f, 5.0f));
+        boxes[i] = BoundingBox(center - halfSize, center + halfSize);
+    }
+    
+    // Pack the boxes in groups of four like the octree does
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        float* dest = &packedBoxes[(i / 4) * 24 + (i & 3)];
+        dest[0] = boxes[i].min_.x_;
+        dest[4] = boxes[i].min_.y_;
+        dest[8] = boxes[i].min_.z_;
+        dest[12] = boxes[i].max_.x_;
+        dest[16] = boxes[i].max_.y_;
+        dest[20] = boxes[i].max_.z_;
+    }
+    
+    // Skinned vertices with random positions and normalized blend weights, morphed at every other vertex
+    PODVector<Matrix3x4> skinMatrices(SKIN_BONES);
+    for (unsigned i = 0; i < SKIN_BONES; ++i)
+        skinMatrices[i] = transforms[i % numItems];
+    PODVector<unsigned char> vertexData(numItems * SKIN_VERTEX_SIZE);
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        float* vertex = (float*)&vertexData[i * SKIN_VERTEX_SIZE];
+        for (unsigned j = 0; j < 6; ++j)
+            vertex[j] = Random(-1.0f, 1.0f);
+        float totalWeight = 0.0f;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            vertex[6 + j] = Random(1.0f);
+            totalWeight += vertex[6 + j];
+        }
+        unsigned char* indices = (unsigned char*)(vertex + 10);
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            vertex[6 + j] /= totalWeight;
+            indices[j] = (unsigned char)(Rand() % SKIN_BONES);
+        }
+    }
+    
+    VertexBufferMorph morph;
+    morph.elementMask_ = MASK_POSITION | MASK_NORMAL;
+    morph.vertexCount_ = (numItems + 1) / 2;
+    morph.morphData_ = new unsigned char[morph.vertexCount_ * MORPH_VERTEX_SIZE];
+    for (unsigned i = 0; i < morph.vertexCount_; ++i)
+    {
+        unsigned char* dest = &morph.morphData_[i * MORPH_VERTEX_SIZE];
+        *((unsigned*)dest) = i * 2;
+        float* delta = (float*)(dest + sizeof(unsigned));
+        for (unsigned j = 0; j < 6; ++j)
+            delta[j] = Random(-1.0f, 1.0f);
+    }
+    
+    Frustum frustum;
+    frustum.Define(60.0f, 1.5f, 1.0f, 0.1f, 100.0f, Matrix3x4(Vector3::ZERO, Quaternion(30.0f, Vector3::UP), 1.0f));
+    
+    #ifdef URHO3D_SSE_MATH
+    PrintLine("Math operations with SSE code paths, " + String(numItems) + " items, " + String(numFrames) + " frames");
+    #else
+    PrintLine("Math operations with scalar code paths, " + String(numItems) + " items, " + String(numFrames) + " frames");
+    #endif
+    
+    unsigned numOps = numItems * numFrames;
+    bool passed = true;
+    HiresTimer timer;
+    long long referenceUSec;
+    
+    {
+        PODVector<Matrix3x4> result(numItems);
+        PODVector<Matrix3x4> reference(numItems);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                reference[i] = ReferenceMultiply(transforms[i], transforms[numItems - 1 - i]);
+        }
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                result[i] = transforms[i] * transforms[numItems - 1 - i];
+        }
+        passed &= Report("Matrix3x4 multiply", numOps, timer.GetUSec(false), referenceUSec, MaxError(result[0].Data(),
+            reference[0].Data(), numItems * 12));
+    }
+    
+    {
+        PODVector<Matrix4> result(numItems);
+        PODVector<Matrix4> reference(numItems);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                reference[i] = ReferenceMultiply(projections[i], projections[numItems - 1 - i]);
+        }
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                result[i] = projections[i] * projections[numItems - 1 - i];
+        }
+        passed &= Report("Matrix4 multiply", numOps, timer.GetUSec(false), referenceUSec, MaxError(result[0].Data(),
+            reference[0].Data(), numItems * 16));
+    }
+    
+    {
+        PODVector<BoundingBox> result(numItems);
+        PODVector<BoundingBox> reference(numItems);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                reference[i] = ReferenceTransformed(boxes[i], transforms[numItems - 1 - i]);
+        }
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                result[i] = boxes[i].Transformed(transforms[numItems - 1 - i]);
+        }
+        float maxError = 0.0f;
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            maxError = Max(maxError, MaxError(result[i].min_.Data(), reference[i].min_.Data(), 3));
+            maxError = Max(maxError, MaxError(result[i].max_.Data(), reference[i].max_.Data(), 3));
+        }
+        passed &= Report("BoundingBox transform", numOps, timer.GetUSec(false), referenceUSec, maxError);
+    }
+    
+    {
+        PODVector<Quaternion> result(numItems);
+        PODVector<Quaternion> reference(numItems);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                reference[i] = ReferenceMultiply(rotations[i], rotations[numItems - 1 - i]);
+        }
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                result[i] = rotations[i] * rotations[numItems - 1 - i];
+        }
+        passed &= Report("Quaternion multiply", numOps, timer.GetUSec(false), referenceUSec, MaxError(result[0].Data(),
+            reference[0].Data(), numItems * 4));
+    }
+    
+    {
+        PODVector<Quaternion> result(numItems);
+        PODVector<Quaternion> reference(numItems);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                reference[i] = ReferenceNormalized(unnormalized[i]);
+        }
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                result[i] = unnormalized[i].Normalized();
+        }
+        passed &= Report("Quaternion normalize", numOps, timer.GetUSec(false), referenceUSec, MaxError(result[0].Data(),
+            reference[0].Data(), numItems * 4));
+    }
+    
+    {
+        PODVector<Quaternion> result(numItems);
+        PODVector<Quaternion> reference(numItems);
+        float t = 0.3f;
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                reference[i] = ReferenceSlerp(rotations[i], rotations[numItems - 1 - i], t);
+        }
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+                result[i] = rotations[i].Slerp(rotations[numItems - 1 - i], t);
+        }
+        passed &= Report("Quaternion slerp", numOps, timer.GetUSec(false), referenceUSec, MaxError(result[0].Data(),
+            reference[0].Data(), numItems * 4));
+    }
+    
+    {
+        unsigned numGroups = numItems / 4;
+        PODVector<unsigned> result(numGroups);
+        PODVector<unsigned> reference(numGroups);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numGroups; ++i)
+                reference[i] = ReferenceIsInsideFast4(frustum, &packedBoxes[i * 24]);
+        }
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned i = 0; i < numGroups; ++i)
+                result[i] = frustum.IsInsideFast4(&packedBoxes[i * 24]);
+        }
+        // Culling results are bitmasks, so any difference is a failure
+        unsigned numMismatches = 0;
+        for (unsigned i = 0; i < numGroups; ++i)
+        {
+            if (result[i] != reference[i])
+                ++numMismatches;
+        }
+        passed &= Report("Frustum box test x4", numGroups * numFrames, timer.GetUSec(false), referenceUSec,
+            numMismatches ? 1.0f : 0.0f);
+    }
+    
+    {
+        PODVector<Vector3> result(numItems);
+        PODVector<Vector3> reference(numItems);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+            ReferenceSkinPositions(&reference[0], &vertexData[0], numItems, &skinMatrices[0]);
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            SkinPositions(&result[0], &vertexData[0], SKIN_VERTEX_SIZE, &vertexData[0], SKIN_VERTEX_SIZE, 6 * sizeof(float),
+                10 * sizeof(float), 0, numItems, &skinMatrices[0], SKIN_BONES);
+        }
+        passed &= Report("CPU skinning", numOps, timer.GetUSec(false), referenceUSec, MaxError(result[0].Data(),
+            reference[0].Data(), numItems * 3));
+    }
+    
+    {
+        // Alternate the weight sign so that the morphed values stay in range
+        PODVector<unsigned char> result(vertexData);
+        PODVector<unsigned char> reference(vertexData);
+        timer.Reset();
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+            ReferenceApplyMorph(&reference[0], morph.morphData_, morph.vertexCount_, (frame & 1) ? -0.5f : 0.5f);
+        referenceUSec = timer.GetUSec(true);
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            ApplyVertexMorph(&result[0], SKIN_VERTEX_SIZE, 3 * sizeof(float), 0, MASK_POSITION | MASK_NORMAL, 0, morph,
+                (frame & 1) ? -0.5f : 0.5f);
+        }
+        float maxError = 0.0f;
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            maxError = Max(maxError, MaxError((const float*)&result[i * SKIN_VERTEX_SIZE], (const float*)&reference[i *
+                SKIN_VERTEX_SIZE], 6));
+        }
+        passed &= Report("Vertex morph", morph.vertexCount_ * numFrames, timer.GetUSec(false), referenceUSec, maxError);
+    }
+    
+    if (!passed)
+        ErrorExit("Math results differ from the reference beyond tolerance");
+}
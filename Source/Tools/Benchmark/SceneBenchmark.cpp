@@ -0,0 +1,830 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AnimatedModel.h"
+#include "Animation.h"
+#include "AnimationController.h"
+#include "BenchmarkAgent.h"
+#include "Camera.h"
+#include "CollisionShape.h"
+#include "Connection.h"
+#include "Context.h"
+#include "CoreEvents.h"
+#include "Engine.h"
+#include "Light.h"
+#include "Log.h"
+#include "Model.h"
+#include "Network.h"
+#include "NetworkEvents.h"
+#include "Octree.h"
+#include "OctreeQuery.h"
+#include "PhysicsEvents.h"
+#include "PhysicsWorld.h"
+#include "PoseCache.h"
+#include "Prefab.h"
+#include "Profiler.h"
+#include "ResourceCache.h"
+#include "RigidBody.h"
+#include "Scene.h"
+#include "SceneBenchmark.h"
+#include "Sort.h"
+#include "StaticModel.h"
+#include "Timer.h"
+#include "XMLFile.h"
+#include "Zone.h"
+
+#include <cstdio>
+
+#include "DebugNew.h"
+
+static const unsigned short REPLICATION_PORT = 2345;
+static const long long CONNECT_TIMEOUT = 10000000LL;
+static const unsigned NUM_AREA_QUERIES = 256;
+static const float SPAWN_RATE = 10000.0f;
+static const float SPAWN_LIFETIME = 1.0f;
+
+SceneBenchmark::SceneBenchmark(Context* context) :
+    Object(context),
+    numSpawned_(0),
+    elapsedTime_(0.0f),
+    numEvents_(0),
+    numAllocations_(0),
+    numVisible_(0),
+    numCollisions_(0),
+    numQueryResults_(0),
+    queryCache_(0),
+    hiddenIndex_(0),
+    packedCulling_(false),
+    flatTransforms_(false),
+    parallelUpdate_(false),
+    poseBuffer_(false),
+    compressAnimation_(false),
+    usePoseCache_(false),
+    cpuSkinning_(false),
+    animationMemory_(0)
+{
+    SubscribeToEvent(E_UPDATE, HANDLER(SceneBenchmark, HandleUpdate));
+    SubscribeToEvent(E_RENDERUPDATE, HANDLER(SceneBenchmark, HandleRenderUpdate));
+    SubscribeToEvent(E_CLIENTCONNECTED, HANDLER(SceneBenchmark, HandleClientConnected));
+}
+
+SceneBenchmark::~SceneBenchmark()
+{
+    for (unsigned i = 0; i < queries_.Size(); ++i)
+        delete queries_[i];
+    delete queryCache_;
+    
+    Network* network = GetSubsystem<Network>();
+    if (network)
+    {
+        network->Disconnect(100);
+        network->StopServer();
+    }
+}
+
+bool SceneBenchmark::CreateScenario(const String& name)
+{
+    name_ = name;
+    
+    // Use the same random sequence on each run
+    SetRandomSeed(1);
+    
+    if (name == "objects" || name == "movingobjects")
+        CreateObjects();
+    else if (name == "queries")
+    {
+        CreateObjects();
+        CreateQueries();
+    }
+    else if (name == "cachedqueries")
+    {
+        CreateObjects();
+        queryCache_ = new OctreeQueryCache();
+    }
+    else if (name == "iteration")
+        CreateObjects();
+    else if (name == "transforms")
+        CreateTransforms();
+    else if (name == "agents")
+        CreateAgents();
+    else if (name == "spawning")
+        CreateSpawning(true);
+    else if (name == "xmlspawning")
+        CreateSpawning(false);
+    else if (name == "physics")
+        CreatePhysics(false, false);
+    else if (name == "collisions")
+        CreatePhysics(true, true);
+    else if (name == "legacycollisions")
+        CreatePhysics(true, false);
+    else if (name == "crowd")
+        CreateCrowd();
+    else if (name == "replication")
+        return CreateReplication();
+    else
+    {
+        LOGERROR("Unknown benchmark scenario " + name);
+        return false;
+    }
+    
+    return true;
+}
+
+void SceneBenchmark::Run(unsigned numFrames, float timeStep)
+{
+    Profiler* profiler = GetSubsystem<Profiler>();
+    if (profiler)
+        profiler->SetFrameCapture(numFrames);
+    
+    frameTimes_.Clear();
+    numVisible_ = 0;
+    numCollisions_ = 0;
+    numQueryResults_ = 0;
+    
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        HiresTimer frameTimer;
+        RunFrame(timeStep);
+        frameTimes_.Push(frameTimer.GetUSec(false));
+    }
+    
+    blocks_.Clear();
+    numEvents_ = 0;
+    numAllocations_ = 0;
+    if (!profiler)
+        return;
+    
+    // Accumulate the captured frames per block path, oldest frame first
+    HashMap<String, unsigned> blockIndices;
+    PODVector<unsigned> frameIndices;
+    Vector<String> framePaths;
+    
+    for (unsigned i = profiler->GetNumCapturedFrames(); i-- > 0;)
+    {
+        const ProfilerFrame* frame = profiler->GetCapturedFrame(i);
+        numEvents_ += frame->numEvents_;
+        numAllocations_ += frame->numAllocations_;
+        frameIndices.Resize(frame->blocks_.Size());
+        framePaths.Resize(frame->blocks_.Size());
+        
+        for (unsigned j = 0; j < frame->blocks_.Size(); ++j)
+        {
+            const ProfilerFrameBlock& block = frame->blocks_[j];
+            framePaths[j] = block.parent_ == M_MAX_UNSIGNED ? String(block.name_) : framePaths[block.parent_] + "/" + block.name_;
+            
+            HashMap<String, unsigned>::Iterator k = blockIndices.Find(framePaths[j]);
+            if (k == blockIndices.End())
+            {
+                BenchmarkBlock newBlock;
+                newBlock.path_ = framePaths[j];
+                newBlock.time_ = 0;
+                newBlock.maxTime_ = 0;
+                newBlock.count_ = 0;
+                k = blockIndices.Insert(MakePair(framePaths[j], blocks_.Size()));
+                blocks_.Push(newBlock);
+            }
+            
+            BenchmarkBlock& dest = blocks_[k->second_];
+            dest.time_ += block.time_;
+            dest.count_ += block.count_;
+            if (block.time_ > dest.maxTime_)
+                dest.maxTime_ = block.time_;
+        }
+    }
+}
+
+void SceneBenchmark::SaveJSON(String& dest) const
+{
+    char line[256];
+    
+    long long totalTime = 0;
+    long long minTime = frameTimes_.Size() ? frameTimes_[0] : 0;
+    long long maxTime = 0;
+    for (unsigned i = 0; i < frameTimes_.Size(); ++i)
+    {
+        totalTime += frameTimes_[i];
+        if (frameTimes_[i] < minTime)
+            minTime = frameTimes_[i];
+        if (frameTimes_[i] > maxTime)
+            maxTime = frameTimes_[i];
+    }
+    
+    float numFrames = (float)Max((int)frameTimes_.Size(), 1);
+    
+    sprintf(line, "{\"name\":\"%s\",\"nodes\":%u,\"frames\":%u,\"animationMemory\":%u,\"poseCacheHits\":%u,"
+        "\"poseCacheMisses\":%u,\n", name_.CString(), scenes_.Size() ? scenes_[0]->GetNumChildren(true) : 0, frameTimes_.Size(),
+        animationMemory_, poseCache_ ? poseCache_->GetNumHits() : 0, poseCache_ ? poseCache_->GetNumMisses() : 0);
+    dest += String(line);
+    sprintf(line, "\"frameTime\":{\"avg\":%.3f,\"min\":%.3f,\"max\":%.3f,\"total\":%.3f},\n", totalTime / numFrames / 1000.0f,
+        minTime / 1000.0f, maxTime / 1000.0f, totalTime / 1000.0f);
+    dest += String(line);
+    sprintf(line, "\"eventsPerFrame\":%.1f,\"allocationsPerFrame\":%.1f,\"visiblePerFrame\":%.1f,\"collisionsPerFrame\":%.1f,"
+        "\"queryResultsPerFrame\":%.1f,\n", numEvents_ / numFrames, numAllocations_ / numFrames, numVisible_ / numFrames,
+        numCollisions_ / numFrames, numQueryResults_ / numFrames);
+    dest += String(line);
+    
+    // Times are milliseconds and calls per frame
+    dest += "\"subsystems\":[";
+    for (unsigned i = 0; i < blocks_.Size(); ++i)
+    {
+        const BenchmarkBlock& block = blocks_[i];
+        sprintf(line, "%s\n{\"block\":\"%s\",\"avg\":%.3f,\"max\":%.3f,\"calls\":%.1f}", i ? "," : "", block.path_.CString(),
+            block.time_ / numFrames / 1000.0f, block.maxTime_ / 1000.0f, block.count_ / numFrames);
+        dest += String(line);
+    }
+    dest += "]}";
+}
+
+void SceneBenchmark::CreateObjects()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Scene* scene = CreateScene(false);
+    Model* boxModel = cache->GetResource<Model>("Models/Box.mdl");
+    
+    // Same object count and layout as in the HugeObjectCount sample
+    for (int y = -125; y < 125; ++y)
+    {
+        for (int x = -125; x < 125; ++x)
+        {
+            Node* boxNode = scene->CreateChild("Box");
+            boxNode->SetPosition(Vector3(x * 0.3f, 0.0f, y * 0.3f));
+            boxNode->SetScale(0.25f);
+            StaticModel* boxObject = boxNode->CreateComponent<StaticModel>();
+            boxObject->SetModel(boxModel);
+            nodes_.Push(SharedPtr<Node>(boxNode));
+        }
+    }
+    
+    cameraNodes_[0]->SetPosition(Vector3(0.0f, 10.0f, -100.0f));
+}
+
+void SceneBenchmark::CreateQueries()
+{
+    // Area queries around random points of the box grid, like AI perception or area effects would issue. Half are spheres
+    // and half boxes
+    queryResults_.Resize(NUM_AREA_QUERIES);
+    for (unsigned i = 0; i < NUM_AREA_QUERIES; ++i)
+    {
+        Vector3 center(Random(-37.5f, 37.5f), 0.0f, Random(-37.5f, 37.5f));
+        if (i & 1)
+            queries_.Push(new BoxOctreeQuery(queryResults_[i], BoundingBox(center - Vector3::ONE * 2.0f, center + Vector3::ONE *
+                2.0f), DRAWABLE_GEOMETRY));
+        else
+            queries_.Push(new SphereOctreeQuery(queryResults_[i], Sphere(center, 2.0f), DRAWABLE_GEOMETRY));
+    }
+}
+
+void SceneBenchmark::CreateTransforms()
+{
+    Scene* scene = CreateScene(false);
+    
+    // Deep enough that most of the nodes are not direct children of the scene, and wide enough to keep the worker threads
+    // busy on each level. The leaves are read back each frame like the components depending on them would
+    const int NUM_ROOTS = 1000;
+    const int NUM_CHILDREN = 10;
+    for (int i = 0; i < NUM_ROOTS; ++i)
+    {
+        Node* rootNode = scene->CreateChild("Root");
+        rootNode->SetPosition(Vector3((i % 40 - 20) * 4.0f, 0.0f, (i / 40 - 12) * 4.0f));
+        nodes_.Push(SharedPtr<Node>(rootNode));
+        
+        for (int j = 0; j < NUM_CHILDREN; ++j)
+        {
+            Node* childNode = rootNode->CreateChild("Child");
+            childNode->SetPosition(Vector3(1.0f, 0.0f, 0.0f));
+            childNode->SetRotation(Quaternion(j * 36.0f, Vector3::UP));
+            
+            for (int k = 0; k < NUM_CHILDREN; ++k)
+            {
+                Node* leafNode = childNode->CreateChild("Leaf");
+                leafNode->SetPosition(Vector3(0.0f, k * 0.2f, 0.5f));
+                leafNode->SetScale(0.1f);
+                leafNodes_.Push(leafNode);
+            }
+        }
+    }
+    
+    cameraNodes_[0]->SetPosition(Vector3(0.0f, 10.0f, -100.0f));
+}
+
+void SceneBenchmark::CreateAgents()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Scene* scene = CreateScene(false);
+    Model* boxModel = cache->GetResource<Model>("Models/Box.mdl");
+    
+    const int NUM_OBSTACLES = 32;
+    for (int i = 0; i < NUM_OBSTACLES; ++i)
+    {
+        Node* obstacleNode = scene->CreateChild("Obstacle");
+        obstacleNode->SetPosition(Vector3(Random(-40.0f, 40.0f), 0.0f, Random(-40.0f, 40.0f)));
+        obstacleNode->SetScale(2.0f);
+        StaticModel* obstacleObject = obstacleNode->CreateComponent<StaticModel>();
+        obstacleObject->SetModel(boxModel);
+        obstacles_.Push(obstacleNode->GetPosition());
+    }
+    
+    const int NUM_AGENTS = 4000;
+    for (int i = 0; i < NUM_AGENTS; ++i)
+    {
+        Node* agentNode = scene->CreateChild("Agent");
+        agentNode->SetPosition(Vector3(Random(-50.0f, 50.0f), 0.0f, Random(-50.0f, 50.0f)));
+        agentNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+        agentNode->SetScale(0.5f);
+        StaticModel* agentObject = agentNode->CreateComponent<StaticModel>();
+        agentObject->SetModel(boxModel);
+        BenchmarkAgent* agent = agentNode->CreateComponent<BenchmarkAgent>();
+        agent->SetParallel(parallelUpdate_);
+        agent->SetObstacles(&obstacles_);
+        agent->SetPhase(Random(360.0f));
+    }
+    
+    cameraNodes_[0]->SetPosition(Vector3(0.0f, 30.0f, -80.0f));
+}
+
+void SceneBenchmark::CreateSpawning(bool prefab)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    CreateScene(false);
+    
+    // Build the projectile in a detached node and save it, like an editor would save an object file
+    SharedPtr<Node> projectileNode(new Node(context_));
+    projectileNode->SetName("Projectile");
+    projectileNode->SetScale(0.2f);
+    StaticModel* projectileObject = projectileNode->CreateComponent<StaticModel>();
+    projectileObject->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
+    projectileObject->SetCastShadows(true);
+    Node* glowNode = projectileNode->CreateChild("Glow");
+    glowNode->SetPosition(Vector3(0.0f, 0.0f, -1.0f));
+    Light* glow = glowNode->CreateComponent<Light>();
+    glow->SetLightType(LIGHT_POINT);
+    glow->SetRange(2.0f);
+    glow->SetColor(Color(1.0f, 0.5f, 0.1f));
+    
+    spawnXML_ = new XMLFile(context_);
+    XMLElement rootElem = spawnXML_->CreateRoot("node");
+    projectileNode->SaveXML(rootElem);
+    
+    if (prefab)
+    {
+        spawnPrefab_ = new Prefab(context_);
+        spawnPrefab_->LoadXML(spawnXML_->GetRoot());
+    }
+    
+    cameraNodes_[0]->SetPosition(Vector3(0.0f, 20.0f, -80.0f));
+}
+
+void SceneBenchmark::CreatePhysics(bool collisionEvents, bool typedHandlers)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Scene* scene = CreateScene(true);
+    Model* boxModel = cache->GetResource<Model>("Models/Box.mdl");
+    
+    {
+        Node* floorNode = scene->CreateChild("Floor");
+        floorNode->SetPosition(Vector3(0.0f, -0.5f, 0.0f));
+        floorNode->SetScale(Vector3(500.0f, 1.0f, 500.0f));
+        StaticModel* floorObject = floorNode->CreateComponent<StaticModel>();
+        floorObject->SetModel(boxModel);
+        floorNode->CreateComponent<RigidBody>();
+        CollisionShape* shape = floorNode->CreateComponent<CollisionShape>();
+        shape->SetBox(Vector3::ONE);
+    }
+    
+    // Stacks of boxes with a small gap, so that they fall onto each other and settle during the first frames
+    const int NUM_STACKS = 10;
+    const int STACK_HEIGHT = 10;
+    for (int z = 0; z < NUM_STACKS; ++z)
+    {
+        for (int x = 0; x < NUM_STACKS; ++x)
+        {
+            for (int y = 0; y < STACK_HEIGHT; ++y)
+            {
+                Node* boxNode = scene->CreateChild("Box");
+                boxNode->SetPosition(Vector3((x - NUM_STACKS / 2) * 3.0f, y * 1.1f + 0.6f, (z - NUM_STACKS / 2) * 3.0f));
+                boxNode->SetRotation(Quaternion(0.0f, Random(10.0f), 0.0f));
+                StaticModel* boxObject = boxNode->CreateComponent<StaticModel>();
+                boxObject->SetModel(boxModel);
+                
+                RigidBody* body = boxNode->CreateComponent<RigidBody>();
+                body->SetMass(1.0f);
+                body->SetFriction(1.0f);
+                CollisionShape* shape = boxNode->CreateComponent<CollisionShape>();
+                shape->SetBox(Vector3::ONE);
+                
+                // When measuring collision events, send them also for the resting contacts so that every box receives
+                // events each physics step
+                if (!collisionEvents)
+                    body->SetCollisionEventMode(COLLISION_NEVER);
+                else
+                {
+                    body->SetCollisionEventMode(COLLISION_ALWAYS);
+                    if (typedHandlers)
+                        SubscribeToEvent(boxNode, E_NODECOLLISION, TYPED_HANDLER(SceneBenchmark, HandleNodeCollision));
+                    else
+                        SubscribeToEvent(boxNode, E_NODECOLLISION, HANDLER(SceneBenchmark, HandleNodeCollisionLegacy));
+                }
+            }
+        }
+    }
+    
+    cameraNodes_[0]->SetPosition(Vector3(0.0f, 10.0f, -40.0f));
+}
+
+void SceneBenchmark::CreateCrowd()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Scene* scene = CreateScene(false);
+    Model* jackModel = cache->GetResource<Model>("Models/Jack.mdl");
+    Animation* walkAnimation = cache->GetResource<Animation>("Models/Jack_Walk.ani");
+    
+    // Compressing the cached resource makes the animation controllers play the compressed tracks
+    if (walkAnimation)
+    {
+        if (compressAnimation_)
+            walkAnimation->Compress();
+        animationMemory_ = walkAnimation->GetMemoryUse();
+    }
+    
+    // Models playing the walk at nearby time positions copy the same pose from the cache
+    if (usePoseCache_)
+        poseCache_ = new PoseCache();
+    
+    // Animated models like in the SkeletalAnimation sample, in a grid and with varying animation start times
+    const int CROWD_SIZE = 20;
+    for (int z = 0; z < CROWD_SIZE; ++z)
+    {
+        for (int x = 0; x < CROWD_SIZE; ++x)
+        {
+            Node* modelNode = scene->CreateChild("Jack");
+            modelNode->SetPosition(Vector3((x - CROWD_SIZE / 2) * 4.0f, 0.0f, (z - CROWD_SIZE / 2) * 4.0f));
+            modelNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+            AnimatedModel* modelObject = modelNode->CreateComponent<AnimatedModel>();
+            modelObject->SetUsePoseBuffer(poseBuffer_);
+            modelObject->SetModel(jackModel);
+            modelObject->SetPoseCache(poseCache_);
+            modelObject->SetCPUSkinning(cpuSkinning_);
+            
+            AnimationController* controller = modelNode->CreateComponent<AnimationController>();
+            controller->PlayExclusive("Models/Jack_Walk.ani", 0, true);
+            controller->SetTime("Models/Jack_Walk.ani", Random(1.0f));
+            nodes_.Push(SharedPtr<Node>(modelNode));
+        }
+    }
+    
+    cameraNodes_[0]->SetPosition(Vector3(0.0f, 5.0f, -50.0f));
+}
+
+bool SceneBenchmark::CreateReplication()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Network* network = GetSubsystem<Network>();
+    Scene* scene = CreateScene(false);
+    Model* boxModel = cache->GetResource<Model>("Models/Box.mdl");
+    
+    const int GRID_SIZE = 32;
+    for (int z = 0; z < GRID_SIZE; ++z)
+    {
+        for (int x = 0; x < GRID_SIZE; ++x)
+        {
+            Node* boxNode = scene->CreateChild("Box");
+            boxNode->SetPosition(Vector3((x - GRID_SIZE / 2) * 2.0f, 0.0f, (z - GRID_SIZE / 2) * 2.0f));
+            StaticModel* boxObject = boxNode->CreateComponent<StaticModel>();
+            boxObject->SetModel(boxModel);
+            nodes_.Push(SharedPtr<Node>(boxNode));
+        }
+    }
+    
+    cameraNodes_[0]->SetPosition(Vector3(0.0f, 20.0f, -60.0f));
+    
+    // Replicate to a client in the same process over the loopback interface. The client scene also gets updated each frame
+    SharedPtr<Scene> clientScene(new Scene(context_));
+    SharedPtr<Node> clientCameraNode(new Node(context_));
+    clientCameraNode->SetPosition(cameraNodes_[0]->GetPosition());
+    clientCameraNode->CreateComponent<Camera>()->SetFarClip(300.0f);
+    scenes_.Push(clientScene);
+    cameraNodes_.Push(clientCameraNode);
+    
+    if (!network->StartServer(REPLICATION_PORT) || !network->Connect("localhost", REPLICATION_PORT, clientScene))
+        return false;
+    
+    // Step untimed frames until the client has loaded the scene
+    HiresTimer connectTimer;
+    while (connectTimer.GetUSec(false) < CONNECT_TIMEOUT)
+    {
+        RunFrame(1.0f / 60.0f);
+        
+        Connection* connection = network->GetServerConnection();
+        if (!connection)
+            break;
+        if (connection->IsSceneLoaded())
+            return true;
+        
+        Time::Sleep(1);
+    }
+    
+    LOGERROR("Replication client failed to connect");
+    return false;
+}
+
+Scene* SceneBenchmark::CreateScene(bool physics)
+{
+    SharedPtr<Scene> scene(new Scene(context_));
+    scene->SetFlatTransformUpdate(flatTransforms_);
+    Octree* octree = scene->CreateComponent<Octree>();
+    octree->SetPackedCulling(packedCulling_);
+    if (physics)
+        scene->CreateComponent<PhysicsWorld>();
+    
+    Node* zoneNode = scene->CreateChild("Zone");
+    Zone* zone = zoneNode->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    
+    Node* lightNode = scene->CreateChild("DirectionalLight");
+    lightNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    Light* light = lightNode->CreateComponent<Light>();
+    light->SetLightType(LIGHT_DIRECTIONAL);
+    
+    // Create the camera outside the scene so that it is not replicated
+    SharedPtr<Node> cameraNode(new Node(context_));
+    Camera* camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFarClip(300.0f);
+    
+    scenes_.Push(scene);
+    cameraNodes_.Push(cameraNode);
+    return scene;
+}
+
+void SceneBenchmark::RunFrame(float timeStep)
+{
+    Time* time = GetSubsystem<Time>();
+    Engine* engine = GetSubsystem<Engine>();
+    
+    time->BeginFrame(timeStep);
+    engine->Update();
+    engine->Render();
+    time->EndFrame();
+}
+
+void SceneBenchmark::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace Update;
+    
+    PROFILE(AnimateObjects);
+    
+    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    elapsedTime_ += timeStep;
+    
+    if (name_ == "objects" || name_ == "queries" || name_ == "iteration" || name_ == "transforms")
+    {
+        Quaternion rotateQuat(15.0f * timeStep, Vector3::FORWARD);
+        for (unsigned i = 0; i < nodes_.Size(); ++i)
+            nodes_[i]->Rotate(rotateQuat);
+    }
+    else if (name_ == "movingobjects")
+    {
+        // Move each box around a small circle with a different phase, so that the boxes cross octant boundaries continuously
+        for (unsigned i = 0; i < nodes_.Size(); ++i)
+        {
+            float angle = elapsedTime_ * 90.0f + (float)i;
+            nodes_[i]->Translate(Vector3(Cos(angle), Sin(angle), 0.0f) * 3.0f * timeStep);
+        }
+    }
+    else if (name_ == "cachedqueries")
+    {
+        // Keep the boxes still so that the culling query can be repeated from its cache, but hide a different box each frame.
+        // The view mask changes must invalidate the cached results of the boxes' octants
+        nodes_[hiddenIndex_]->GetComponent<StaticModel>()->SetViewMask(DEFAULT_VIEWMASK);
+        hiddenIndex_ = (hiddenIndex_ + 101) % nodes_.Size();
+        nodes_[hiddenIndex_]->GetComponent<StaticModel>()->SetViewMask(0);
+    }
+    else if (name_ == "spawning" || name_ == "xmlspawning")
+        SpawnObjects(timeStep);
+    else if (name_ == "crowd")
+    {
+        // Walk forward and turn when outside the area, like the Mover component of the SkeletalAnimation sample
+        const BoundingBox bounds(Vector3(-45.0f, 0.0f, -45.0f), Vector3(45.0f, 0.0f, 45.0f));
+        for (unsigned i = 0; i < nodes_.Size(); ++i)
+        {
+            Node* node = nodes_[i];
+            node->Translate(Vector3::FORWARD * 2.0f * timeStep);
+            if (bounds.IsInside(node->GetPosition()) == OUTSIDE)
+                node->Yaw(100.0f * timeStep);
+        }
+    }
+    else if (name_ == "replication")
+    {
+        for (unsigned i = 0; i < nodes_.Size(); ++i)
+        {
+            Vector3 position = nodes_[i]->GetPosition();
+            position.y_ = Sin(elapsedTime_ * 90.0f + i * 10.0f);
+            nodes_[i]->SetPosition(position);
+        }
+    }
+}
+
+void SceneBenchmark::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace RenderUpdate;
+    
+    Time* time = GetSubsystem<Time>();
+    
+    // In headless mode there are no views to update the octrees. Update them without a camera, which animates all animated
+    // models regardless of their visibility, except in the crowd scenario, which animates like the renderer does: only the
+    // models that were visible on the previous frame
+    FrameInfo frame;
+    frame.frameNumber_ = time->GetFrameNumber();
+    frame.timeStep_ = eventData[P_TIMESTEP].GetFloat();
+    frame.viewSize_ = IntVector2(1280, 720);
+    frame.camera_ = 0;
+    
+    if (!leafNodes_.Empty())
+    {
+        PROFILE(ReadTransforms);
+        Vector3 sum(Vector3::ZERO);
+        for (unsigned i = 0; i < leafNodes_.Size(); ++i)
+            sum += leafNodes_[i]->GetWorldPosition();
+        // Use the result so that the reads are not optimized away
+        if (sum.x_ != sum.x_)
+            LOGWARNING("Non-finite leaf node positions");
+    }
+    
+    if (name_ == "iteration")
+        IterateComponents();
+    
+    for (unsigned i = 0; i < scenes_.Size(); ++i)
+    {
+        Octree* octree = scenes_[i]->GetComponent<Octree>();
+        if (!octree)
+            continue;
+        
+        Camera* camera = cameraNodes_[i]->GetComponent<Camera>();
+        if (name_ == "crowd")
+            frame.camera_ = camera;
+        
+        {
+            PROFILE(UpdateOctree);
+            octree->Update(frame);
+        }
+        
+        {
+            PROFILE(CullDrawables);
+            FrustumOctreeQuery query(drawables_, camera->GetFrustum(), DRAWABLE_GEOMETRY);
+            if (queryCache_)
+                octree->GetDrawables(query, *queryCache_, true);
+            else
+                octree->GetDrawables(query);
+            numVisible_ += drawables_.Size();
+        }
+        
+        // Verify the cached culling results against a full query
+        if (queryCache_)
+        {
+            FrustumOctreeQuery query(fullDrawables_, camera->GetFrustum(), DRAWABLE_GEOMETRY);
+            octree->GetDrawables(query);
+            Sort(drawables_.Begin(), drawables_.End());
+            Sort(fullDrawables_.Begin(), fullDrawables_.End());
+            if (drawables_ != fullDrawables_)
+                LOGERROR("Cached culling query results differ from a full query");
+        }
+        
+        // Without views the skinning is not updated either, so update it for the visible animated models that did not
+        // already calculate it during the octree update, and mark them visible for the next frame's animation
+        if (name_ == "crowd")
+        {
+            PROFILE(UpdateSkinning);
+            for (unsigned j = 0; j < drawables_.Size(); ++j)
+            {
+                drawables_[j]->MarkInView(frame);
+                if (drawables_[j]->GetUpdateGeometryType() == UPDATE_WORKER_THREAD)
+                    drawables_[j]->UpdateGeometry(frame);
+            }
+        }
+        
+        // With CPU skinning, raycast against the skinned triangles of the crowd like a server checking for hits would
+        if (name_ == "crowd" && cpuSkinning_)
+        {
+            PROFILE(SkinnedRaycasts);
+            const int RAY_GRID = 4;
+            for (int y = 0; y < RAY_GRID; ++y)
+            {
+                for (int x = 0; x < RAY_GRID; ++x)
+                {
+                    RayOctreeQuery rayQuery(rayResults_, camera->GetScreenRay((x + 0.5f) / RAY_GRID, (y + 0.5f) / RAY_GRID),
+                        RAY_TRIANGLE, camera->GetFarClip(), DRAWABLE_GEOMETRY);
+                    octree->Raycast(rayQuery);
+                    numQueryResults_ += rayResults_.Size();
+                }
+            }
+        }
+        
+        if (!queries_.Empty())
+        {
+            PROFILE(AreaQueries);
+            octree->GetDrawables(&queries_[0], queries_.Size(), queryBatchResult_, queryBatchOffsets_);
+            numQueryResults_ += queryBatchResult_.Size();
+        }
+    }
+}
+
+void SceneBenchmark::IterateComponents()
+{
+    // Read each model's world bounding box like a system processing all components of one type would
+    Scene* scene = scenes_[0];
+    Vector3 sum(Vector3::ZERO);
+    unsigned numTraversed;
+    
+    {
+        PROFILE(GetComponentsRecursive);
+        scene->GetComponents<StaticModel>(components_, true);
+        for (unsigned i = 0; i < components_.Size(); ++i)
+            sum += components_[i]->GetWorldBoundingBox().Center();
+        numTraversed = components_.Size();
+    }
+    
+    {
+        PROFILE(GetAllComponents);
+        scene->GetAllComponents<StaticModel>(components_);
+        for (unsigned i = 0; i < components_.Size(); ++i)
+            sum += components_[i]->GetWorldBoundingBox().Center();
+    }
+    
+    // Use the result so that the reads are not optimized away
+    if (components_.Size() != numTraversed || sum.x_ != sum.x_)
+        LOGWARNING("Component iteration results differ");
+}
+
+void SceneBenchmark::SpawnObjects(float timeStep)
+{
+    Scene* scene = scenes_[0];
+    
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+        nodes_[i]->Translate(Vector3::FORWARD * 20.0f * timeStep);
+    
+    // The projectiles are in spawn order, so the expired ones are at the front
+    unsigned maxProjectiles = (unsigned)(SPAWN_RATE * SPAWN_LIFETIME);
+    if (nodes_.Size() > maxProjectiles)
+    {
+        PROFILE(RemoveProjectiles);
+        unsigned numExpired = nodes_.Size() - maxProjectiles;
+        for (unsigned i = 0; i < numExpired; ++i)
+            nodes_[i]->Remove();
+        nodes_.Erase(0, numExpired);
+    }
+    
+    PROFILE(SpawnProjectiles);
+    unsigned numSpawn = (unsigned)(elapsedTime_ * SPAWN_RATE) - numSpawned_;
+    for (unsigned i = 0; i < numSpawn; ++i)
+    {
+        Vector3 position(Random(-40.0f, 40.0f), Random(1.0f, 5.0f), Random(-40.0f, 40.0f));
+        Quaternion rotation(0.0f, Random(360.0f), 0.0f);
+        Node* projectileNode = spawnPrefab_ ? scene->Instantiate(spawnPrefab_, position, rotation) :
+            scene->InstantiateXML(spawnXML_->GetRoot(), position, rotation);
+        nodes_.Push(SharedPtr<Node>(projectileNode));
+    }
+    numSpawned_ += numSpawn;
+}
+
+void SceneBenchmark::HandleNodeCollision(StringHash eventType, NodeCollisionEvent& eventData)
+{
+    if (eventData.otherNode_)
+        ++numCollisions_;
+}
+
+void SceneBenchmark::HandleNodeCollisionLegacy(StringHash eventType, VariantMap& eventData)
+{
+    using namespace NodeCollision;
+    
+    if (eventData[P_OTHERNODE].GetPtr())
+        ++numCollisions_;
+}
+
+void SceneBenchmark::HandleClientConnected(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientConnected;
+    
+    if (scenes_.Size())
+    {
+        Connection* newConnection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+        newConnection->SetScene(scenes_[0]);
+    }
+}
@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+
+namespace Urho3D
+{
+
+class Drawable;
+class Node;
+class NodeCollisionEvent;
+class OctreeQuery;
+struct OctreeQueryCache;
+class PoseCache;
+class Prefab;
+class Scene;
+struct RayQueryResult;
+class StaticModel;
+class XMLFile;
+
+}
+
+using namespace Urho3D;
+
+/// Timing of one profiling block over a benchmark run.
+struct BenchmarkBlock
+{
+    /// Block path from the root, separated with slashes.
+    String path_;
+    /// Accumulated time in microseconds.
+    long long time_;
+    /// Longest time during a single frame in microseconds.
+    long long maxTime_;
+    /// Accumulated calls.
+    unsigned count_;
+};
+
+/// Headless benchmark of a deterministic scene built after the load test samples. Steps a fixed number of frames at a fixed timestep.
+class SceneBenchmark : public Object
+{
+    OBJECT(SceneBenchmark);
+    
+public:
+    /// Construct. The engine must have been initialized.
+    SceneBenchmark(Context* context);
+    /// Destruct. Stop replication if in use.
+    virtual ~SceneBenchmark();
+    
+    /// Set whether to cull with the octree's packed bounding box tests. Call before creating the scenario.
+    void SetPackedCulling(bool enable) { packedCulling_ = enable; }
+    /// Set whether to update the scenes' transforms in a flat pass. Call before creating the scenario.
+    void SetFlatTransforms(bool enable) { flatTransforms_ = enable; }
+    /// Set whether the logic components update in the worker threads. Call before creating the scenario.
+    void SetParallelUpdate(bool enable) { parallelUpdate_ = enable; }
+    /// Set whether the animated models evaluate their skeletons in pose buffers. Call before creating the scenario.
+    void SetPoseBuffer(bool enable) { poseBuffer_ = enable; }
+    /// Set whether the crowd scenario compresses its animation before playing it. Call before creating the scenario.
+    void SetCompressAnimation(bool enable) { compressAnimation_ = enable; }
+    /// Set whether the crowd scenario's animated models share their poses through a pose cache. Requires pose buffers. Call before creating the scenario.
+    void SetPoseCache(bool enable) { usePoseCache_ = enable; }
+    /// Set whether the crowd scenario's animated models skin on the CPU, and raycasts are made against their triangles each frame. Call before creating the scenario.
+    void SetCPUSkinning(bool enable) { cpuSkinning_ = enable; }
+    /// Create the named scenario: objects, movingobjects, queries, cachedqueries, iteration, transforms, agents, spawning, xmlspawning, physics, collisions, legacycollisions, crowd or replication. Return true if successful.
+    bool CreateScenario(const String& name);
+    /// Step the frames and record the timings.
+    void Run(unsigned numFrames, float timeStep);
+    /// Append the results as a JSON object.
+    void SaveJSON(String& dest) const;
+    
+    /// Return the scenario name.
+    const String& GetName() const { return name_; }
+    
+private:
+    /// Create the huge object count scenario: a grid of rotating or moving boxes.
+    void CreateObjects();
+    /// Create the area queries issued each frame as one batch.
+    void CreateQueries();
+    /// Create the transform hierarchy scenario: rotating root nodes with two levels of children and no drawables.
+    void CreateTransforms();
+    /// Create the logic component scenario: wandering agents avoiding obstacles.
+    void CreateAgents();
+    /// Create the spawning scenario: short-lived projectiles instantiated at a fixed rate, either from a prefab or from XML.
+    void CreateSpawning(bool prefab);
+    /// Create the physics scenario: stacks of rigid body boxes settling on a floor. Optionally subscribe each box to its collision
+    /// events, either with a typed or a VariantMap handler.
+    void CreatePhysics(bool collisionEvents, bool typedHandlers);
+    /// Create the crowd scenario: walking animated models.
+    void CreateCrowd();
+    /// Create the replication scenario: moving replicated objects sent to a local client. Return true if the client connected.
+    bool CreateReplication();
+    /// Create a scene with octree, zone, light and camera.
+    Scene* CreateScene(bool physics);
+    /// Step one frame with the fixed timestep.
+    void RunFrame(float timeStep);
+    /// Animate the scenario's objects.
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    /// Collect the static models both by traversing the scene and from the component pool, and read them.
+    void IterateComponents();
+    /// Move the spawned projectiles, remove the expired and spawn new ones.
+    void SpawnObjects(float timeStep);
+    /// Update the octrees and cull from the camera, which the renderer would do when not headless.
+    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Count the contacts of a box collision.
+    void HandleNodeCollision(StringHash eventType, NodeCollisionEvent& eventData);
+    /// Count the contacts of a box collision using the VariantMap parameters.
+    void HandleNodeCollisionLegacy(StringHash eventType, VariantMap& eventData);
+    /// Assign the scene to a connecting client.
+    void HandleClientConnected(StringHash eventType, VariantMap& eventData);
+    
+    /// Scenario name.
+    String name_;
+    /// Scenes to update. When replicating, the first is the server scene and the second the client scene.
+    Vector<SharedPtr<Scene> > scenes_;
+    /// Camera nodes of the scenes.
+    Vector<SharedPtr<Node> > cameraNodes_;
+    /// Animated nodes.
+    Vector<SharedPtr<Node> > nodes_;
+    /// Nodes whose world transforms are read each frame.
+    PODVector<Node*> leafNodes_;
+    /// Obstacle positions for the agents.
+    PODVector<Vector3> obstacles_;
+    /// Projectile XML data.
+    SharedPtr<XMLFile> spawnXML_;
+    /// Projectile prefab. Null when spawning from XML.
+    SharedPtr<Prefab> spawnPrefab_;
+    /// Projectiles spawned so far.
+    unsigned numSpawned_;
+    /// Component iteration result.
+    PODVector<StaticModel*> components_;
+    /// Culling query result.
+    PODVector<Drawable*> drawables_;
+    /// Elapsed scenario time.
+    float elapsedTime_;
+    /// Frame times in microseconds.
+    PODVector<long long> frameTimes_;
+    /// Profiling block timings in tree order.
+    Vector<BenchmarkBlock> blocks_;
+    /// Accumulated number of events sent.
+    unsigned numEvents_;
+    /// Accumulated number of allocations.
+    unsigned numAllocations_;
+    /// Visible drawables accumulated over the frames.
+    unsigned numVisible_;
+    /// Collision events received over the frames.
+    unsigned numCollisions_;
+    /// Area queries.
+    PODVector<OctreeQuery*> queries_;
+    /// Area query result vectors.
+    Vector<PODVector<Drawable*> > queryResults_;
+    /// Area query results of the batch.
+    PODVector<Drawable*> queryBatchResult_;
+    /// Area query result offsets of the batch.
+    PODVector<unsigned> queryBatchOffsets_;
+    /// Raycast results against the skinned models.
+    PODVector<RayQueryResult> rayResults_;
+    /// Area query and raycast results accumulated over the frames.
+    unsigned numQueryResults_;
+    /// Cache for repeating the culling query.
+    OctreeQueryCache* queryCache_;
+    /// Culling query results without the cache, for verifying the cached results.
+    PODVector<Drawable*> fullDrawables_;
+    /// Index of the box hidden with its view mask.
+    unsigned hiddenIndex_;
+    /// Packed culling flag for the created octrees.
+    bool packedCulling_;
+    /// Flat transform update flag for the created scenes.
+    bool flatTransforms_;
+    /// Parallel logic component update flag.
+    bool parallelUpdate_;
+    /// Pose buffer flag.
+    bool poseBuffer_;
+    /// Animation compression flag.
+    bool compressAnimation_;
+    /// Pose cache flag.
+    bool usePoseCache_;
+    /// CPU skinning flag.
+    bool cpuSkinning_;
+    /// Memory use of the animations played in the scenario.
+    unsigned animationMemory_;
+    /// Pose cache shared by the animated models.
+    SharedPtr<PoseCache> poseCache_;
+};
@@ -0,0 +1,313 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "ProcessUtils.h"
+#include "Sort.h"
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <cstdio>
+
+#include "DebugNew.h"
+
+using namespace Urho3D;
+
+static const unsigned FRAME_CAPTURE_VERSION = 1;
+
+/// Profiling block of a captured frame.
+struct CapturedBlock
+{
+    /// Name index.
+    unsigned name_;
+    /// Parent block index plus one, or zero for a root level block.
+    unsigned parent_;
+    /// Time in microseconds.
+    unsigned time_;
+    /// Calls.
+    unsigned count_;
+};
+
+/// Captured frame.
+struct CapturedFrame
+{
+    /// Frame number.
+    unsigned frameNumber_;
+    /// Frame time in microseconds.
+    unsigned frameTime_;
+    /// Events sent.
+    unsigned numEvents_;
+    /// Heap allocations.
+    unsigned numAllocations_;
+    /// Blocks.
+    PODVector<CapturedBlock> blocks_;
+};
+
+/// Block statistics over all frames of a capture.
+struct BlockStats
+{
+    /// Construct.
+    BlockStats() :
+        depth_(0),
+        totalTime_(0),
+        maxTime_(0),
+        count_(0)
+    {
+    }
+    
+    /// Block name.
+    String name_;
+    /// Nesting depth.
+    unsigned depth_;
+    /// Total time in microseconds.
+    unsigned long long totalTime_;
+    /// Maximum time during a frame in microseconds.
+    unsigned maxTime_;
+    /// Total calls.
+    unsigned count_;
+};
+
+/// Loaded frame capture.
+struct FrameCapture
+{
+    /// Block names.
+    Vector<String> names_;
+    /// Frames, oldest first.
+    Vector<CapturedFrame> frames_;
+    /// Block paths in the order of first appearance.
+    Vector<String> paths_;
+    /// Block statistics by path.
+    HashMap<String, BlockStats> stats_;
+};
+
+SharedPtr<Context> context_(new Context());
+SharedPtr<FileSystem> fileSystem_(new FileSystem(context_));
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void LoadCapture(const String& fileName, FrameCapture& capture);
+void PrintSummary(const FrameCapture& capture);
+void PrintDiff(const FrameCapture& base, const FrameCapture& compare);
+float GetAverageFrameTime(const FrameCapture& capture);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 1 || arguments.Size() > 2)
+    {
+        ErrorExit(
+            "Usage: ProfileAnalyzer <capture file> [capture file to compare]\n\n"
+            "Prints a summary of a frame capture saved by the profiler. If a second capture is given, prints the\n"
+            "differences of the average block times per frame between them instead."
+        );
+    }
+    
+    FrameCapture base;
+    LoadCapture(arguments[0], base);
+    
+    if (arguments.Size() == 1)
+        PrintSummary(base);
+    else
+    {
+        FrameCapture compare;
+        LoadCapture(arguments[1], compare);
+        PrintDiff(base, compare);
+    }
+}
+
+void LoadCapture(const String& fileName, FrameCapture& capture)
+{
+    File file(context_);
+    if (!file.Open(fileName))
+        ErrorExit("Could not open frame capture " + fileName);
+    if (file.ReadFileID() != "UFRC")
+        ErrorExit(fileName + " is not a frame capture");
+    if (file.ReadUInt() != FRAME_CAPTURE_VERSION)
+        ErrorExit("Unsupported frame capture version in " + fileName);
+    
+    unsigned numNames = file.ReadVLE();
+    for (unsigned i = 0; i < numNames; ++i)
+        capture.names_.Push(file.ReadString());
+    
+    unsigned numFrames = file.ReadVLE();
+    capture.frames_.Resize(numFrames);
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        CapturedFrame& frame = capture.frames_[i];
+        frame.frameNumber_ = file.ReadUInt();
+        frame.frameTime_ = file.ReadUInt();
+        frame.numEvents_ = file.ReadUInt();
+        frame.numAllocations_ = file.ReadUInt();
+        frame.blocks_.Resize(file.ReadVLE());
+        
+        // Identify the blocks by their path from the root, as the same name can appear in several places of the tree
+        Vector<String> framePaths(frame.blocks_.Size());
+        for (unsigned j = 0; j < frame.blocks_.Size(); ++j)
+        {
+            CapturedBlock& block = frame.blocks_[j];
+            block.name_ = file.ReadVLE();
+            block.parent_ = file.ReadVLE();
+            block.time_ = file.ReadVLE();
+            block.count_ = file.ReadVLE();
+            if (block.name_ >= capture.names_.Size() || block.parent_ > j)
+                ErrorExit("Corrupt frame capture " + fileName);
+            
+            const String& name = capture.names_[block.name_];
+            framePaths[j] = block.parent_ ? framePaths[block.parent_ - 1] + "/" + name : name;
+            
+            HashMap<String, BlockStats>::Iterator k = capture.stats_.Find(framePaths[j]);
+            if (k == capture.stats_.End())
+            {
+                k = capture.stats_.Insert(MakePair(framePaths[j], BlockStats()));
+                k->second_.name_ = name;
+                k->second_.depth_ = block.parent_ ? capture.stats_[framePaths[block.parent_ - 1]].depth_ + 1 : 0;
+                capture.paths_.Push(framePaths[j]);
+            }
+            
+            BlockStats& stats = k->second_;
+            stats.totalTime_ += block.time_;
+            stats.maxTime_ = Max((int)stats.maxTime_, (int)block.time_);
+            stats.count_ += block.count_;
+        }
+    }
+    
+    if (capture.frames_.Empty())
+        ErrorExit("No frames in frame capture " + fileName);
+}
+
+void PrintSummary(const FrameCapture& capture)
+{
+    const Vector<CapturedFrame>& frames = capture.frames_;
+    unsigned numFrames = frames.Size();
+    unsigned minTime = M_MAX_UNSIGNED;
+    unsigned maxTime = 0;
+    unsigned worstFrame = 0;
+    unsigned long long totalEvents = 0;
+    unsigned long long totalAllocations = 0;
+    unsigned maxEvents = 0;
+    unsigned maxAllocations = 0;
+    
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        const CapturedFrame& frame = frames[i];
+        if (frame.frameTime_ < minTime)
+            minTime = frame.frameTime_;
+        if (frame.frameTime_ >= maxTime)
+        {
+            maxTime = frame.frameTime_;
+            worstFrame = frame.frameNumber_;
+        }
+        totalEvents += frame.numEvents_;
+        totalAllocations += frame.numAllocations_;
+        maxEvents = Max((int)maxEvents, (int)frame.numEvents_);
+        maxAllocations = Max((int)maxAllocations, (int)frame.numAllocations_);
+    }
+    
+    char line[256];
+    sprintf(line, "Frames %u - %u (%u frames)\n", frames.Front().frameNumber_, frames.Back().frameNumber_, numFrames);
+    PrintLine(line);
+    sprintf(line, "Frame time ms: avg %.3f min %.3f max %.3f (frame %u)", GetAverageFrameTime(capture) / 1000.0f, minTime / 1000.0f,
+        maxTime / 1000.0f, worstFrame);
+    PrintLine(line);
+    sprintf(line, "Events per frame: avg %.1f max %u", (float)totalEvents / numFrames, maxEvents);
+    PrintLine(line);
+    sprintf(line, "Allocations per frame: avg %.1f max %u\n", (float)totalAllocations / numFrames, maxAllocations);
+    PrintLine(line);
+    
+    PrintLine("Block                              Cnt/frame   Avg/frame    Max/frame");
+    for (unsigned i = 0; i < capture.paths_.Size(); ++i)
+    {
+        const BlockStats& stats = capture.stats_.Find(capture.paths_[i])->second_;
+        String name = String(' ', stats.depth_) + stats.name_;
+        sprintf(line, "%-32s %11.1f %11.3f %12.3f", name.Substring(0, 32).CString(), (float)stats.count_ / numFrames,
+            stats.totalTime_ / 1000.0f / numFrames, stats.maxTime_ / 1000.0f);
+        PrintLine(line);
+    }
+}
+
+void PrintDiff(const FrameCapture& base, const FrameCapture& compare)
+{
+    char line[256];
+    float baseFrameTime = GetAverageFrameTime(base);
+    float compareFrameTime = GetAverageFrameTime(compare);
+    sprintf(line, "Frame time ms: avg %.3f -> %.3f (%+.3f)\n", baseFrameTime / 1000.0f, compareFrameTime / 1000.0f,
+        (compareFrameTime - baseFrameTime) / 1000.0f);
+    PrintLine(line);
+    
+    // List the blocks of the base capture in tree order, followed by blocks that only exist in the compared capture
+    Vector<String> paths = base.paths_;
+    for (unsigned i = 0; i < compare.paths_.Size(); ++i)
+    {
+        if (!base.stats_.Contains(compare.paths_[i]))
+            paths.Push(compare.paths_[i]);
+    }
+    
+    PrintLine("Block                               Avg/frame   Avg/frame      Change   Change %");
+    for (unsigned i = 0; i < paths.Size(); ++i)
+    {
+        HashMap<String, BlockStats>::ConstIterator j = base.stats_.Find(paths[i]);
+        HashMap<String, BlockStats>::ConstIterator k = compare.stats_.Find(paths[i]);
+        const BlockStats& stats = j != base.stats_.End() ? j->second_ : k->second_;
+        float baseTime = j != base.stats_.End() ? j->second_.totalTime_ / 1000.0f / base.frames_.Size() : 0.0f;
+        float compareTime = k != compare.stats_.End() ? k->second_.totalTime_ / 1000.0f / compare.frames_.Size() : 0.0f;
+        
+        String name = String(' ', stats.depth_) + stats.name_;
+        if (baseTime > 0.0f)
+        {
+            sprintf(line, "%-32s %11.3f %11.3f %+11.3f %+9.1f%%", name.Substring(0, 32).CString(), baseTime, compareTime,
+                compareTime - baseTime, (compareTime - baseTime) * 100.0f / baseTime);
+        }
+        else
+        {
+            sprintf(line, "%-32s %11.3f %11.3f %+11.3f", name.Substring(0, 32).CString(), baseTime, compareTime,
+                compareTime - baseTime);
+        }
+        PrintLine(line);
+    }
+}
+
+float GetAverageFrameTime(const FrameCapture& capture)
+{
+    unsigned long long totalTime = 0;
+    for (unsigned i = 0; i < capture.frames_.Size(); ++i)
+        totalTime += capture.frames_[i].frameTime_;
+    
+    return (float)totalTime / capture.frames_.Size();
+}